@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Open many concurrent TCP API clients against a running meshtasticd (native build) and check every one of them
+completes the config handshake, even while one deliberately slow client never reads its socket.
+
+Usage: bin/api-load-test.py [--host localhost] [--port 4403] [--clients 50] [--timeout 60]
+
+Only the standard library is used, so this can run on a bare CI runner next to .pio/build/native/program.
+"""
+
+import argparse
+import socket
+import sys
+import threading
+import time
+
+START1 = 0x94
+START2 = 0xC3
+TORADIO_WANT_CONFIG_ID = 3
+FROMRADIO_CONFIG_COMPLETE_ID = 7
+
+
+def encode_varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def decode_varint(buf, pos):
+    result = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return result, pos
+        shift += 7
+
+
+def want_config_frame(nonce):
+    payload = encode_varint(TORADIO_WANT_CONFIG_ID << 3) + encode_varint(nonce)
+    return bytes([START1, START2, len(payload) >> 8, len(payload) & 0xFF]) + payload
+
+
+def config_complete_id(payload):
+    """Return the config_complete_id carried by a FromRadio, or None if it is some other variant"""
+    pos = 0
+    while pos < len(payload):
+        key, pos = decode_varint(payload, pos)
+        field, wire_type = key >> 3, key & 7
+        if wire_type == 0:
+            value, pos = decode_varint(payload, pos)
+            if field == FROMRADIO_CONFIG_COMPLETE_ID:
+                return value
+        elif wire_type == 2:
+            length, pos = decode_varint(payload, pos)
+            pos += length
+        elif wire_type == 5:
+            pos += 4
+        elif wire_type == 1:
+            pos += 8
+        else:
+            return None
+    return None
+
+
+def read_frames(sock, deadline):
+    """Yield FromRadio payloads until the deadline passes"""
+    buf = bytearray()
+    while time.monotonic() < deadline:
+        sock.settimeout(max(0.1, deadline - time.monotonic()))
+        try:
+            chunk = sock.recv(4096)
+        except socket.timeout:
+            return
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            # Resync on the framing bytes, the device may interleave plain text debug output
+            while len(buf) >= 2 and not (buf[0] == START1 and buf[1] == START2):
+                del buf[0]
+            if len(buf) < 4:
+                break
+            length = (buf[2] << 8) | buf[3]
+            if len(buf) < 4 + length:
+                break
+            payload = bytes(buf[4 : 4 + length])
+            del buf[: 4 + length]
+            yield payload
+
+
+def run_client(index, args, results):
+    nonce = 1000 + index
+    started = time.monotonic()
+    deadline = started + args.timeout
+    try:
+        with socket.create_connection((args.host, args.port), timeout=args.timeout) as sock:
+            sock.sendall(want_config_frame(nonce))
+            frames = 0
+            for payload in read_frames(sock, deadline):
+                frames += 1
+                if config_complete_id(payload) == nonce:
+                    results[index] = (True, time.monotonic() - started, frames)
+                    return
+            results[index] = (False, time.monotonic() - started, frames)
+    except OSError as e:
+        results[index] = (False, time.monotonic() - started, str(e))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=4403)
+    parser.add_argument("--clients", type=int, default=50)
+    parser.add_argument("--timeout", type=float, default=60.0)
+    args = parser.parse_args()
+
+    # A client that asks for the config but never reads, it must not hold back anybody else
+    slow = socket.create_connection((args.host, args.port), timeout=args.timeout)
+    slow.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1024)
+    slow.sendall(want_config_frame(1))
+
+    results = [None] * args.clients
+    threads = [threading.Thread(target=run_client, args=(i, args, results)) for i in range(args.clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    slow.close()
+
+    failed = [i for i, r in enumerate(results) if not r or not r[0]]
+    times = sorted(r[1] for r in results if r and r[0])
+    if times:
+        print(
+            f"{len(times)}/{args.clients} clients configured, "
+            f"median {times[len(times) // 2]:.2f}s, max {times[-1]:.2f}s"
+        )
+    for i in failed:
+        print(f"client {i} failed: {results[i]}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
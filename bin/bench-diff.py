@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Compare the JSON benchmark lines printed by the native benchmark suites (printBenchResult() in test/TestUtil.cpp)
+between two runs and flag regressions.
+
+Usage:
+    pio test -e native -f test_bench_packet_path > new.log
+    bin/bench-diff.py old.log new.log [--threshold 10]
+
+Any line of either file that parses as a JSON object with "bench" and "ns_per_op" keys is used, everything else in the
+logs is ignored. Exits non zero if any case got slower by more than the threshold (in percent).
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            start = line.find('{"bench"')
+            if start < 0:
+                continue
+            try:
+                row = json.loads(line[start:])
+            except ValueError:
+                continue
+            if "ns_per_op" not in row:
+                continue
+            key = (row["bench"], row.get("impl", ""), row.get("param", row.get("size", 0)))
+            results[key] = row["ns_per_op"]
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=10.0, help="percent slowdown that counts as a regression")
+    args = parser.parse_args()
+
+    old, new = load(args.old), load(args.new)
+    regressions = 0
+    print(f"{'bench':<32} {'param':>8} {'old ns':>10} {'new ns':>10} {'change':>8}")
+    for key in sorted(set(old) | set(new), key=str):
+        name = key[0] + (f"/{key[1]}" if key[1] else "")
+        if key not in old or key not in new:
+            print(f"{name:<32} {key[2]:>8} {old.get(key, '-'):>10} {new.get(key, '-'):>10} {'n/a':>8}")
+            continue
+        change = (new[key] - old[key]) * 100.0 / old[key] if old[key] else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:<32} {key[2]:>8} {old[key]:>10} {new[key]:>10} {change:>+7.1f}%{flag}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
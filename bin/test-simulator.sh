@@ -9,3 +9,6 @@ sleep 20 # 5 seconds was not enough
 echo "Simulator started, launching python test..."
 python3 -c 'from meshtastic.test import testSimulator; testSimulator()'
 
+
+echo "Checking the API server with 50 concurrent clients..."
+python3 bin/api-load-test.py --clients 50
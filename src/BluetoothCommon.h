@@ -11,6 +11,8 @@
 #define TORADIO_UUID "f75c76d2-129e-4dad-a1dd-7866124401e7"
 #define FROMRADIO_UUID "2c55e69e-4993-11ed-b878-0242ac120002"
 #define FROMNUM_UUID "ed9da18c-a800-4f66-a670-aa7547e34453"
+// Like FROMRADIO but each read carries as many length prefixed frames as fit in the MTU, see FromRadioBatcher
+#define FROMRADIO_BATCH_UUID "9425f636-8f92-4997-b6e8-96bfd9e0798d"
 #define LEGACY_LOGRADIO_UUID "6c6fd238-78fa-436b-aacf-15c5be1ef2e2"
 #define LOGRADIO_UUID "5a3d6e49-06e6-4423-9944-e9de8cdf9547"
 
@@ -711,16 +711,16 @@ void Power::readPowerStatus()
     if (lastheap != memGet.getFreeHeap()) {
         std::string threadlist = "Threads running:";
         int running = 0;
-        for (int i = 0; i < MAX_THREADS; i++) {
-            auto thread = concurrency::mainController.get(i);
-            if ((thread != nullptr) && (thread->enabled)) {
+        for (auto thread = concurrency::OSThread::getFirst(); thread; thread = thread->getNext()) {
+            if (thread->enabled) {
                 threadlist += vformat(" %s", thread->ThreadName.c_str());
                 running++;
             }
         }
         LOG_DEBUG(threadlist.c_str());
         LOG_DEBUG("Heap status: %d/%d bytes free (%d), running %d/%d threads", memGet.getFreeHeap(), memGet.getHeapSize(),
-                  memGet.getFreeHeap() - lastheap, running, concurrency::mainController.size(false));
+                  memGet.getFreeHeap() - lastheap, running, concurrency::mainController.size());
+        logPacketPoolStats();
         lastheap = memGet.getFreeHeap();
     }
 #ifdef DEBUG_HEAP_MQTT
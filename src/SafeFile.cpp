@@ -1,4 +1,7 @@
 #include "SafeFile.h"
+#include "meshUtils.h"
+#include <algorithm>
+#include <string.h>
 
 #ifdef FSCom
 
@@ -24,27 +27,40 @@ SafeFile::SafeFile(const char *_filename, bool fullAtomic)
 
 size_t SafeFile::write(uint8_t ch)
 {
-    if (!f)
-        return 0;
-
-    hash ^= ch;
-    return f.write(ch);
+    return write(&ch, 1);
 }
 
 size_t SafeFile::write(const uint8_t *buffer, size_t size)
 {
-    if (!f)
+    if (!f || writeFailed)
         return 0;
 
-    for (size_t i = 0; i < size; i++) {
-        hash ^= buffer[i];
+    for (size_t left = size; left;) {
+        size_t n = std::min(left, SAFEFILE_BLOCK_SIZE - blockLen);
+        memcpy(block + blockLen, buffer, n);
+        blockLen += n;
+        buffer += n;
+        left -= n;
+        if (blockLen == SAFEFILE_BLOCK_SIZE && !flushBlock())
+            return 0;
+    }
+    return size;
+}
+
+bool SafeFile::flushBlock()
+{
+    crc = crc32(block, blockLen, crc);
+    // This nasty cast is _IMPORTANT_ otherwise the correct adafruit method does not get used (they made a mistake in their typing)
+    if (f.write((uint8_t const *)block, blockLen) != blockLen) {
+        LOG_ERROR("Can't write %s", filename.c_str());
+        writeFailed = true;
     }
-    return f.write((uint8_t const *)buffer, size); // This nasty cast is _IMPORTANT_ otherwise the correct adafruit method does
-                                                   // not get used (they made a mistake in their typing)
+    blockLen = 0;
+    return !writeFailed;
 }
 
 /**
- * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+ * Atomically close the file (deleting any old versions) and readback the contents to confirm the CRC matches
  *
  * @return false for failure
  */
@@ -53,8 +69,10 @@ bool SafeFile::close()
     if (!f)
         return false;
 
+    if (blockLen)
+        flushBlock();
     f.close();
-    if (!testReadback())
+    if (writeFailed || !testReadback())
         return false;
 
     // brief window of risk here ;-)
@@ -73,7 +91,7 @@ bool SafeFile::close()
     return true;
 }
 
-/// Read our (closed) tempfile back in and compare the hash
+/// Read our (closed) tempfile back in and compare the CRC
 bool SafeFile::testReadback()
 {
     bool lfs_failed = lfs_assert_failed;
@@ -87,15 +105,16 @@ bool SafeFile::testReadback()
         return false;
     }
 
-    int c = 0;
-    uint8_t test_hash = 0;
-    while ((c = f2.read()) >= 0) {
-        test_hash ^= (uint8_t)c;
+    // The write side is done with block, so read back through it
+    uint32_t test_crc = 0;
+    int n;
+    while ((n = f2.read(block, sizeof(block))) > 0) {
+        test_crc = crc32(block, n, test_crc);
     }
     f2.close();
 
-    if (test_hash != hash) {
-        LOG_ERROR("Readback failed hash mismatch");
+    if (test_crc != crc) {
+        LOG_ERROR("Readback failed CRC mismatch");
         return false;
     }
 
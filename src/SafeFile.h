@@ -5,6 +5,12 @@
 
 #ifdef FSCom
 
+// Writes are collected into blocks of this size before they go to the filesystem, and readback reads this much at a time.
+// Every filesystem call is expensive on LittleFS, while nanopb hands us a few bytes at a time.
+#ifndef SAFEFILE_BLOCK_SIZE
+#define SAFEFILE_BLOCK_SIZE 256
+#endif
+
 /**
  * This class provides 'safe'/paranoid file writing.
  *
@@ -12,12 +18,12 @@
  * be very careful about how we write files.  This class provides a restricted (Stream only) writing API for writing to files.
  *
  * Notably:
- * - we keep a simple xor hash of all characters that were written.
- * - We do not allow seeking (because we want to maintain our hash)
+ * - we keep a CRC32 of all characters that were written.
+ * - We do not allow seeking (because we want to maintain our CRC)
  * - we provide an close() method which is similar to close but returns false if we were unable to successfully write the
  * file.  Also this method
  * - atomically replaces any old version of the file on the disk with our new file (after first rereading the file from the disk
- * to confirm the hash matches)
+ * to confirm the CRC matches)
  * - Some files are super huge so we can't do the full atomic rename/copy (because of filesystem size limits).  If !fullAtomic
  * then we still do the readback to verify file is valid so higher level code can handle failures.
  */
@@ -30,20 +36,28 @@ class SafeFile : public Print
     virtual size_t write(const uint8_t *buffer, size_t size);
 
     /**
-     * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+     * Atomically close the file (deleting any old versions) and readback the contents to confirm the CRC matches
      *
      * @return false for failure
      */
     bool close();
 
   private:
-    /// Read our (closed) tempfile back in and compare the hash
+    /// Write out the partly filled block
+    bool flushBlock();
+
+    /// Read our (closed) tempfile back in and compare the CRC
     bool testReadback();
 
     String filename;
     File f;
     bool fullAtomic;
-    uint8_t hash = 0;
+    bool writeFailed = false;
+    uint32_t crc = 0;
+
+    /// Written but not yet handed to the filesystem, word aligned because some flash drivers copy faster that way
+    alignas(4) uint8_t block[SAFEFILE_BLOCK_SIZE];
+    size_t blockLen = 0;
 };
 
 #endif
\ No newline at end of file
@@ -33,6 +33,9 @@ class SerialConsole : public StreamAPI, public RedirectablePrint, private concur
 
     void flush();
 
+    /// Send packets for the client right away rather than at our next poll for rx
+    virtual void onNowHasData(uint32_t fromRadioNum) override { setIntervalFromNow(0); }
+
   protected:
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override;
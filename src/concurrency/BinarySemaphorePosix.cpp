@@ -3,25 +3,64 @@
 
 #ifndef HAS_FREE_RTOS
 
+#ifdef ARCH_PORTDUINO
+#include <condition_variable>
+#include <mutex>
+#endif
+
 namespace concurrency
 {
 
+#ifdef ARCH_PORTDUINO
+struct BinarySemaphorePosix::Waiter {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool given = false;
+};
+
+BinarySemaphorePosix::BinarySemaphorePosix() : waiter(new Waiter()) {}
+#else
 BinarySemaphorePosix::BinarySemaphorePosix() {}
+#endif
 
-BinarySemaphorePosix::~BinarySemaphorePosix() {}
+BinarySemaphorePosix::~BinarySemaphorePosix()
+{
+#ifdef ARCH_PORTDUINO
+    delete waiter;
+#endif
+}
 
 /**
  * Returns false if we timed out
  */
 bool BinarySemaphorePosix::take(uint32_t msec)
 {
+#ifdef ARCH_PORTDUINO
+    std::unique_lock<std::mutex> lock(waiter->mutex);
+    bool r = waiter->cond.wait_for(lock, std::chrono::milliseconds(msec), [this] { return waiter->given; });
+    waiter->given = false;
+    return r;
+#else
     delay(msec); // FIXME
     return false;
+#endif
 }
 
-void BinarySemaphorePosix::give() {}
+void BinarySemaphorePosix::give()
+{
+#ifdef ARCH_PORTDUINO
+    {
+        std::lock_guard<std::mutex> guard(waiter->mutex);
+        waiter->given = true;
+    }
+    waiter->cond.notify_one();
+#endif
+}
 
-IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken) {}
+IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    give();
+}
 
 } // namespace concurrency
 
@@ -9,7 +9,9 @@ namespace concurrency
 
 class BinarySemaphorePosix
 {
-    // SemaphoreHandle_t semaphore;
+    // Only on native builds, where interrupts and other OS threads wake the main loop, elsewhere take() is just a delay
+    struct Waiter;
+    Waiter *waiter = NULL;
 
   public:
     BinarySemaphorePosix();
@@ -0,0 +1,157 @@
+#include "concurrency/DeadlineController.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+namespace concurrency
+{
+
+bool DeadlineController::isBefore(const OSThread *a, const OSThread *b)
+{
+    return (long)(a->queuedDeadline - b->queuedDeadline) < 0;
+}
+
+bool DeadlineController::add(OSThread *t)
+{
+    if (numThreads >= MAX_THREADS)
+        return false;
+    numThreads++;
+    push(t);
+    return true;
+}
+
+void DeadlineController::remove(OSThread *t)
+{
+    for (uint8_t i = 0; i < numQueued; i++) {
+        if (queue[i] == t) {
+            queue[i] = queue[--numQueued];
+            if (i < numQueued) {
+                siftUp(i);
+                siftDown(i);
+            }
+            numThreads--;
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < numParked; i++) {
+        if (parked[i] == t) {
+            parked[i] = parked[--numParked];
+            numThreads--;
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < numDue; i++) {
+        if (due[i] == t) {
+            due[i] = NULL;
+            numThreads--;
+            return;
+        }
+    }
+}
+
+void DeadlineController::push(OSThread *t)
+{
+    t->queuedDeadline = t->getNextRunAt();
+    queue[numQueued] = t;
+    siftUp(numQueued++);
+}
+
+OSThread *DeadlineController::popFirst()
+{
+    OSThread *t = queue[0];
+    queue[0] = queue[--numQueued];
+    siftDown(0);
+    return t;
+}
+
+void DeadlineController::siftUp(uint8_t i)
+{
+    while (i > 0) {
+        uint8_t parent = (i - 1) / 2;
+        if (!isBefore(queue[i], queue[parent]))
+            break;
+        OSThread *t = queue[i];
+        queue[i] = queue[parent];
+        queue[parent] = t;
+        i = parent;
+    }
+}
+
+void DeadlineController::siftDown(uint8_t i)
+{
+    while (true) {
+        uint8_t first = i, left = 2 * i + 1, right = left + 1;
+        if (left < numQueued && isBefore(queue[left], queue[first]))
+            first = left;
+        if (right < numQueued && isBefore(queue[right], queue[first]))
+            first = right;
+        if (first == i)
+            break;
+        OSThread *t = queue[i];
+        queue[i] = queue[first];
+        queue[first] = t;
+        i = first;
+    }
+}
+
+void DeadlineController::reorder()
+{
+    // Clear the flag first, so a reschedule that lands while we are at it is picked up next time
+    needsReorder = false;
+    for (uint8_t i = 0; i < numQueued; i++)
+        queue[i]->queuedDeadline = queue[i]->getNextRunAt();
+    for (int i = numQueued / 2 - 1; i >= 0; i--)
+        siftDown(i);
+}
+
+void DeadlineController::unpark()
+{
+    for (uint8_t i = 0; i < numParked;) {
+        OSThread *t = parked[i];
+        if (t->enabled) {
+            parked[i] = parked[--numParked];
+            push(t);
+        } else {
+            i++;
+        }
+    }
+}
+
+long DeadlineController::runOrDelay()
+{
+    if (needsReorder)
+        reorder();
+    unpark();
+
+    // Take everything that is due off the queue before running any of it, so a thread that asks to run again right away (or
+    // wakes another one) waits for the next pass, like every thread got one turn per pass with ThreadController
+    unsigned long now = millis();
+    while (numQueued && (long)(queue[0]->queuedDeadline - now) <= 0)
+        due[numDue++] = popFirst();
+
+    for (uint8_t i = 0; i < numDue; i++) {
+        if (due[i] && due[i]->shouldRun(now))
+            due[i]->run();
+
+        // Checked again, the thread may have been deleted by its own or an earlier runOnce()
+        OSThread *t = due[i];
+        if (!t)
+            continue;
+        due[i] = NULL;
+        if (t->enabled)
+            push(t);
+        else
+            parked[numParked++] = t;
+    }
+    numDue = 0;
+
+    // Pick up whatever the threads we just ran did to the others
+    if (needsReorder)
+        reorder();
+    unpark();
+    if (!numQueued)
+        return INT32_MAX;
+    long delayMsec = (long)(queue[0]->queuedDeadline - millis());
+    return delayMsec > 0 ? delayMsec : 0;
+}
+
+} // namespace concurrency
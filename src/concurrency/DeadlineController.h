@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Most OSThreads one controller can hold, boards with lots of peripherals raise it from platformio.ini
+#ifndef MAX_THREADS
+#define MAX_THREADS 32
+#endif
+
+namespace concurrency
+{
+
+class OSThread;
+
+/**
+ * Runs OSThreads when they are due, keeping them in a min-heap ordered by the time each one next wants to run.
+ *
+ * This replaces the ArduinoThread ThreadController, which asked every thread whether it should run on every pass through
+ * loop(). Here a pass only looks at the threads that are actually due, and the time until the head of the queue is exactly how
+ * long loop() may sleep.
+ *
+ * Threads don't need to do anything special to use it: OSThread::setInterval() and setIntervalFromNow() (including the
+ * setInterval(0) done by notify(), TypedQueue readers and ISRs) call reschedule(), which only sets a flag, so it is safe from
+ * interrupts and other tasks. The queue is put back in order at the start of the next pass.
+ *
+ * Disabled threads are parked once they come due and only go back in the queue when someone enables them again, so they
+ * don't cost a wakeup each.
+ */
+class DeadlineController
+{
+  public:
+    /// @return false if the controller is full
+    bool add(OSThread *t);
+
+    void remove(OSThread *t);
+
+    /// Some thread's next run time changed, may be called from an ISR
+    void reschedule() { needsReorder = true; }
+
+    /**
+     * Run every thread that is due, at most once each.
+     * @return how many msecs until the next thread is due
+     */
+    long runOrDelay();
+
+    /// How many threads we hold, enabled or not
+    int size() const { return numThreads; }
+
+  private:
+    /// Ordered by OSThread::queuedDeadline, soonest first
+    OSThread *queue[MAX_THREADS] = {};
+    uint8_t numQueued = 0;
+
+    /// Disabled threads, waiting for someone to enable them again
+    OSThread *parked[MAX_THREADS] = {};
+    uint8_t numParked = 0;
+
+    /// The threads runOrDelay() took off the queue and is running now, an entry is NULLed if that thread is removed meanwhile
+    OSThread *due[MAX_THREADS] = {};
+    uint8_t numDue = 0;
+
+    uint8_t numThreads = 0;
+
+    volatile bool needsReorder = false;
+
+    /// a is due before b, allowing for millis() wrapping
+    static bool isBefore(const OSThread *a, const OSThread *b);
+
+    void push(OSThread *t);
+    OSThread *popFirst();
+    void siftUp(uint8_t i);
+    void siftDown(uint8_t i);
+
+    /// Reload every queued thread's deadline and rebuild the heap
+    void reorder();
+
+    /// Move parked threads that have been enabled back into the queue
+    void unpark();
+};
+
+} // namespace concurrency
@@ -17,11 +17,31 @@ bool InterruptableDelay::delay(uint32_t msec)
 
     // sem take will return false if we timed out (i.e. were not interrupted)
     bool r = semaphore.take(msec);
+    if (msec == 0)
+        return !r; // never slept, so not a wakeup
+
+    uint32_t now = millis();
+    if (now - hourStartMsec >= 60 * 60 * 1000UL) {
+        LOG_INFO("Woke %u times in the last hour", wakeupsThisHour);
+        wakeupsLastHour = wakeupsThisHour;
+        wakeupsThisHour = 0;
+        hourStartMsec = now;
+        haveFullHour = true;
+    }
+    wakeupsThisHour++;
 
     // LOG_DEBUG("interrupt=%d", r);
     return !r;
 }
 
+uint32_t InterruptableDelay::getWakeupsPerHour() const
+{
+    if (haveFullHour)
+        return wakeupsLastHour;
+    uint32_t elapsed = millis() - hourStartMsec;
+    return elapsed ? (uint64_t)wakeupsThisHour * 60 * 60 * 1000 / elapsed : 0;
+}
+
 void InterruptableDelay::interrupt()
 {
     semaphore.give();
@@ -24,6 +24,11 @@ class InterruptableDelay
 {
     BinarySemaphore semaphore;
 
+    // Every return from delay() is one wakeup, counted per hour of uptime
+    uint32_t wakeupsThisHour = 0, wakeupsLastHour = 0;
+    uint32_t hourStartMsec = 0;
+    bool haveFullHour = false;
+
   public:
     InterruptableDelay();
     ~InterruptableDelay();
@@ -36,6 +41,9 @@ class InterruptableDelay
     void interrupt();
 
     void interruptFromISR(BaseType_t *pxHigherPriorityTaskWoken);
+
+    /// Wakeups during the last full hour, or so far this hour scaled up to a whole one if we haven't been up that long
+    uint32_t getWakeupsPerHour() const;
 };
 
 } // namespace concurrency
\ No newline at end of file
@@ -17,21 +17,23 @@ bool OSThread::showWaiting = false;
 
 const OSThread *OSThread::currentThread;
 
-ThreadController mainController, timerController;
+OSThread *OSThread::first;
+
+DeadlineController mainController, timerController;
 InterruptableDelay mainDelay;
 
-void OSThread::setup()
-{
-    mainController.ThreadName = "mainController";
-    timerController.ThreadName = "timerController";
-}
+void OSThread::setup() {}
 
-OSThread::OSThread(const char *_name, uint32_t period, ThreadController *_controller)
+OSThread::OSThread(const char *_name, uint32_t period, DeadlineController *_controller)
     : Thread(NULL, period), controller(_controller)
 {
     assertIsSetup();
 
     ThreadName = _name;
+    intervalSetAt = millis();
+
+    next = first;
+    first = this;
 
     if (controller) {
         bool added = controller->add(this);
@@ -43,6 +45,13 @@ OSThread::~OSThread()
 {
     if (controller)
         controller->remove(this);
+
+    for (OSThread **p = &first; *p; p = &(*p)->next) {
+        if (*p == this) {
+            *p = next;
+            break;
+        }
+    }
 }
 
 /**
@@ -54,7 +63,21 @@ void OSThread::setIntervalFromNow(unsigned long _interval)
     interval = _interval;
 
     // Cache the next run based on the last_run
-    _cached_next_run = millis() + interval;
+    intervalSetAt = millis();
+    _cached_next_run = intervalSetAt + interval;
+
+    if (controller && currentThread != this)
+        controller->reschedule();
+}
+
+void OSThread::setInterval(unsigned long _interval)
+{
+    Thread::setInterval(_interval);
+    intervalSetAt = millis();
+
+    // While we are running the controller requeues us afterwards anyway
+    if (controller && currentThread != this)
+        controller->reschedule();
 }
 
 bool OSThread::shouldRun(unsigned long time)
@@ -81,8 +104,23 @@ void OSThread::run()
 #ifdef DEBUG_HEAP
     auto heap = memGet.getFreeHeap();
 #endif
+    // We were due at last_run + interval, unless the interval was changed after that time (i.e. setInterval(0) to run ASAP)
+    unsigned long now = millis();
+    unsigned long due = (long)(intervalSetAt - _cached_next_run) > 0 ? intervalSetAt : _cached_next_run;
+    uint32_t lateMs = (long)(now - due) > 0 ? now - due : 0;
+    uint32_t start = micros();
+
     currentThread = this;
     auto newDelay = runOnce();
+
+    uint32_t elapsedUs = micros() - start;
+    stats.runs++;
+    stats.totalUs += elapsedUs;
+    if (elapsedUs > stats.maxUs)
+        stats.maxUs = elapsedUs;
+    stats.totalLateMs += lateMs;
+    if (lateMs > stats.maxLateMs)
+        stats.maxLateMs = lateMs;
 #ifdef DEBUG_HEAP
     auto newHeap = memGet.getFreeHeap();
     if (newHeap < heap)
@@ -99,6 +137,15 @@ void OSThread::run()
     currentThread = NULL;
 }
 
+void OSThread::logStats()
+{
+    for (const OSThread *t = first; t; t = t->next) {
+        const OSThreadStats &s = t->stats;
+        LOG_DEBUG("Thread %s: runs=%u total=%ums max=%uus late total=%ums max=%ums", t->ThreadName.c_str(), s.runs,
+                  (uint32_t)(s.totalUs / 1000), s.maxUs, (uint32_t)s.totalLateMs, s.maxLateMs);
+    }
+}
+
 int32_t OSThread::disable()
 {
     enabled = false;
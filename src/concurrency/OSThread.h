@@ -4,17 +4,26 @@
 #include <stdint.h>
 
 #include "Thread.h"
-#include "ThreadController.h"
+#include "concurrency/DeadlineController.h"
 #include "concurrency/InterruptableDelay.h"
 
 namespace concurrency
 {
 
-extern ThreadController mainController, timerController;
+extern DeadlineController mainController, timerController;
 extern InterruptableDelay mainDelay;
 
 #define RUN_SAME -1
 
+/// Scheduler accounting for one OSThread, kept for every thread all the time
+struct OSThreadStats {
+    uint32_t runs;
+    uint64_t totalUs;     // time spent in runOnce()
+    uint32_t maxUs;       // longest single runOnce()
+    uint64_t totalLateMs; // sum over all runs of how long after its requested time the run started
+    uint32_t maxLateMs;
+};
+
 /**
  * @brief Base threading
  *
@@ -30,7 +39,12 @@ extern InterruptableDelay mainDelay;
  */
 class OSThread : public Thread
 {
-    ThreadController *controller;
+    friend class DeadlineController;
+
+    DeadlineController *controller;
+
+    /// Our next run time as of when the controller last queued us, it keeps the queue in this order
+    unsigned long queuedDeadline = 0;
 
     /// Show debugging info for disabled threads
     static bool showDisabled;
@@ -41,11 +55,20 @@ class OSThread : public Thread
     /// Show debugging info for threads we decide not to run;
     static bool showWaiting;
 
+    /// All OSThreads that currently exist, linked through next
+    static OSThread *first;
+    OSThread *next = NULL;
+
+    OSThreadStats stats = {};
+
+    /// millis() when our interval was last changed, a run can't be late for a time before that
+    unsigned long intervalSetAt;
+
   public:
     /// For debug printing only (might be null)
     static const OSThread *currentThread;
 
-    OSThread(const char *name, uint32_t period = 0, ThreadController *controller = &mainController);
+    OSThread(const char *name, uint32_t period = 0, DeadlineController *controller = &mainController);
 
     virtual ~OSThread();
 
@@ -60,6 +83,20 @@ class OSThread : public Thread
      */
     void setIntervalFromNow(unsigned long _interval);
 
+    virtual void setInterval(unsigned long _interval);
+
+    /// Iterate over every OSThread: for (OSThread *t = OSThread::getFirst(); t; t = t->getNext())
+    static OSThread *getFirst() { return first; }
+    OSThread *getNext() const { return next; }
+
+    const OSThreadStats &getStats() const { return stats; }
+
+    /// Log the stats of every thread, one line each, which API clients with the debug log enabled get as LogRecords
+    static void logStats();
+
+    /// millis() at which we next want to run (if enabled)
+    unsigned long getNextRunAt() const { return _cached_next_run; }
+
   protected:
     /**
      * The method that will be called each time our thread gets a chance to run
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+namespace concurrency
+{
+
+/**
+ * A fixed size lock-free queue for handing items from exactly one producer thread to exactly one consumer thread.
+ *
+ * This is only useful on native builds, where we run real OS threads (see DecodeWorkerPool), on FreeRTOS use TypedQueue.
+ * Capacity must be a power of two, one slot always stays free so at most Capacity - 1 items fit.
+ */
+template <class T, size_t Capacity> class SPSCQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+    T items[Capacity];
+
+    // Kept on separate cache lines so the two threads don't keep stealing the line from each other
+    alignas(64) std::atomic<size_t> head{0}; // next slot to read, only written by the consumer
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to write, only written by the producer
+
+  public:
+    /// Producer only. @return false if the queue is full
+    bool push(const T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t next = (t + 1) & (Capacity - 1);
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        items[t] = item;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer only. @return false if the queue is empty
+    bool pop(T &item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[h];
+        head.store((h + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+};
+
+} // namespace concurrency
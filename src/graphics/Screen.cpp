@@ -2452,8 +2452,21 @@ void DebugInfo::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state, int16
 
     display->drawString(x + SCREEN_WIDTH - display->getStringWidth(ourId), y + FONT_HEIGHT_SMALL, ourId);
 
+    // Draw the thread that has used the most CPU since boot
+    const concurrency::OSThread *busiest = NULL;
+    for (const concurrency::OSThread *t = concurrency::OSThread::getFirst(); t; t = t->getNext())
+        if (!busiest || t->getStats().totalUs > busiest->getStats().totalUs)
+            busiest = t;
+    if (busiest) {
+        const concurrency::OSThreadStats &stats = busiest->getStats();
+        char threadStr[40];
+        snprintf(threadStr, sizeof(threadStr), "%s %u%% max %ums", busiest->ThreadName.c_str(),
+                 (unsigned)(stats.totalUs / 10 / (millis() + 1)), (unsigned)(stats.maxUs / 1000));
+        display->drawString(x, y + (FONT_HEIGHT_SMALL * 2), threadStr);
+    }
+
     // Draw any log messages
-    display->drawLogBuffer(x, y + (FONT_HEIGHT_SMALL * 2));
+    display->drawLogBuffer(x, y + (FONT_HEIGHT_SMALL * 3));
 
     /* Display a heartbeat pixel that blinks every time the frame is redrawn */
 #ifdef SHOW_REDRAWS
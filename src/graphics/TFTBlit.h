@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Find the columns of one page of the OLED buffer (8 rows, one byte per column) that differ from the back buffer, and call
+ * emit(x0, x1) for each changed run [x0, x1).  Runs separated by at most mergeGap unchanged columns are merged, since
+ * opening a new window on the panel costs more than pushing a few unchanged columns.  Unchanged columns are skipped a word
+ * at a time.
+ */
+template <typename F> void forEachChangedSpan(const uint8_t *cur, const uint8_t *back, uint16_t width, uint16_t mergeGap, F emit)
+{
+    int32_t spanStart = -1;
+    uint16_t spanEnd = 0;
+    uint16_t x = 0;
+    while (x < width) {
+        if (x + sizeof(uint32_t) <= width) {
+            uint32_t a, b;
+            memcpy(&a, cur + x, sizeof(a));
+            memcpy(&b, back + x, sizeof(b));
+            if (a == b) {
+                x += sizeof(uint32_t);
+                continue;
+            }
+        }
+        if (cur[x] != back[x]) {
+            if (spanStart >= 0 && x - spanEnd > mergeGap) {
+                emit(spanStart, spanEnd);
+                spanStart = -1;
+            }
+            if (spanStart < 0)
+                spanStart = x;
+            spanEnd = x + 1;
+        }
+        x++;
+    }
+    if (spanStart >= 0)
+        emit(spanStart, spanEnd);
+}
@@ -18,6 +18,16 @@ extern SX1509 gpioExtender;
 #define TFT_MESH COLOR565(0x67, 0xEA, 0x94)
 #endif
 
+// Unchanged columns between two changed runs of a page that are still pushed as one rectangle, cheaper than a new window
+#ifndef TFT_BLIT_MERGE_GAP
+#define TFT_BLIT_MERGE_GAP 8
+#endif
+
+// How often display() logs its TFTBlitStats
+#ifndef TFT_BLIT_STATS_INTERVAL_MS
+#define TFT_BLIT_STATS_INTERVAL_MS (5 * 60 * 1000)
+#endif
+
 #if defined(ST7735S)
 #include <LovyanGFX.hpp> // Graphics and font library for ST7735 driver chip
 
@@ -642,7 +652,9 @@ static LGFX *tft = nullptr;
 #if defined(ST7701_CS) || defined(ST7735_CS) || defined(ST7789_CS) || defined(ILI9341_DRIVER) || defined(ILI9342_DRIVER) ||      \
     defined(RAK14014) || defined(HX8357_CS) || (ARCH_PORTDUINO && HAS_SCREEN != 0)
 #include "SPILock.h"
+#include "TFTBlit.h"
 #include "TFTDisplay.h"
+#include "Throttle.h"
 #include <SPI.h>
 
 #ifdef UNPHONE
@@ -684,37 +696,72 @@ TFTDisplay::TFTDisplay(uint8_t address, int sda, int scl, OLEDDISPLAY_GEOMETRY g
 #endif
 }
 
+TFTDisplay::~TFTDisplay()
+{
+    delete[] spanBuffer;
+}
+
 // Write the buffer to the display memory
 void TFTDisplay::display(bool fromBlank)
 {
-    if (fromBlank)
-        tft->fillScreen(TFT_BLACK);
-    // tft->clear();
     concurrency::LockGuard g(spiLock);
-
-    uint16_t x, y;
-
-    for (y = 0; y < displayHeight; y++) {
-        for (x = 0; x < displayWidth; x++) {
-            auto isset = buffer[x + (y / 8) * displayWidth] & (1 << (y & 7));
-            if (!fromBlank) {
-                // get src pixel in the page based ordering the OLED lib uses FIXME, super inefficent
-                auto dblbuf_isset = buffer_back[x + (y / 8) * displayWidth] & (1 << (y & 7));
-                if (isset != dblbuf_isset) {
-                    tft->drawPixel(x, y, isset ? TFT_MESH : TFT_BLACK);
-                }
-            } else if (isset) {
-                tft->drawPixel(x, y, TFT_MESH);
-            }
+    uint32_t start = micros();
+
+    if (!spanBuffer)
+        spanBuffer = new uint16_t[displayWidth * 8];
+
+    // The OLED lib keeps pixels in pages of 8 rows, one byte per column. Find the changed columns of each page (skipping
+    // unchanged ones a word at a time), merge runs separated by small gaps and push each run as one rectangle, instead of
+    // one drawPixel() transaction per changed pixel.
+    tft->startWrite();
+    for (uint16_t page = 0; page < (displayHeight + 7) / 8; page++) {
+        if (fromBlank) {
+            blitSpan(page, 0, displayWidth);
+            continue;
         }
+
+        forEachChangedSpan(buffer + page * displayWidth, buffer_back + page * displayWidth, displayWidth, TFT_BLIT_MERGE_GAP,
+                           [&](uint16_t x0, uint16_t x1) { blitSpan(page, x0, x1); });
     }
+    tft->endWrite();
+
     // Copy the Buffer to the Back Buffer
-    for (y = 0; y < (displayHeight / 8); y++) {
-        for (x = 0; x < displayWidth; x++) {
-            uint16_t pos = x + y * displayWidth;
-            buffer_back[pos] = buffer[pos];
-        }
+    memcpy(buffer_back, buffer, displayBufferSize);
+
+    uint32_t elapsed = micros() - start;
+    blitStats.frames++;
+    blitStats.lastFrameUsec = elapsed;
+    blitStats.totalFrameUsec += elapsed;
+    if (elapsed > blitStats.maxFrameUsec)
+        blitStats.maxFrameUsec = elapsed;
+
+    if (!Throttle::isWithinTimespanMs(lastStatsLogMsec, TFT_BLIT_STATS_INTERVAL_MS)) {
+        lastStatsLogMsec = millis();
+        LOG_DEBUG("TFT blit: %u frames, %u rects, avg %u us, max %u us", blitStats.frames, blitStats.rects,
+                  (uint32_t)(blitStats.totalFrameUsec / blitStats.frames), blitStats.maxFrameUsec);
+    }
+}
+
+void TFTDisplay::blitSpan(uint16_t page, uint16_t x0, uint16_t x1)
+{
+    uint16_t w = x1 - x0;
+    uint16_t y0 = page * 8;
+    uint8_t rows = min(8, displayHeight - y0);
+    const uint8_t *src = buffer + page * displayWidth + x0;
+
+    for (uint8_t r = 0; r < rows; r++) {
+        uint16_t *out = spanBuffer + r * w;
+        uint8_t mask = 1 << r;
+        for (uint16_t c = 0; c < w; c++)
+            out[c] = (src[c] & mask) ? TFT_MESH : TFT_BLACK;
     }
+
+#ifdef RAK14014
+    tft->pushImage(x0, y0, w, rows, spanBuffer); // setSwapBytes(true) in connect(), so native RGB565 is fine
+#else
+    tft->pushImage(x0, y0, w, rows, (const lgfx::rgb565_t *)spanBuffer);
+#endif
+    blitStats.rects++;
 }
 
 // Send a command to the display (low level function)
@@ -3,11 +3,19 @@
 #include <GpioLogic.h>
 #include <OLEDDisplay.h>
 
+/** Cost of pushing frames to the panel, logged every TFT_BLIT_STATS_INTERVAL_MS so changes to display() can be measured */
+struct TFTBlitStats {
+    uint32_t frames;         // calls to display()
+    uint32_t rects;          // pushImage() calls, one per changed span of a page
+    uint32_t lastFrameUsec;  // time spent in the last display()
+    uint32_t maxFrameUsec;   // slowest display() so far
+    uint64_t totalFrameUsec; // sum over all frames, divide by frames for the average
+};
+
 /**
  * An adapter class that allows using the LovyanGFX library as if it was an OLEDDisplay implementation.
  *
  * Remaining TODO:
- * optimize display() to only draw changed pixels (see other OLED subclasses for examples)
  * Use the fast NRF52 SPI API rather than the slow standard arduino version
  *
  * turn radio back on - currently with both on spi bus is fucked? or are we leaving chip select asserted?
@@ -19,6 +27,7 @@ class TFTDisplay : public OLEDDisplay
     FIXME - the parameters are not used, just a temporary hack to keep working like the old displays
     */
     TFTDisplay(uint8_t, int, int, OLEDDISPLAY_GEOMETRY, HW_I2C);
+    ~TFTDisplay();
 
     // Write the buffer to the display memory
     virtual void display() override { display(false); };
@@ -57,4 +66,14 @@ class TFTDisplay : public OLEDDisplay
 
     // Connect to the display
     virtual bool connect() override;
+
+  private:
+    /// RGB565 pixels for one 8 row page, pushed to the panel a rectangle at a time
+    uint16_t *spanBuffer = nullptr;
+
+    TFTBlitStats blitStats = {};
+    uint32_t lastStatsLogMsec = 0;
+
+    // Convert columns [x0, x1) of one page of the OLED buffer to RGB565 and push them as a single rectangle
+    void blitSpan(uint16_t page, uint16_t x0, uint16_t x1);
 };
\ No newline at end of file
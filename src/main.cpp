@@ -1171,6 +1171,10 @@ void setup()
         RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_NO_RADIO);
     else {
         router->addInterface(rIf);
+#ifdef ARCH_PORTDUINO
+        if (settingsMap[routerThreads] > 0)
+            router->startDecodeWorkers(settingsMap[routerThreads]);
+#endif
 
         // Log bit rate to debug output
         LOG_DEBUG("LoRA bitrate = %f bytes / sec", (float(meshtastic_Constants_DATA_PAYLOAD_LEN) /
@@ -228,7 +228,7 @@ CryptoKey Channels::getKey(ChannelIndex chIndex)
  */
 int16_t Channels::setCrypto(ChannelIndex chIndex)
 {
-    CryptoKey k = getKey(chIndex);
+    CryptoKey k = (keysValid && chIndex < MAX_NUM_CHANNELS) ? keys[chIndex] : getKey(chIndex);
 
     if (k.length < 0)
         return -1;
@@ -239,8 +239,24 @@ int16_t Channels::setCrypto(ChannelIndex chIndex)
     }
 }
 
+void Channels::rebuildKeyCache()
+{
+    memset(channelsByHash, 0, sizeof(channelsByHash));
+    for (int i = 0; i < MAX_NUM_CHANNELS; i++) {
+        if (i < channelFile.channels_count) {
+            keys[i] = getKey(i);
+            if (hashes[i] >= 0)
+                channelsByHash[hashes[i]] |= 1 << i;
+        } else {
+            keys[i].length = -1;
+        }
+    }
+    keysValid = true;
+}
+
 void Channels::initDefaults()
 {
+    keysValid = false;
     channelFile.channels_count = MAX_NUM_CHANNELS;
     for (int i = 0; i < channelFile.channels_count; i++)
         fixupChannel(i);
@@ -264,6 +280,7 @@ void Channels::onConfigChanged()
         if (ch.role == meshtastic_Channel_Role_PRIMARY)
             primaryIndex = i;
     }
+    rebuildKeyCache();
 #if !MESHTASTIC_EXCLUDE_MQTT
     if (channels.anyMqttEnabled() && mqtt && !mqtt->isEnabled()) {
         LOG_DEBUG("MQTT is enabled on at least one channel, so set MQTT thread to run immediately");
@@ -312,6 +329,7 @@ void Channels::setChannel(const meshtastic_Channel &c)
                 channelFile.channels[i].role = meshtastic_Channel_Role_SECONDARY;
 
     old = c; // slam in the new settings/role
+    keysValid = false; // until onConfigChanged() recomputes them
 }
 
 bool Channels::anyMqttEnabled()
@@ -393,6 +411,14 @@ bool Channels::decryptForHash(ChannelIndex chIndex, ChannelHash channelHash)
     }
 }
 
+bool Channels::getKeyForHash(ChannelIndex chIndex, ChannelHash channelHash, CryptoKey &key)
+{
+    if (chIndex > getNumChannels() || getHash(chIndex) != channelHash)
+        return false;
+    key = (keysValid && chIndex < MAX_NUM_CHANNELS) ? keys[chIndex] : getKey(chIndex);
+    return key.length >= 0;
+}
+
 /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
  *
  * This method is called before encoding outbound packets
@@ -28,6 +28,15 @@ class Channels
     /// the precomputed hashes for each of our channels, or -1 for invalid
     int16_t hashes[MAX_NUM_CHANNELS] = {};
 
+    static_assert(MAX_NUM_CHANNELS <= 8, "channelsByHash needs a wider mask type");
+
+    /// for each possible channel hash, a bitmask of the channel indexes which have that hash.  Rebuilt by onConfigChanged()
+    uint8_t channelsByHash[256] = {};
+
+    /// the expanded key (see getKey()) for each of our channels, only valid if keysValid is set.  Rebuilt by onConfigChanged()
+    CryptoKey keys[MAX_NUM_CHANNELS] = {};
+    bool keysValid = false;
+
   public:
     Channels() {}
 
@@ -75,6 +84,18 @@ class Channels
      */
     bool decryptForHash(ChannelIndex chIndex, ChannelHash channelHash);
 
+    /** Return a bitmask of the channel indexes which might have been used to encrypt a packet with this channel hash, so
+     * callers only need to try decryptForHash() on those.
+     */
+    uint8_t getChannelsForHash(ChannelHash channelHash) const { return channelsByHash[channelHash]; }
+
+    /** Like decryptForHash(), but hands back a copy of the key instead of loading it into the global crypto engine, for code
+     * that decrypts with its own engine.
+     *
+     * @return false if the channel hash or channel is invalid, or the channel has no usable key
+     */
+    bool getKeyForHash(ChannelIndex chIndex, ChannelHash channelHash, CryptoKey &key);
+
     /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
      *
      * This method is called before encoding outbound packets
@@ -111,6 +132,9 @@ class Channels
 
     int16_t getHash(ChannelIndex i) { return hashes[i]; }
 
+    /// Recompute keys and channelsByHash from the current channel settings
+    void rebuildKeyCache();
+
     /**
      * Validate a channel, fixing any errors as needed
      */
@@ -20,6 +20,7 @@ void CryptoEngine::generateKeyPair(uint8_t *pubKey, uint8_t *privKey)
 {
     LOG_DEBUG("Generate Curve25519 keypair");
     Curve25519::dh1(public_key, private_key);
+    clearSharedKeyCache();
     memcpy(pubKey, public_key, sizeof(public_key));
     memcpy(privKey, private_key, sizeof(private_key));
 }
@@ -41,6 +42,7 @@ bool CryptoEngine::regeneratePublicKey(uint8_t *pubKey, uint8_t *privKey)
         }
         memcpy(private_key, privKey, sizeof(private_key));
         memcpy(public_key, pubKey, sizeof(public_key));
+        clearSharedKeyCache();
     } else {
         LOG_WARN("X25519 key generation failed due to blank private key");
         return false;
@@ -52,6 +54,46 @@ void CryptoEngine::clearKeys()
 {
     memset(public_key, 0, sizeof(public_key));
     memset(private_key, 0, sizeof(private_key));
+    clearSharedKeyCache();
+}
+
+void CryptoEngine::clearSharedKeyCache()
+{
+    memset(sharedKeyCache, 0, sizeof(sharedKeyCache));
+}
+
+void CryptoEngine::forgetSharedKey(const uint8_t *remotePublic)
+{
+    for (auto &e : sharedKeyCache) {
+        if (e.lastUsed && memcmp(e.remotePublic, remotePublic, sizeof(e.remotePublic)) == 0)
+            memset(&e, 0, sizeof(e));
+    }
+}
+
+bool CryptoEngine::loadSharedKey(const uint8_t *remotePublic)
+{
+    SharedKeyCacheEntry *victim = &sharedKeyCache[0];
+    for (auto &e : sharedKeyCache) {
+        if (e.lastUsed && memcmp(e.remotePublic, remotePublic, sizeof(e.remotePublic)) == 0) {
+            e.lastUsed = ++sharedKeyCacheClock;
+            memcpy(shared_key, e.sharedKey, sizeof(shared_key));
+            sharedKeyCacheHits++;
+            return true;
+        }
+        if (e.lastUsed < victim->lastUsed)
+            victim = &e;
+    }
+
+    sharedKeyCacheMisses++;
+    if (!crypto->setDHPublicKey(const_cast<uint8_t *>(remotePublic))) {
+        return false;
+    }
+    crypto->hash(shared_key, 32);
+
+    memcpy(victim->remotePublic, remotePublic, sizeof(victim->remotePublic));
+    memcpy(victim->sharedKey, shared_key, sizeof(victim->sharedKey));
+    victim->lastUsed = ++sharedKeyCacheClock;
+    return true;
 }
 
 /**
@@ -79,10 +121,9 @@ bool CryptoEngine::encryptCurve25519(uint32_t toNode, uint32_t fromNode, meshtas
         LOG_DEBUG("Node %d or their public_key not found", toNode);
         return false;
     }
-    if (!crypto->setDHPublicKey(remotePublic.bytes)) {
+    if (!loadSharedKey(remotePublic.bytes)) {
         return false;
     }
-    crypto->hash(shared_key, 32);
     initNonce(fromNode, packetNum, extraNonceTmp);
 
     // Calculate the shared secret with the destination node and encrypt
@@ -120,11 +161,10 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_publ
         return false;
     }
 
-    // Calculate the shared secret with the sending node and decrypt
-    if (!crypto->setDHPublicKey(remotePublic.bytes)) {
+    // Calculate (or recall) the shared secret with the sending node and decrypt
+    if (!loadSharedKey(remotePublic.bytes)) {
         return false;
     }
-    crypto->hash(shared_key, 32);
 
     initNonce(fromNode, packetNum, extraNonce);
     printBytes("Attempt decrypt with nonce: ", nonce, 13);
@@ -135,6 +175,7 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_publ
 void CryptoEngine::setDHPrivateKey(uint8_t *_private_key)
 {
     memcpy(private_key, _private_key, 32);
+    clearSharedKeyCache();
 }
 
 /**
@@ -225,23 +266,27 @@ void CryptoEngine::decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes
 // Generic implementation of AES-CTR encryption.
 void CryptoEngine::encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes)
 {
-    if (ctr) {
-        delete ctr;
-        ctr = nullptr;
+    // Expanding the AES key schedule is a good fraction of the work for a small packet, so keep the expanded key around for as
+    // long as we keep being asked to use the same key (the usual case, most traffic is on one channel)
+    if (!ctr || ctrKey.length != _key.length || memcmp(ctrKey.bytes, _key.bytes, sizeof(_key.bytes)) != 0) {
+        if (ctr) {
+            delete ctr;
+            ctr = nullptr;
+        }
+        if (_key.length == 16)
+            ctr = new CTR<AES128>();
+        else
+            ctr = new CTR<AES256>();
+        ctr->setKey(_key.bytes, _key.length);
+        ctrKey = _key;
     }
-    if (_key.length == 16)
-        ctr = new CTR<AES128>();
-    else
-        ctr = new CTR<AES256>();
-    ctr->setKey(_key.bytes, _key.length);
-    static uint8_t scratch[MAX_BLOCKSIZE];
-    memcpy(scratch, bytes, numBytes);
-    memset(scratch + numBytes, 0,
-           sizeof(scratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
+    memcpy(ctrScratch, bytes, numBytes);
+    memset(ctrScratch + numBytes, 0,
+           sizeof(ctrScratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
 
     ctr->setIV(_nonce, 16);
     ctr->setCounterSize(4);
-    ctr->encrypt(bytes, scratch, numBytes);
+    ctr->encrypt(bytes, ctrScratch, numBytes);
 }
 
 /**
@@ -21,6 +21,11 @@ struct CryptoKey {
  */
 
 #define MAX_BLOCKSIZE 256
+
+/// Number of remote nodes we remember the derived Curve25519 shared key for
+#ifndef PKI_SHARED_KEY_CACHE_SIZE
+#define PKI_SHARED_KEY_CACHE_SIZE 8
+#endif
 #define TEST_CURVE25519_FIELD_OPS // Exposes Curve25519::isWeakPoint() for testing keys
 
 class CryptoEngine
@@ -46,6 +51,15 @@ class CryptoEngine
     virtual bool setDHPublicKey(uint8_t *publicKey);
     virtual void hash(uint8_t *bytes, size_t numBytes);
 
+    /// Drop any cached shared key for this remote public key (i.e. because a node's key changed)
+    void forgetSharedKey(const uint8_t *remotePublic);
+
+    /// Drop all cached shared keys, must be called whenever our private key changes
+    void clearSharedKeyCache();
+
+    uint32_t getSharedKeyCacheHits() const { return sharedKeyCacheHits; }
+    uint32_t getSharedKeyCacheMisses() const { return sharedKeyCacheMisses; }
+
     virtual void aesSetKey(const uint8_t *key, size_t key_len);
 
     virtual void aesEncrypt(uint8_t *in, uint8_t *out);
@@ -79,9 +93,28 @@ class CryptoEngine
     uint8_t nonce[16] = {0};
     CryptoKey key = {};
     CTRCommon *ctr = NULL;
+    CryptoKey ctrKey = {}; // the key ctr was last set up with
+    uint8_t ctrScratch[MAX_BLOCKSIZE]; // per engine rather than static, so engines on different threads don't share it
 #if !(MESHTASTIC_EXCLUDE_PKI)
     uint8_t shared_key[32] = {0};
     uint8_t private_key[32] = {0};
+
+    /// A remote public key and the SHA256 of our Curve25519 shared secret with it
+    struct SharedKeyCacheEntry {
+        uint8_t remotePublic[32];
+        uint8_t sharedKey[32];
+        uint32_t lastUsed; // 0 if this entry is unused
+    };
+    SharedKeyCacheEntry sharedKeyCache[PKI_SHARED_KEY_CACHE_SIZE] = {};
+    uint32_t sharedKeyCacheClock = 0;
+    uint32_t sharedKeyCacheHits = 0, sharedKeyCacheMisses = 0;
+
+    /**
+     * Set shared_key to the key for talking to the node with this public key, deriving it (an expensive X25519 scalar
+     * multiplication plus a SHA256) only if it is not already cached.
+     * @return false if the remote key is unusable
+     */
+    bool loadSharedKey(const uint8_t *remotePublic);
 #endif
     /**
      * Init our 128 bit nonce for a new packet
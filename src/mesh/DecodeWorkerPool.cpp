@@ -0,0 +1,165 @@
+#include "DecodeWorkerPool.h"
+
+#if ARCH_PORTDUINO
+
+#include "Channels.h"
+#include "CryptoEngine.h"
+#include "RadioInterface.h"
+#include "concurrency/SPSCQueue.h"
+#include <assert.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// The global engine logs every key change, which isn't safe from another thread (and would be very chatty)
+class QuietCryptoEngine : public CryptoEngine
+{
+  public:
+    virtual void setKey(const CryptoKey &k) override { key = k; }
+};
+
+class DecodeWorkerPool::Worker
+{
+  public:
+    Worker() : thread(&Worker::run, this) {}
+
+    ~Worker()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    /// @return false if our queue is full
+    bool push(DecodeJob *job)
+    {
+        if (!queue.push(job))
+            return false;
+        // Taking the mutex means we can't notify between the worker seeing an empty queue and it starting to wait
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+        }
+        wake.notify_one();
+        return true;
+    }
+
+  private:
+    // Room for more than the pool holds, so a push can't fail even if every job lands on this worker
+    concurrency::SPSCQueue<DecodeJob *, DECODE_JOBS_MAX * 2> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    QuietCryptoEngine engine;
+    uint8_t scratch[MAX_LORA_PAYLOAD_LEN + 1] __attribute__((__aligned__));
+
+    // Last, so everything above is constructed before the thread starts using it
+    std::thread thread;
+
+    void run()
+    {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !queue.isEmpty(); });
+                if (stopping && queue.isEmpty())
+                    return;
+            }
+            DecodeJob *job;
+            while (queue.pop(job))
+                decode(*job);
+        }
+    }
+
+    void decode(DecodeJob &job)
+    {
+        job.result.ok = false;
+        for (uint8_t i = 0; i < job.numKeys; i++) {
+            engine.setKey(job.keys[i]);
+            if (decodeChannelPayload(&engine, scratch, job.p, job.rawSize, &job.result.decoded) == CHANNEL_DECODE_OK) {
+                job.result.ok = true;
+                job.result.chIndex = job.keyChannels[i];
+                break;
+            }
+        }
+        job.done.store(true, std::memory_order_release);
+    }
+};
+
+DecodeWorkerPool::DecodeWorkerPool(uint8_t numWorkers) : numWorkers(numWorkers)
+{
+    for (uint8_t i = 0; i < numWorkers; i++)
+        workers[i] = new Worker();
+}
+
+DecodeWorkerPool::~DecodeWorkerPool()
+{
+    for (uint8_t i = 0; i < numWorkers; i++)
+        delete workers[i];
+}
+
+bool DecodeWorkerPool::prepare(DecodeJob &job)
+{
+    const meshtastic_MeshPacket *p = job.p;
+    if (p->which_payload_variant != meshtastic_MeshPacket_encrypted_tag)
+        return false;
+
+    // perhapsDecode() won't even look at it
+    if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER &&
+        config.device.rebroadcast_mode == meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING)
+        return false;
+
+    job.rawSize = p->encrypted.size;
+    if (job.rawSize > MAX_LORA_PAYLOAD_LEN + 1)
+        return false;
+
+    // A DM to us on hash 0 may be PKI encrypted, which needs nodeDB and our private key, so leave it to the main thread
+    if (p->channel == 0 && isToUs(p) && !isBroadcast(p->to))
+        return false;
+
+    job.numKeys = 0;
+    uint8_t candidates = channels.getChannelsForHash(p->channel);
+    for (ChannelIndex chIndex = 0; candidates; chIndex++, candidates >>= 1) {
+        if ((candidates & 1) && channels.getKeyForHash(chIndex, p->channel, job.keys[job.numKeys]))
+            job.keyChannels[job.numKeys++] = chIndex;
+    }
+    return job.numKeys > 0;
+}
+
+void DecodeWorkerPool::submit(meshtastic_MeshPacket *p)
+{
+    assert(!isFull());
+    DecodeJob &job = jobs[(firstJob + numJobs) % DECODE_JOBS_MAX];
+    numJobs++;
+
+    job.p = p;
+    job.done.store(false, std::memory_order_relaxed); // published to the worker by the queue push
+    job.offloaded = prepare(job) && workers[nextWorker]->push(&job);
+    if (job.offloaded) {
+        nextWorker = (nextWorker + 1) % numWorkers;
+        numOffloaded++;
+    } else {
+        job.done.store(true, std::memory_order_relaxed);
+        numInline++;
+    }
+}
+
+const DecodeJob *DecodeWorkerPool::front()
+{
+    if (isIdle())
+        return NULL;
+    DecodeJob &job = jobs[firstJob];
+    return job.done.load(std::memory_order_acquire) ? &job : NULL;
+}
+
+void DecodeWorkerPool::pop()
+{
+    assert(!isIdle());
+    firstJob = (firstJob + 1) % DECODE_JOBS_MAX;
+    numJobs--;
+}
+
+#endif
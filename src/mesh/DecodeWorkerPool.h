@@ -0,0 +1,86 @@
+#pragma once
+
+#include "configuration.h"
+
+#if ARCH_PORTDUINO
+
+#include "Router.h"
+#include <atomic>
+
+/// Most decode worker threads Router::startDecodeWorkers() will start
+#ifndef DECODE_WORKERS_MAX
+#define DECODE_WORKERS_MAX 8
+#endif
+
+/// How many received packets can be in the pool at once, must be a power of two
+#ifndef DECODE_JOBS_MAX
+#define DECODE_JOBS_MAX 16
+#endif
+
+/** One received packet on its way through a DecodeWorkerPool */
+struct DecodeJob {
+    meshtastic_MeshPacket *p;
+    /// True if a worker decrypted p with the channel keys into result, false if the main thread must decode it as usual
+    bool offloaded;
+    PredecodedPayload result;
+
+    // Everything below is only for the worker
+    size_t rawSize;
+    uint8_t numKeys;
+    ChannelIndex keyChannels[MAX_NUM_CHANNELS];
+    CryptoKey keys[MAX_NUM_CHANNELS]; // copies, so a channel change on the main thread can't pull them out from under a worker
+    std::atomic<bool> done;
+};
+
+/**
+ * Decrypts received channel packets on a few OS threads, so a busy native node isn't limited by the AES work on its one main
+ * thread.
+ *
+ * Each worker owns everything it decrypts with: a CryptoEngine, its scratch buffer, and an SPSCQueue of jobs fed by the main
+ * thread, so workers never take cryptLock or touch the global crypto, channels or nodeDB.  The main thread submits every packet
+ * in the order it arrived and takes them back out in that same order once they are done, packets a worker can't help with
+ * (already decoded, possibly PKI, no matching channel) are marked done right away and decoded by perhapsDecode() as before.
+ *
+ * All methods must be called from the main thread.
+ */
+class DecodeWorkerPool
+{
+  public:
+    explicit DecodeWorkerPool(uint8_t numWorkers);
+
+    /// Stops and joins the workers, the caller must have drained all jobs first
+    ~DecodeWorkerPool();
+
+    /// Queue a packet just received from the radio, the pool holds it until it comes out of front() again
+    void submit(meshtastic_MeshPacket *p);
+
+    /// The oldest submitted packet, or NULL if that one is still being decrypted
+    const DecodeJob *front();
+
+    /// Forget the job returned by front()
+    void pop();
+
+    bool isFull() const { return numJobs == DECODE_JOBS_MAX; }
+    bool isIdle() const { return numJobs == 0; }
+
+    /// How many packets were decrypted by workers vs left to the main thread
+    uint32_t getNumOffloaded() const { return numOffloaded; }
+    uint32_t getNumInline() const { return numInline; }
+
+  private:
+    class Worker;
+
+    DecodeJob jobs[DECODE_JOBS_MAX];
+    uint8_t firstJob = 0, numJobs = 0;
+
+    Worker *workers[DECODE_WORKERS_MAX] = {};
+    uint8_t numWorkers;
+    uint8_t nextWorker = 0;
+
+    uint32_t numOffloaded = 0, numInline = 0;
+
+    /// Fill in the keys a worker should try on this packet, @return false if a worker can't decode it
+    bool prepare(DecodeJob &job);
+};
+
+#endif
@@ -22,17 +22,7 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
 {
     if (wasSeenRecently(p)) { // Note: this will also add a recent packet record
         printPacket("Ignore dupe incoming msg", p);
-        rxDupe++;
-        if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
-            config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
-            config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE) {
-            // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
-            if (Router::cancelSending(p->from, p->id))
-                txRelayCanceled++;
-        }
-        if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER_LATE && iface) {
-            iface->clampToLateRebroadcastWindow(getFrom(p), p->id);
-        }
+        onDuplicate(getFrom(p), p->id);
 
         /* If the original transmitter is doing retransmissions (hopStart equals hopLimit) for a reliable transmission, e.g., when
         the ACK got lost, we will handle the packet again to make sure it gets an ACK to its packet. */
@@ -51,6 +41,42 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
     return Router::shouldFilterReceived(p);
 }
 
+bool FloodingRouter::filterDuplicateHeader(const PacketHeader &h, uint32_t airtimeMsec)
+{
+    uint8_t hopLimit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    uint8_t hopStart = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    bool isRepeated = hopStart > 0 && hopStart == hopLimit;
+    if (isRepeated)
+        return false;
+
+    // Packets we ignore must not touch the packet history or cancel a relay, leave them to perhapsHandleReceived() to drop
+    if (ignoredSenderReason(h.from, h.flags & PACKET_FLAGS_VIA_MQTT_MASK))
+        return false;
+
+    if (!refreshIfSeen(h.from, h.id))
+        return false;
+
+    LOG_DEBUG("Ignore dupe incoming msg fr=0x%x,to=0x%x,id=0x%x (header only)", h.from, h.to, h.id);
+    rxDupeHeaderOnly++;
+    onDuplicate(h.from, h.id);
+    return true;
+}
+
+void FloodingRouter::onDuplicate(NodeNum from, PacketId id)
+{
+    rxDupe++;
+    if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
+        config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
+        config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE) {
+        // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
+        if (Router::cancelSending(from, id))
+            txRelayCanceled++;
+    }
+    if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER_LATE && iface) {
+        iface->clampToLateRebroadcastWindow(from, id);
+    }
+}
+
 bool FloodingRouter::isRebroadcaster()
 {
     return config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE &&
@@ -31,6 +31,9 @@ class FloodingRouter : public Router, protected PacketHistory
   private:
     bool isRebroadcaster();
 
+    /** Someone else sent a packet we already had, stop relaying it ourselves if our role allows */
+    void onDuplicate(NodeNum from, PacketId id);
+
     /** Check if we should rebroadcast this packet, and do so if needed
      * @return true if rebroadcasted */
     bool perhapsRebroadcast(const meshtastic_MeshPacket *p);
@@ -49,6 +52,15 @@ class FloodingRouter : public Router, protected PacketHistory
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    /**
+     * Drop flood duplicates straight from the radio header, doing the same relay cancelling shouldFilterReceived() would.
+     * Repeated reliable transmissions are left to shouldFilterReceived(), since they may need an ack or a rebroadcast, and
+     * packets from senders we ignore to perhapsHandleReceived(), so they never reach the packet history.
+     */
+    virtual bool filterDuplicateHeader(const PacketHeader &h, uint32_t airtimeMsec) override;
+
+    virtual const PacketHistory *getPacketHistory() const override { return this; }
+
   protected:
     /**
      * Should this incoming filter be dropped?
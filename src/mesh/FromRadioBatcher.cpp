@@ -0,0 +1,24 @@
+#include "FromRadioBatcher.h"
+#include <string.h>
+
+size_t FromRadioBatcher::fill(PhoneAPI &api, uint8_t *buf, size_t maxLen)
+{
+    size_t used = 0;
+    while (true) {
+        if (!heldLen)
+            heldLen = api.getFromRadio(held);
+        if (!heldLen)
+            break;
+
+        size_t need = FROMRADIO_BATCH_HEADER_SIZE + heldLen;
+        if (used + need > maxLen && used) // leave it for the next batch, unless it would be alone anyway
+            break;
+
+        buf[used] = heldLen;
+        buf[used + 1] = heldLen >> 8;
+        memcpy(buf + used + FROMRADIO_BATCH_HEADER_SIZE, held, heldLen);
+        used += need;
+        heldLen = 0;
+    }
+    return used;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PhoneAPI.h"
+
+// Each frame in a batch is its encoded FromRadio preceded by this many bytes of length (little endian)
+#define FROMRADIO_BATCH_HEADER_SIZE 2
+
+#if meshtastic_FromRadio_size + FROMRADIO_BATCH_HEADER_SIZE > MAX_TO_FROM_RADIO_SIZE
+#error "meshtastic_FromRadio_size is too large for a batched BLE read"
+#endif
+
+/**
+ * Packs several FromRadio frames into one BLE read.
+ *
+ * The legacy FROMRADIO characteristic returns one frame per read, so syncing a big node DB costs a round trip (a connection
+ * interval or two) per node. Clients that know about the FROMRADIO_BATCH characteristic read that one instead, which is how
+ * they opt in, and get
+ *   [len (2)][FromRadio][len (2)][FromRadio]...
+ * with as many whole frames as fit in the negotiated MTU. An empty value means there is nothing more to send, just like
+ * an empty read of FROMRADIO. Old apps never see the new characteristic and keep working unchanged.
+ */
+class FromRadioBatcher
+{
+  public:
+    /**
+     * Pull frames from api into buf until the next one would take the batch past maxLen
+     *
+     * A frame bigger than maxLen on its own is still returned, alone, so buf must hold MAX_TO_FROM_RADIO_SIZE bytes.
+     * @return bytes used, 0 if api has nothing to send
+     */
+    size_t fill(PhoneAPI &api, uint8_t *buf, size_t maxLen);
+
+    /// Forget the frame held back for the next batch, when the client goes away
+    void reset() { heldLen = 0; }
+
+  private:
+    /// A frame we already took from api but which didn't fit in the last batch, it starts the next one
+    uint8_t held[meshtastic_FromRadio_size];
+    size_t heldLen = 0;
+};
@@ -0,0 +1,96 @@
+#include "FromRadioBroadcast.h"
+#include "MeshService.h"
+#include "RadioInterface.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+
+bool FromRadioBroadcast::pump()
+{
+    memset(&scratch, 0, sizeof(scratch));
+
+    // Same priority the per-session code used: queue status, then notifications, then mesh packets
+    if (meshtastic_QueueStatus *qs = service->getQueueStatusForPhone()) {
+        scratch.which_payload_variant = meshtastic_FromRadio_queueStatus_tag;
+        scratch.queueStatus = *qs;
+        service->releaseQueueStatusToPool(qs);
+    } else if (meshtastic_ClientNotification *cn = service->getClientNotificationForPhone()) {
+        scratch.which_payload_variant = meshtastic_FromRadio_clientNotification_tag;
+        scratch.clientNotification = *cn;
+        service->releaseClientNotificationToPool(cn);
+    } else {
+        meshtastic_MeshPacket *p = NULL;
+#ifdef ARCH_ESP32
+#if !MESHTASTIC_EXCLUDE_STOREFORWARD
+        // Check if StoreForward has packets stored for us.
+        if (storeForwardModule)
+            p = storeForwardModule->getForPhone();
+#endif
+#endif
+        if (p) {
+            printPacket("phone downloaded packet", p);
+            scratch.which_payload_variant = meshtastic_FromRadio_packet_tag;
+            scratch.packet = *p;
+            service->releaseToPool(p);
+        } else {
+            // The inbox already holds them encoded as FromRadio frames, and leaves the slot alone if it is empty
+            Frame &f = frames[head % FROMRADIO_BROADCAST_SLOTS];
+            size_t len = service->getEncodedForPhone(f.bytes);
+            if (!len)
+                return false;
+            f.len = len;
+            return commit();
+        }
+    }
+
+    Frame &f = frames[head % FROMRADIO_BROADCAST_SLOTS];
+    f.len = pb_encode_to_bytes(f.bytes, sizeof(f.bytes), &meshtastic_FromRadio_msg, &scratch);
+    return commit();
+}
+
+bool FromRadioBroadcast::commit()
+{
+    head++;
+    if (count < FROMRADIO_BROADCAST_SLOTS)
+        count++;
+    numEncoded++;
+    return true;
+}
+
+void FromRadioBroadcast::clampCursor(uint32_t &cursor)
+{
+    uint32_t oldest = head - count;
+    // Wrap-safe "cursor < oldest"
+    if ((int32_t)(cursor - oldest) < 0) {
+        LOG_WARN("API client fell behind, skip %u frames", oldest - cursor);
+        numSkipped += oldest - cursor;
+        cursor = oldest;
+    }
+}
+
+uint32_t FromRadioBroadcast::subscribe()
+{
+    concurrency::LockGuard guard(&lock);
+    return head;
+}
+
+bool FromRadioBroadcast::available(uint32_t &cursor)
+{
+    concurrency::LockGuard guard(&lock);
+    clampCursor(cursor);
+    // Only the session(s) that have caught up pull more out of MeshService
+    return cursor != head || pump();
+}
+
+size_t FromRadioBroadcast::read(uint32_t &cursor, uint8_t *buf)
+{
+    concurrency::LockGuard guard(&lock);
+    clampCursor(cursor);
+    if (cursor == head && !pump())
+        return 0;
+
+    const Frame &f = frames[cursor % FROMRADIO_BROADCAST_SLOTS];
+    memcpy(buf, f.bytes, f.len);
+    cursor++;
+    numDelivered++;
+    return f.len;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "concurrency/Lock.h"
+#include "mesh-pb-constants.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// How many encoded FromRadio frames we keep for sessions that are reading more slowly than the others
+#ifndef FROMRADIO_BROADCAST_SLOTS
+#ifdef ARCH_PORTDUINO
+#define FROMRADIO_BROADCAST_SLOTS MAX_RX_TOPHONE
+#else
+#define FROMRADIO_BROADCAST_SLOTS 8
+#endif
+#endif
+static_assert((FROMRADIO_BROADCAST_SLOTS & (FROMRADIO_BROADCAST_SLOTS - 1)) == 0,
+              "FROMRADIO_BROADCAST_SLOTS must be a power of two so slot indexes survive sequence number wrap");
+
+/**
+ * Shared ring of already encoded FromRadio frames for PhoneAPI sessions that have finished their config download.
+ *
+ * Packets, queue status and client notifications are pulled from MeshService and protobuf encoded once, then every session
+ * copies the same bytes out using its own cursor.  New frames are only pulled when some session has read everything, so with
+ * no clients attached the packets keep waiting in MeshService exactly as before.  A session that falls more than
+ * FROMRADIO_BROADCAST_SLOTS frames behind skips forward to the oldest frame still held.
+ */
+class FromRadioBroadcast
+{
+    struct Frame {
+        uint16_t len;
+        uint8_t bytes[meshtastic_FromRadio_size];
+    };
+
+    Frame frames[FROMRADIO_BROADCAST_SLOTS];
+
+    /// Sequence number the next encoded frame will get, frames [head - count, head) are held
+    uint32_t head = 0;
+    uint32_t count = 0;
+
+    /// Scratch for encoding, only touched under lock
+    meshtastic_FromRadio scratch = {};
+
+    concurrency::Lock lock;
+
+    uint32_t numEncoded = 0, numDelivered = 0, numSkipped = 0;
+
+    /// Move the next item queued in MeshService into the ring, returns false if there was nothing to send
+    bool pump();
+
+    /// The slot at head now holds a new frame
+    bool commit();
+
+    /// Bring a cursor that fell off the back of the ring up to the oldest frame we still have
+    void clampCursor(uint32_t &cursor);
+
+  public:
+    /// Cursor for a session starting to read now, it will only see frames encoded from here on
+    uint32_t subscribe();
+
+    /// Return true if there is a frame at (or can be pulled for) the given cursor
+    bool available(uint32_t &cursor);
+
+    /**
+     * Copy the frame at cursor into buf (which must hold meshtastic_FromRadio_size bytes) and advance the cursor.
+     * Returns the number of bytes, or 0 if no frame is waiting.
+     */
+    size_t read(uint32_t &cursor, uint8_t *buf);
+
+    uint32_t getNumEncoded() const { return numEncoded; }
+    uint32_t getNumDelivered() const { return numDelivered; }
+    uint32_t getNumSkipped() const { return numSkipped; }
+};
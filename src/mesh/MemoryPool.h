@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <assert.h>
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -96,3 +97,116 @@ template <class T> class MemoryDynamic : public Allocator<T>
         return p;
     }
 };
+
+/**
+ * A fixed capacity slab allocator for objects which are constantly churned (i.e. packets).
+ *
+ * Free slots are tracked in a bitmap which is updated with atomic compare-and-swap, so alloc and release are lock-free and safe
+ * to call from both regular and ISR code.  This keeps the hot RX/TX path from fragmenting the heap.  If the slab is ever
+ * exhausted we fall back to the heap rather than failing, and count that so it can be tuned.
+ */
+template <class T, int MaxSize> class MemoryPool : public Allocator<T>
+{
+    static_assert(MaxSize > 0, "MemoryPool must have at least one slot");
+
+    static constexpr int WORD_BITS = 32;
+    static constexpr int NUM_WORDS = (MaxSize + WORD_BITS - 1) / WORD_BITS;
+
+    /// Backing storage for the slab, never touched except through alloc/release
+    alignas(T) uint8_t slab[MaxSize * sizeof(T)];
+
+    /// One bit per slot, set if the slot is in use
+    std::atomic<uint32_t> used[NUM_WORDS];
+
+    std::atomic<uint32_t> numInUse{0};
+    std::atomic<uint32_t> highWaterMark{0};
+    std::atomic<uint32_t> slabMisses{0};
+    std::atomic<uint32_t> allocFailures{0};
+
+  public:
+    MemoryPool()
+    {
+        for (int i = 0; i < NUM_WORDS; i++) {
+            // Mark the unused tail bits of the last word as permanently taken
+            int validBits = MaxSize - i * WORD_BITS;
+            used[i] = validBits >= WORD_BITS ? 0 : ~((1UL << validBits) - 1);
+        }
+    }
+
+    /// Return a buffer for use by others
+    virtual void release(T *p) override
+    {
+        assert(p);
+
+        int index = slotOf(p);
+        if (index < 0) {
+            free(p); // This came from the heap fallback
+            return;
+        }
+
+        uint32_t mask = 1UL << (index % WORD_BITS);
+        uint32_t old = used[index / WORD_BITS].fetch_and(~mask);
+        assert(old & mask); // Double free
+        (void)old;
+        numInUse--;
+    }
+
+    /// Number of slab slots currently handed out
+    uint32_t getNumInUse() const { return numInUse; }
+
+    /// The most slab slots that have ever been in use at once
+    uint32_t getHighWaterMark() const { return highWaterMark; }
+
+    /// How many allocations found the slab full and were served from the heap instead
+    uint32_t getSlabMisses() const { return slabMisses; }
+
+    /// How many allocations failed outright (slab full and heap exhausted)
+    uint32_t getAllocFailures() const { return allocFailures; }
+
+    static constexpr int capacity() { return MaxSize; }
+
+  protected:
+    // Alloc some storage
+    virtual T *alloc(TickType_t maxWait) override
+    {
+        for (int i = 0; i < NUM_WORDS; i++) {
+            uint32_t cur = used[i].load();
+            while (cur != UINT32_MAX) {
+                int bit = __builtin_ctz(~cur);
+                if (used[i].compare_exchange_weak(cur, cur | (1UL << bit))) {
+                    noteAllocated();
+                    return reinterpret_cast<T *>(&slab[(i * WORD_BITS + bit) * sizeof(T)]);
+                }
+                // cur has been reloaded by the failed CAS, try again
+            }
+        }
+
+        slabMisses++;
+        T *p = (T *)malloc(sizeof(T));
+        if (!p)
+            allocFailures++;
+        assert(p);
+        return p;
+    }
+
+  private:
+    /// Return the slot index of p, or -1 if p does not live in our slab
+    int slotOf(const T *p) const
+    {
+        const uint8_t *b = reinterpret_cast<const uint8_t *>(p);
+        if (b < slab || b >= slab + sizeof(slab))
+            return -1;
+
+        size_t offset = b - slab;
+        assert(offset % sizeof(T) == 0);
+        return offset / sizeof(T);
+    }
+
+    void noteAllocated()
+    {
+        uint32_t n = ++numInUse;
+        uint32_t hwm = highWaterMark.load();
+        while (n > hwm && !highWaterMark.compare_exchange_weak(hwm, n)) {
+        }
+    }
+};
@@ -12,27 +12,79 @@ inline uint32_t getPriority(const meshtastic_MeshPacket *p)
     return pri;
 }
 
-/// @return "true" if "p1" is ordered before "p2"
-bool CompareMeshPacketFunc(const meshtastic_MeshPacket *p1, const meshtastic_MeshPacket *p2)
+/**
+ * Build the sort key for a packet, lower keys are sent first.  This encodes the same ordering we have always used:
+ *   - if one packet is in the late transmit window, prefer the other one
+ *   - then higher priority first
+ *   - for equal priorities, prefer packets already on mesh
+ *   - and finally first in, first out
+ */
+uint64_t MeshPacketQueue::makeOrder(const meshtastic_MeshPacket *p, uint32_t seq)
 {
-    assert(p1 && p2);
+    uint64_t late = p->tx_after ? 1 : 0;
+    uint64_t invPriority = 0xff - (getPriority(p) & 0xff);
+    uint64_t fromUs = isFromUs(p) ? 1 : 0;
+    return (late << 63) | (invPriority << 55) | (fromUs << 54) | seq;
+}
 
-    // If one packet is in the late transmit window, prefer the other one
-    if ((bool)p1->tx_after != (bool)p2->tx_after) {
-        return !p1->tx_after;
-    }
+MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen)
+{
+    assert(maxLen < NIL);
+    entries.resize(maxLen);
+    heap.reserve(maxLen);
+    freeEntries.reserve(maxLen);
+    for (size_t i = maxLen; i-- > 0;)
+        freeEntries.push_back(i);
+
+    size_t numBuckets = 1;
+    while (numBuckets < maxLen)
+        numBuckets <<= 1;
+    buckets.assign(numBuckets, NIL);
+}
+
+bool MeshPacketQueue::empty()
+{
+    return heap.empty();
+}
 
-    auto p1p = getPriority(p1), p2p = getPriority(p2);
-    // If priorities differ, use that
-    // for equal priorities, prefer packets already on mesh.
-    return (p1p != p2p) ? (p1p > p2p) : (!isFromUs(p1) && isFromUs(p2));
+uint16_t &MeshPacketQueue::bucketFor(NodeNum from, PacketId id)
+{
+    uint32_t h = from * 0x9E3779B1u ^ id;
+    h ^= h >> 16;
+    return buckets[h & (buckets.size() - 1)];
 }
 
-MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen) {}
+void MeshPacketQueue::swapHeap(size_t a, size_t b)
+{
+    std::swap(heap[a], heap[b]);
+    entries[heap[a]].heapPos = a;
+    entries[heap[b]].heapPos = b;
+}
 
-bool MeshPacketQueue::empty()
+void MeshPacketQueue::siftUp(size_t pos)
+{
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (entries[heap[parent]].order <= entries[heap[pos]].order)
+            break;
+        swapHeap(pos, parent);
+        pos = parent;
+    }
+}
+
+void MeshPacketQueue::siftDown(size_t pos)
 {
-    return queue.empty();
+    for (;;) {
+        size_t smallest = pos, left = 2 * pos + 1, right = left + 1;
+        if (left < heap.size() && entries[heap[left]].order < entries[heap[smallest]].order)
+            smallest = left;
+        if (right < heap.size() && entries[heap[right]].order < entries[heap[smallest]].order)
+            smallest = right;
+        if (smallest == pos)
+            break;
+        swapHeap(pos, smallest);
+        pos = smallest;
+    }
 }
 
 /**
@@ -68,25 +120,65 @@ void fixPriority(meshtastic_MeshPacket *p)
 bool MeshPacketQueue::enqueue(meshtastic_MeshPacket *p)
 {
     // no space - try to replace a lower priority packet in the queue
-    if (queue.size() >= maxLen) {
+    if (heap.size() >= maxLen) {
         return replaceLowerPriorityPacket(p);
     }
 
-    // Find the correct position using upper_bound to maintain a stable order
-    auto it = std::upper_bound(queue.begin(), queue.end(), p, CompareMeshPacketFunc);
-    queue.insert(it, p); // Insert packet at the found position
+    uint16_t slot = freeEntries.back();
+    freeEntries.pop_back();
+
+    Entry &e = entries[slot];
+    e.packet = p;
+    e.order = makeOrder(p, nextSeq++);
+    e.from = getFrom(p);
+
+    uint16_t &bucket = bucketFor(e.from, p->id);
+    e.nextHash = bucket;
+    bucket = slot;
+
+    e.heapPos = heap.size();
+    heap.push_back(slot);
+    siftUp(e.heapPos);
     return true;
 }
 
+meshtastic_MeshPacket *MeshPacketQueue::removeEntry(uint16_t slot)
+{
+    Entry &e = entries[slot];
+
+    // Unlink from the (from, id) index
+    for (uint16_t *link = &bucketFor(e.from, e.packet->id); *link != NIL; link = &entries[*link].nextHash) {
+        if (*link == slot) {
+            *link = e.nextHash;
+            break;
+        }
+    }
+
+    // Move the last heap element into the hole, then restore the heap property in whichever direction it needs
+    size_t pos = e.heapPos;
+    size_t last = heap.size() - 1;
+    if (pos != last) {
+        swapHeap(pos, last);
+        heap.pop_back();
+        siftDown(pos);
+        siftUp(pos);
+    } else {
+        heap.pop_back();
+    }
+
+    meshtastic_MeshPacket *p = e.packet;
+    e.packet = NULL;
+    freeEntries.push_back(slot);
+    return p;
+}
+
 meshtastic_MeshPacket *MeshPacketQueue::dequeue()
 {
     if (empty()) {
         return NULL;
     }
 
-    auto *p = queue.front();
-    queue.erase(queue.begin()); // Remove the highest-priority packet
-    return p;
+    return removeEntry(heap.front()); // Remove the highest-priority packet
 }
 
 meshtastic_MeshPacket *MeshPacketQueue::getFront()
@@ -95,56 +187,47 @@ meshtastic_MeshPacket *MeshPacketQueue::getFront()
         return NULL;
     }
 
-    auto *p = queue.front();
-    return p;
+    return entries[heap.front()].packet;
 }
 
 /** Attempt to find and remove a packet from this queue.  Returns a pointer to the removed packet, or NULL if not found */
 meshtastic_MeshPacket *MeshPacketQueue::remove(NodeNum from, PacketId id, bool tx_normal, bool tx_late)
 {
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        auto p = (*it);
-        if (getFrom(p) == from && p->id == id && ((tx_normal && !p->tx_after) || (tx_late && p->tx_after))) {
-            queue.erase(it);
-            return p;
+    // If there are several copies queued (i.e. retransmissions), remove the one which would be sent first
+    uint16_t best = NIL;
+    for (uint16_t slot = bucketFor(from, id); slot != NIL; slot = entries[slot].nextHash) {
+        const Entry &e = entries[slot];
+        auto p = e.packet;
+        if (e.from == from && p->id == id && ((tx_normal && !p->tx_after) || (tx_late && p->tx_after))) {
+            if (best == NIL || e.order < entries[best].order)
+                best = slot;
         }
     }
 
-    return NULL;
+    return best == NIL ? NULL : removeEntry(best);
 }
 
 /** Attempt to find and remove a packet from this queue.  Returns the packet which was removed from the queue */
 bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 {
-
-    if (queue.empty()) {
+    if (empty()) {
         return false; // No packets to replace
     }
 
-    // Check if the packet at the back has a lower priority than the new packet
-    auto &backPacket = queue.back();
-    if (!backPacket->tx_after && backPacket->priority < p->priority) {
-        // Remove the back packet
-        packetPool.release(backPacket);
-        queue.pop_back();
-        // Insert the new packet in the correct order
-        enqueue(p);
-        return true;
+    // Find the non-late packet that would be sent last.  This is a linear scan, but we only get here when the queue is full.
+    uint16_t victim = NIL;
+    for (uint16_t slot : heap) {
+        const Entry &e = entries[slot];
+        if (!e.packet->tx_after && (victim == NIL || e.order > entries[victim].order))
+            victim = slot;
     }
 
-    if (backPacket->tx_after) {
-        // Check if there's a non-late packet with lower priority
-        auto it = queue.end();
-        auto refPacket = *--it;
-        for (; refPacket->tx_after && it != queue.begin(); refPacket = *--it)
-            ;
-        if (!refPacket->tx_after && refPacket->priority < p->priority) {
-            packetPool.release(refPacket);
-            enqueue(refPacket);
-            return true;
-        }
+    if (victim != NIL && entries[victim].packet->priority < p->priority) {
+        packetPool.release(removeEntry(victim));
+        // Insert the new packet in the correct order
+        return enqueue(p);
     }
 
-    // If the back packet's priority is not lower, no replacement occurs
+    // If no packet has a lower priority, no replacement occurs
     return false;
-}
\ No newline at end of file
+}
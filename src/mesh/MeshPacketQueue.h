@@ -2,15 +2,45 @@
 
 #include "MeshTypes.h"
 
-#include <queue>
+#include <vector>
 
 /**
  * A priority queue of packets
+ *
+ * Implemented as a binary min-heap over a fixed table of entries, so enqueue/dequeue are O(log n) and no element ever has to be
+ * shifted.  Packets are ordered by: not in the late rebroadcast window (tx_after) first, then priority, then packets already on
+ * the mesh before our own, then FIFO (by enqueue sequence number).  A (from, id) hash index over the entries makes remove()
+ * O(1) on average.
  */
 class MeshPacketQueue
 {
+    struct Entry {
+        meshtastic_MeshPacket *packet;
+        uint64_t order;    // sort key, lower is sent first, see makeOrder()
+        NodeNum from;      // getFrom(packet) at enqueue time
+        uint16_t heapPos;  // where this entry currently is in heap
+        uint16_t nextHash; // next entry in the same index bucket, or NIL
+    };
+
+    static constexpr uint16_t NIL = UINT16_MAX;
+
     size_t maxLen;
-    std::vector<meshtastic_MeshPacket *> queue;
+    std::vector<Entry> entries;        // fixed at maxLen, slots are stable while a packet is queued
+    std::vector<uint16_t> heap;        // entry slots in heap order
+    std::vector<uint16_t> freeEntries; // unused entry slots
+    std::vector<uint16_t> buckets;     // (from, id) hash -> first entry slot, or NIL
+    uint32_t nextSeq = 0;
+
+    static uint64_t makeOrder(const meshtastic_MeshPacket *p, uint32_t seq);
+
+    uint16_t &bucketFor(NodeNum from, PacketId id);
+
+    void swapHeap(size_t a, size_t b);
+    void siftUp(size_t pos);
+    void siftDown(size_t pos);
+
+    /** Remove the entry in slot from the queue, return its packet */
+    meshtastic_MeshPacket *removeEntry(uint16_t slot);
 
     /** Replace a lower priority package in the queue with 'mp' (provided there are lower pri packages). Return true if replaced.
      */
@@ -26,7 +56,7 @@ class MeshPacketQueue
     bool empty();
 
     /** return amount of free packets in Queue */
-    size_t getFree() { return maxLen - queue.size(); }
+    size_t getFree() { return maxLen - heap.size(); }
 
     /** return total size of the Queue */
     size_t getMaxLen() { return maxLen; }
@@ -37,4 +67,4 @@ class MeshPacketQueue
 
     /** Attempt to find and remove a packet from this queue.  Returns the packet which was removed from the queue */
     meshtastic_MeshPacket *remove(NodeNum from, PacketId id, bool tx_normal = true, bool tx_late = true);
-};
\ No newline at end of file
+};
@@ -4,11 +4,13 @@
 #include <assert.h>
 #include <string>
 
+#include "FromRadioBroadcast.h"
 #include "GPSStatus.h"
 #include "MemoryPool.h"
 #include "MeshRadio.h"
 #include "MeshTypes.h"
 #include "Observer.h"
+#include "PhoneInbox.h"
 #include "PointerQueue.h"
 #if defined(ARCH_PORTDUINO)
 #include "../platform/portduino/SimRadio.h"
@@ -34,10 +36,7 @@ class MeshService
         CallbackObserver<MeshService, const meshtastic::GPSStatus *>(this, &MeshService::onGPSChanged);
 #endif
     /// received packets waiting for the phone to process them
-    /// FIXME, change to a DropOldestQueue and keep a count of the number of dropped packets to ensure
-    /// we never hang because android hasn't been there in a while
-    /// FIXME - save this to flash on deep sleep
-    PointerQueue<meshtastic_MeshPacket> toPhoneQueue;
+    PhoneInbox toPhoneInbox;
 
     // keep list of QueueStatus packets to be send to the phone
     PointerQueue<meshtastic_QueueStatus> toPhoneQueueStatusQueue;
@@ -72,6 +71,9 @@ class MeshService
     /// Called when radio config has changed (radios should observe this and set their hardware as required)
     Observable<void *> configChanged;
 
+    /// Encoded packets, queue status and notifications shared by every PhoneAPI session that has finished its config download
+    FromRadioBroadcast fromRadioBroadcast;
+
     MeshService();
 
     void init();
@@ -79,9 +81,15 @@ class MeshService
     /// Do idle processing (mostly processing messages which have been queued from the radio)
     void loop();
 
-    /// Return the next packet destined to the phone.  FIXME, somehow use fromNum to allow the phone to retry the
+    /// Copy the next packet destined to the phone, already encoded as a FromRadio, into buf (meshtastic_FromRadio_size bytes).
+    /// Returns its length, or 0 if there is none.  FIXME, somehow use fromNum to allow the phone to retry the
     /// last few packets if needs to.
-    meshtastic_MeshPacket *getForPhone() { return toPhoneQueue.dequeuePtr(0); }
+    size_t getEncodedForPhone(uint8_t *buf) { return toPhoneInbox.pop(buf); }
+
+    /// How many packets are waiting for the phone, and how many of those had to go to flash
+    uint32_t getNumWaitingForPhone(uint32_t *onFlash = NULL) { return toPhoneInbox.numWaiting(onFlash); }
+
+    const PhoneInboxStats &getPhoneInboxStats() const { return toPhoneInbox.getStats(); }
 
     /// Allows the bluetooth handler to free packets after they have been sent
     void releaseToPool(meshtastic_MeshPacket *p) { packetPool.release(p); }
@@ -46,6 +46,9 @@ typedef int ErrorCode;
 extern Allocator<meshtastic_MeshPacket> &packetPool;
 using UniquePacketPoolPacket = Allocator<meshtastic_MeshPacket>::UniqueAllocation;
 
+/// Log usage statistics (in use, high water mark, heap fallbacks) of the packetPool
+void logPacketPoolStats();
+
 /**
  * Most (but not always) of the time we want to treat packets 'from' the local phone (where from == 0), as if they originated on
  * the local node. If from is zero this function returns our node number instead
@@ -782,6 +782,7 @@ void NodeDB::resetNodes()
         clearLocalPosition();
     numMeshNodes = 1;
     std::fill(devicestate.node_db_lite.begin() + 1, devicestate.node_db_lite.end(), meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     devicestate.has_rx_text_message = false;
     devicestate.has_rx_waypoint = false;
     saveDeviceStateToDisk();
@@ -792,6 +793,7 @@ void NodeDB::resetNodes()
 void NodeDB::removeNodeByNum(NodeNum nodeNum)
 {
     int newPos = 0, removed = 0;
+    nodeIndex.beginUpdate();
     for (int i = 0; i < numMeshNodes; i++) {
         if (meshNodes->at(i).num != nodeNum)
             meshNodes->at(newPos++) = meshNodes->at(i);
@@ -801,6 +803,7 @@ void NodeDB::removeNodeByNum(NodeNum nodeNum)
     numMeshNodes -= removed;
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + 1,
               meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Save changes", removed);
     saveDeviceStateToDisk();
 }
@@ -818,6 +821,7 @@ void NodeDB::clearLocalPosition()
 void NodeDB::cleanupMeshDB()
 {
     int newPos = 0, removed = 0;
+    nodeIndex.beginUpdate();
     for (int i = 0; i < numMeshNodes; i++) {
         if (meshNodes->at(i).has_user) {
             if (meshNodes->at(i).user.public_key.size > 0) {
@@ -833,6 +837,7 @@ void NodeDB::cleanupMeshDB()
     numMeshNodes -= removed;
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + removed,
               meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     LOG_DEBUG("cleanupMeshDB purged %d entries", removed);
 }
 
@@ -843,6 +848,10 @@ void NodeDB::installDefaultDeviceState()
 
     numMeshNodes = 0;
     meshNodes = &devicestate.node_db_lite;
+    rebuildNodeIndex();
+#if NODEDB_JOURNAL
+    journal.invalidate(); // whatever is on disk no longer matches
+#endif
 
     // init our devicestate with valid flags so protobuf writing/reading will work
     devicestate.has_my_node = true;
@@ -962,10 +971,16 @@ void NodeDB::loadFromDisk()
     // if (state != LoadFileResult::LOAD_SUCCESS) {
     //    installDefaultDeviceState(); // Our in RAM copy might now be corrupt
     //} else {
+#if NODEDB_JOURNAL
+    bool journalOk = false;
+#endif
     if (devicestate.version < DEVICESTATE_MIN_VER) {
         LOG_WARN("Devicestate %d is old, discard", devicestate.version);
         installDefaultDeviceState();
     } else {
+#if NODEDB_JOURNAL
+        journalOk = journal.replay(devicestate);
+#endif
         LOG_INFO("Loaded saved devicestate version %d, with nodecount: %d", devicestate.version, devicestate.node_db_lite.size());
         meshNodes = &devicestate.node_db_lite;
         numMeshNodes = devicestate.node_db_lite.size();
@@ -973,8 +988,19 @@ void NodeDB::loadFromDisk()
     if (numMeshNodes > MAX_NUM_NODES) {
         LOG_WARN("Node count %d exceeds MAX_NUM_NODES %d, truncating", numMeshNodes, MAX_NUM_NODES);
         numMeshNodes = MAX_NUM_NODES;
+#if NODEDB_JOURNAL
+        journalOk = false; // what is on disk still has the extra nodes
+#endif
     }
     meshNodes->resize(MAX_NUM_NODES);
+    rebuildNodeIndex();
+#if NODEDB_JOURNAL
+    // A damaged journal, or nodes truncated away above, means the next save has to write a fresh snapshot
+    if (journalOk)
+        journal.rebase(devicestate, numMeshNodes);
+    else
+        journal.invalidate();
+#endif
 
     state = loadProto(configFileName, meshtastic_LocalConfig_size, sizeof(meshtastic_LocalConfig), &meshtastic_LocalConfig_msg,
                       &config);
@@ -1136,11 +1162,30 @@ bool NodeDB::saveDeviceStateToDisk()
 {
 #ifdef FSCom
     FSCom.mkdir("/prefs");
+#endif
+#if NODEDB_JOURNAL
+    // Usually only a node or two changed, so just append those to the journal
+    if (journal.append(devicestate, numMeshNodes))
+        return true;
+
+    // Delete the journal first, replaying it over a newer snapshot would bring back stale nodes
+    uint32_t start = millis();
+    journal.clear();
 #endif
     // Note: if MAX_NUM_NODES=100 and meshtastic_NodeInfoLite_size=166, so will be approximately 17KB
     // Because so huge we _must_ not use fullAtomic, because the filesystem is probably too small to hold two copies of this
-    return saveProto(prefFileName, sizeof(devicestate) + numMeshNodes * meshtastic_NodeInfoLite_size, &meshtastic_DeviceState_msg,
-                     &devicestate, false);
+    bool okay = saveProto(prefFileName, sizeof(devicestate) + numMeshNodes * meshtastic_NodeInfoLite_size,
+                          &meshtastic_DeviceState_msg, &devicestate, false);
+#if NODEDB_JOURNAL
+    if (okay) {
+        uint32_t written = journal.rebase(devicestate, numMeshNodes);
+        journal.noteSave(written, millis() - start, true);
+        LOG_DEBUG("Wrote devicestate snapshot, %u bytes in %ums", written, journal.getStats().lastSaveMs);
+    } else {
+        journal.invalidate();
+    }
+#endif
+    return okay;
 }
 
 bool NodeDB::saveToDiskNoRetry(int saveWhat)
@@ -1200,7 +1245,9 @@ bool NodeDB::saveToDisk(int saveWhat)
         LOG_ERROR("Failed to save to disk, retrying");
 #ifdef ARCH_NRF52 // @geeksville is not ready yet to say we should do this on other platforms.  See bug #4184 discussion
         FSCom.format();
-
+#if NODEDB_JOURNAL
+        journal.invalidate(); // the snapshot went with everything else, so don't journal on top of nothing
+#endif
 #endif
         success = saveToDiskNoRetry(saveWhat);
 
@@ -1355,6 +1402,13 @@ bool NodeDB::updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelInde
     auto lite = TypeConversions::ConvertToUserLite(p);
     bool changed = memcmp(&info->user, &lite, sizeof(info->user)) || (info->channel != channelIndex);
 
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    if (info->user.public_key.size > 0 && (lite.public_key.size != info->user.public_key.size ||
+                                           memcmp(lite.public_key.bytes, info->user.public_key.bytes, 32) != 0)) {
+        crypto->forgetSharedKey(info->user.public_key.bytes); // Don't keep a shared key derived from the old public key
+    }
+#endif
+
     info->user = lite;
     if (info->user.public_key.size == 32) {
         printBytes("Saved Pubkey: ", info->user.public_key.bytes, 32);
@@ -1395,8 +1449,12 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
             return;
         }
 
-        if (mp.rx_time) // if the packet has a valid timestamp use it to update our last_heard
+        if (mp.rx_time) { // if the packet has a valid timestamp use it to update our last_heard
             info->last_heard = mp.rx_time;
+            size_t slot = info - meshNodes->data();
+            if (slot > 0) // never track ourselves for eviction
+                nodeLru.touch(slot, evictionClassOf(*info));
+        }
 
         if (mp.rx_snr)
             info->snr = mp.rx_snr; // keep the most recent SNR we received for this node.
@@ -1420,10 +1478,94 @@ uint8_t NodeDB::getMeshNodeChannel(NodeNum n)
     return info->channel;
 }
 
+void NodeDB::rebuildNodeIndex()
+{
+    nodeIndex.beginUpdate();
+    nodeIndex.reset(MAX_NUM_NODES);
+    for (int i = 0; i < numMeshNodes; i++)
+        nodeIndex.insert(meshNodes->at(i).num, i);
+    nodeIndex.endUpdate();
+
+    // Slot 0 is always our own node, which is never evicted
+    std::vector<uint16_t> bySeen;
+    for (int i = 1; i < numMeshNodes; i++)
+        bySeen.push_back(i);
+    std::stable_sort(bySeen.begin(), bySeen.end(),
+                     [this](uint16_t a, uint16_t b) { return meshNodes->at(a).last_heard < meshNodes->at(b).last_heard; });
+
+    nodeLru.reset(MAX_NUM_NODES);
+    for (uint16_t i : bySeen)
+        nodeLru.touch(i, evictionClassOf(meshNodes->at(i)));
+}
+
+NodeLru::Class NodeDB::evictionClassOf(const meshtastic_NodeInfoLite &node)
+{
+    if (node.is_favorite || node.is_ignored)
+        return NodeLru::PROTECTED;
+    return node.user.public_key.size == 0 ? NodeLru::BORING : NodeLru::KEYED;
+}
+
+void NodeDB::refileSlot(uint16_t slot)
+{
+    uint32_t lastHeard = meshNodes->at(slot).last_heard;
+    nodeLru.insertByAge(slot, evictionClassOf(meshNodes->at(slot)),
+                        [&](uint16_t other) { return meshNodes->at(other).last_heard > lastHeard; });
+}
+
+void NodeDB::updateEvictionClass(NodeNum nodeId)
+{
+    const meshtastic_NodeInfoLite *info = getMeshNode(nodeId);
+    if (!info)
+        return;
+    size_t slot = info - meshNodes->data();
+    if (slot > 0) // never track ourselves for eviction
+        refileSlot(slot);
+}
+
+int NodeDB::findEvictionSlot()
+{
+    // A node that got a public key, or was favorited/ignored by something that didn't call updateEvictionClass(), can be
+    // filed under a stale class.  Fix those up lazily as they reach the front, each fix moves a slot to its correct list so
+    // this is bounded.
+    for (int fixups = 0; fixups <= numMeshNodes; fixups++) {
+        int slot = nodeLru.oldest(NodeLru::BORING);
+        if (slot == NodeLru::NONE)
+            slot = nodeLru.oldest(NodeLru::KEYED);
+        if (slot == NodeLru::NONE)
+            break;
+
+        NodeLru::Class actual = evictionClassOf(meshNodes->at(slot));
+        if (actual == nodeLru.classOf(slot))
+            return slot;
+        refileSlot(slot);
+    }
+
+    // Everything we know of is protected, but a node might have been unfavorited since we last filed it, so check the slow way
+    int oldestIndex = -1;
+    uint32_t oldest = UINT32_MAX;
+    for (int i = 1; i < numMeshNodes; i++) {
+        if (evictionClassOf(meshNodes->at(i)) != NodeLru::PROTECTED && meshNodes->at(i).last_heard < oldest) {
+            oldest = meshNodes->at(i).last_heard;
+            oldestIndex = i;
+        }
+    }
+    return oldestIndex;
+}
+
 /// Find a node in our DB, return null for missing
 /// NOTE: This function might be called from an ISR
 meshtastic_NodeInfoLite *NodeDB::getMeshNode(NodeNum n)
 {
+    if (!nodeIndex.isUpdating()) {
+        int i = nodeIndex.find(n);
+        // The index is only a hint if we raced a mutation, so confirm it against the array itself
+        if (i != NodeIndex::NOT_FOUND && i < numMeshNodes && meshNodes->at(i).num == n)
+            return &meshNodes->at(i);
+        if (i == NodeIndex::NOT_FOUND && !nodeIndex.isUpdating())
+            return NULL;
+    }
+
+    // The index is being rebuilt underneath us, fall back to the slow path
     for (int i = 0; i < numMeshNodes; i++)
         if (meshNodes->at(i).num == n)
             return &meshNodes->at(i);
@@ -1446,43 +1588,32 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
         if (isFull()) {
             LOG_INFO("Node database full with %i nodes and %u bytes free. Erasing oldest entry", numMeshNodes,
                      memGet.getFreeHeap());
-            // look for oldest node and erase it
-            uint32_t oldest = UINT32_MAX;
-            uint32_t oldestBoring = UINT32_MAX;
-            int oldestIndex = -1;
-            int oldestBoringIndex = -1;
-            for (int i = 1; i < numMeshNodes; i++) {
-                // Simply the oldest non-favorite node
-                if (!meshNodes->at(i).is_favorite && !meshNodes->at(i).is_ignored && meshNodes->at(i).last_heard < oldest) {
-                    oldest = meshNodes->at(i).last_heard;
-                    oldestIndex = i;
-                }
-                // The oldest "boring" node
-                if (!meshNodes->at(i).is_favorite && !meshNodes->at(i).is_ignored && meshNodes->at(i).user.public_key.size == 0 &&
-                    meshNodes->at(i).last_heard < oldestBoring) {
-                    oldestBoring = meshNodes->at(i).last_heard;
-                    oldestBoringIndex = i;
-                }
-            }
-            // if we found a "boring" node, evict it
-            if (oldestBoringIndex != -1) {
-                oldestIndex = oldestBoringIndex;
-            }
-
-            if (oldestIndex != -1) {
-                // Shove the remaining nodes down the chain
-                for (int i = oldestIndex; i < numMeshNodes - 1; i++) {
-                    meshNodes->at(i) = meshNodes->at(i + 1);
-                }
-                (numMeshNodes)--;
+            int evictIndex = findEvictionSlot();
+            if (evictIndex != -1) {
+                // Reuse the evicted slot in place, so we never have to shift the rest of the DB
+                nodeIndex.beginUpdate();
+                nodeIndex.remove(meshNodes->at(evictIndex).num);
+                nodeLru.remove(evictIndex);
+                lite = &meshNodes->at(evictIndex);
+                memset(lite, 0, sizeof(*lite));
+                lite->num = n;
+                nodeIndex.insert(n, evictIndex);
+                nodeIndex.endUpdate();
+                nodeLru.touch(evictIndex, evictionClassOf(*lite));
+                LOG_INFO("Replaced node at index %d in full database with %i nodes", evictIndex, numMeshNodes);
+                return lite;
             }
         }
         // add the node at the end
-        lite = &meshNodes->at((numMeshNodes)++);
+        lite = &meshNodes->at(numMeshNodes);
 
         // everything is missing except the nodenum
         memset(lite, 0, sizeof(*lite));
         lite->num = n;
+        nodeIndex.insert(n, numMeshNodes);
+        if (numMeshNodes > 0)
+            nodeLru.touch(numMeshNodes, evictionClassOf(*lite));
+        numMeshNodes++;
         LOG_INFO("Adding node to database with %i nodes and %u bytes free!", numMeshNodes, memGet.getFreeHeap());
     }
 
@@ -7,6 +7,9 @@
 #include <vector>
 
 #include "MeshTypes.h"
+#include "NodeDBJournal.h"
+#include "NodeIndex.h"
+#include "NodeLru.h"
 #include "NodeStatus.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
@@ -101,6 +104,9 @@ class NodeDB
      */
     bool updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelIndex = 0);
 
+    /// Call after changing a node's is_favorite or is_ignored, so eviction sees it in its new class
+    void updateEvictionClass(NodeNum nodeId);
+
     /// @return our node number
     NodeNum getNodeNum() { return myNodeInfo.my_node_num; }
 
@@ -168,8 +174,37 @@ class NodeDB
 
     bool hasValidPosition(const meshtastic_NodeInfoLite *n);
 
+#if NODEDB_JOURNAL
+    /// How much and how slowly we have been writing the node DB to flash
+    const NodeDBJournal &getJournal() const { return journal; }
+#endif
+
   private:
     uint32_t lastNodeDbSave = 0; // when we last saved our db to flash
+
+#if NODEDB_JOURNAL
+    /// Node changes since the last devicestate snapshot
+    NodeDBJournal journal;
+#endif
+
+    /// NodeNum -> meshNodes slot, so getMeshNode() doesn't need to scan the whole DB
+    NodeIndex nodeIndex;
+
+    /// Least recently heard order of meshNodes slots, so eviction doesn't need to scan the whole DB
+    NodeLru nodeLru;
+
+    /// Recreate nodeIndex and nodeLru from scratch, must be called whenever meshNodes is reordered or reloaded
+    void rebuildNodeIndex();
+
+    /// Which eviction class a node currently belongs to
+    static NodeLru::Class evictionClassOf(const meshtastic_NodeInfoLite &node);
+
+    /// Re-file slot under its current eviction class, keeping it in least recently heard order
+    void refileSlot(uint16_t slot);
+
+    /// Pick the slot to reuse when the DB is full, or -1 if every node is protected
+    int findEvictionSlot();
+
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
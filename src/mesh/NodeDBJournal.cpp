@@ -0,0 +1,318 @@
+#include "NodeDBJournal.h"
+
+#if NODEDB_JOURNAL
+#include "meshUtils.h"
+#include <algorithm>
+#include <pb_decode.h>
+#include <pb_encode.h>
+
+#define NODEDB_JOURNAL_FILE "/prefs/db.jrnl"
+
+#ifdef ARCH_NRF52
+#define FILE_O_APPEND FILE_O_WRITE // Adafruit LittleFS always opens for writing at the end of the file
+#else
+#define FILE_O_APPEND "a"
+#endif
+
+static const uint8_t RECORD_MAGIC = 0xa6;
+static const size_t RECORD_HEADER_SIZE = 8; // magic, type, payload len (2), crc32 (4)
+static const size_t MAX_STATE_PAYLOAD = 4096;
+
+enum JournalRecordType : uint8_t {
+    RECORD_NODE = 1,   // an encoded NodeInfoLite, replacing any node with the same num
+    RECORD_REMOVE = 2, // the NodeNum of a node that is gone
+    RECORD_STATE = 3,  // the devicestate with an empty node list
+};
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/// An output stream that only runs a CRC over what is written to it
+static bool crcWrite(pb_ostream_t *stream, const uint8_t *buf, size_t count)
+{
+    uint32_t *crc = (uint32_t *)stream->state;
+    *crc = crc32(buf, count, *crc);
+    return true;
+}
+
+/// Swaps the node list out of a devicestate for as long as it lives, so only the rest gets encoded
+class WithoutNodes
+{
+    meshtastic_DeviceState &state;
+    std::vector<meshtastic_NodeInfoLite> nodes;
+
+  public:
+    explicit WithoutNodes(meshtastic_DeviceState &state) : state(state) { nodes.swap(state.node_db_lite); }
+    ~WithoutNodes() { nodes.swap(state.node_db_lite); }
+};
+
+static void applyNode(meshtastic_DeviceState &state, const meshtastic_NodeInfoLite &node)
+{
+    auto &nodes = state.node_db_lite;
+    auto same = std::find_if(nodes.begin(), nodes.end(), [&](const meshtastic_NodeInfoLite &n) { return n.num == node.num; });
+    if (same == nodes.end()) // use the first empty slot, the snapshot is padded out to MAX_NUM_NODES with them
+        same = std::find_if(nodes.begin(), nodes.end(), [](const meshtastic_NodeInfoLite &n) { return n.num == 0; });
+    if (same != nodes.end())
+        *same = node;
+    else
+        nodes.push_back(node);
+}
+
+static void applyRemove(meshtastic_DeviceState &state, NodeNum num)
+{
+    auto &nodes = state.node_db_lite;
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [&](const meshtastic_NodeInfoLite &n) { return n.num == num; }),
+                nodes.end());
+}
+
+static bool applyState(meshtastic_DeviceState &state, const uint8_t *payload, size_t len)
+{
+    meshtastic_DeviceState *loaded = new meshtastic_DeviceState();
+    bool ok = pb_decode_from_bytes(payload, len, &meshtastic_DeviceState_msg, loaded);
+    if (ok) {
+        loaded->node_db_lite.swap(state.node_db_lite);
+        state = std::move(*loaded);
+    }
+    delete loaded;
+    return ok;
+}
+
+bool NodeDBJournal::replay(meshtastic_DeviceState &state)
+{
+    stats.journalBytes = 0;
+    auto f = FSCom.open(NODEDB_JOURNAL_FILE, FILE_O_READ);
+    if (!f)
+        return true; // nothing changed since the snapshot
+
+    uint8_t *payload = new uint8_t[MAX_STATE_PAYLOAD];
+    uint32_t records = 0;
+    bool damaged = false;
+    while (f.available()) {
+        uint8_t hdr[RECORD_HEADER_SIZE];
+        size_t len = 0;
+        bool ok = f.read(hdr, sizeof(hdr)) == sizeof(hdr) && hdr[0] == RECORD_MAGIC;
+        if (ok) {
+            len = hdr[2] | (hdr[3] << 8);
+            ok = len <= MAX_STATE_PAYLOAD && f.read(payload, len) == len && crc32(payload, len) == getU32(hdr + 4);
+        }
+        if (ok) {
+            meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+            switch (hdr[1]) {
+            case RECORD_NODE:
+                ok = pb_decode_from_bytes(payload, len, &meshtastic_NodeInfoLite_msg, &node);
+                if (ok)
+                    applyNode(state, node);
+                break;
+            case RECORD_REMOVE:
+                ok = len == sizeof(NodeNum);
+                if (ok)
+                    applyRemove(state, getU32(payload));
+                break;
+            case RECORD_STATE:
+                ok = applyState(state, payload, len);
+                break;
+            default:
+                ok = false;
+            }
+        }
+        if (!ok) {
+            damaged = true; // e.g. torn by a power cut mid write, everything before it is still good
+            break;
+        }
+        records++;
+        stats.journalBytes += RECORD_HEADER_SIZE + len;
+    }
+    f.close();
+    delete[] payload;
+
+    LOG_INFO("Replayed %u node DB journal records (%u bytes)%s", records, stats.journalBytes, damaged ? ", rest is damaged" : "");
+    return !damaged;
+}
+
+size_t NodeDBJournal::collect(const meshtastic_DeviceState &state, size_t numNodes, std::vector<SavedNode> &out)
+{
+    uint8_t buf[meshtastic_NodeInfoLite_size];
+    size_t bytes = 0;
+    out.clear();
+    out.reserve(numNodes);
+    for (size_t i = 0; i < numNodes && i < state.node_db_lite.size(); i++) {
+        const meshtastic_NodeInfoLite &node = state.node_db_lite[i];
+        if (node.num == 0)
+            continue;
+        size_t len = pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_NodeInfoLite_msg, &node);
+        out.push_back({node.num, crc32(buf, len), (uint16_t)len});
+        bytes += len + 3; // plus the tag and length that wrap it in the devicestate
+    }
+    std::sort(out.begin(), out.end());
+    return bytes;
+}
+
+uint32_t NodeDBJournal::stateCrc(meshtastic_DeviceState &state, size_t *size)
+{
+    WithoutNodes guard(state);
+    uint32_t crc = 0;
+    pb_ostream_t stream = {&crcWrite, &crc, SIZE_MAX, 0};
+    pb_encode(&stream, &meshtastic_DeviceState_msg, &state);
+    *size = stream.bytes_written;
+    return crc;
+}
+
+uint32_t NodeDBJournal::rebase(meshtastic_DeviceState &state, size_t numNodes)
+{
+    size_t nodeBytes = collect(state, numNodes, saved);
+    size_t stateSize;
+    savedStateCrc = stateCrc(state, &stateSize);
+    snapshotBytes = stateSize + nodeBytes;
+    valid = true;
+    return snapshotBytes;
+}
+
+bool NodeDBJournal::writeRecord(File &f, uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t hdr[RECORD_HEADER_SIZE] = {RECORD_MAGIC, type, (uint8_t)len, (uint8_t)(len >> 8)};
+    putU32(hdr + 4, crc32(payload, len));
+    return f.write(hdr, sizeof(hdr)) == sizeof(hdr) && f.write(payload, len) == len;
+}
+
+bool NodeDBJournal::writeStateRecord(File &f, meshtastic_DeviceState &state, size_t len, uint32_t crc)
+{
+    uint8_t hdr[RECORD_HEADER_SIZE] = {RECORD_MAGIC, RECORD_STATE, (uint8_t)len, (uint8_t)(len >> 8)};
+    putU32(hdr + 4, crc);
+    if (f.write(hdr, sizeof(hdr)) != sizeof(hdr))
+        return false;
+
+    WithoutNodes guard(state);
+    pb_ostream_t stream = {&writecb, static_cast<Print *>(&f), len, 0};
+    return pb_encode(&stream, &meshtastic_DeviceState_msg, &state) && stream.bytes_written == len;
+}
+
+bool NodeDBJournal::append(meshtastic_DeviceState &state, size_t numNodes)
+{
+    if (!valid)
+        return false;
+
+    std::vector<SavedNode> now;
+    collect(state, numNodes, now);
+    size_t stateSize;
+    uint32_t newStateCrc = stateCrc(state, &stateSize);
+
+    // Walk both sorted lists to find what changed, and how big the records for it will be
+    std::vector<NodeNum> changed, removed;
+    size_t bytes = 0;
+    auto s = saved.begin();
+    for (const SavedNode &n : now) {
+        while (s != saved.end() && s->num < n.num)
+            removed.push_back((s++)->num);
+        bool same = s != saved.end() && s->num == n.num && s->crc == n.crc;
+        if (s != saved.end() && s->num == n.num)
+            s++;
+        if (!same) {
+            changed.push_back(n.num);
+            bytes += RECORD_HEADER_SIZE + n.len;
+        }
+    }
+    for (; s != saved.end(); s++)
+        removed.push_back(s->num);
+    bytes += removed.size() * (RECORD_HEADER_SIZE + sizeof(NodeNum));
+    bool stateChanged = newStateCrc != savedStateCrc;
+    if (stateChanged)
+        bytes += RECORD_HEADER_SIZE + stateSize;
+
+    if (bytes == 0) {
+        noteSave(0, 0, false);
+        return true;
+    }
+    if (stateSize > MAX_STATE_PAYLOAD || stats.journalBytes + bytes > NODEDB_JOURNAL_MAX_BYTES ||
+        stats.journalBytes + bytes > snapshotBytes / 2)
+        return false; // cheaper to start over from a snapshot
+
+    uint32_t start = millis();
+    auto f = FSCom.open(NODEDB_JOURNAL_FILE, FILE_O_APPEND);
+    if (!f)
+        return false;
+
+    // Records are applied in order on replay, so removals go first in case a node number was reused
+    uint8_t buf[meshtastic_NodeInfoLite_size];
+    uint32_t written = 0;
+    bool ok = true;
+    for (NodeNum num : removed) {
+        putU32(buf, num);
+        ok = ok && writeRecord(f, RECORD_REMOVE, buf, sizeof(NodeNum));
+        written += RECORD_HEADER_SIZE + sizeof(NodeNum);
+    }
+    for (size_t i = 0; ok && i < numNodes && i < state.node_db_lite.size(); i++) {
+        const meshtastic_NodeInfoLite &node = state.node_db_lite[i];
+        if (node.num == 0 || !std::binary_search(changed.begin(), changed.end(), node.num))
+            continue;
+        size_t len = pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_NodeInfoLite_msg, &node);
+        ok = writeRecord(f, RECORD_NODE, buf, len);
+        written += RECORD_HEADER_SIZE + len;
+    }
+    if (ok && stateChanged) {
+        ok = writeStateRecord(f, state, stateSize, newStateCrc);
+        written += RECORD_HEADER_SIZE + stateSize;
+    }
+    f.close();
+
+    if (!ok) {
+        LOG_ERROR("Can't append to node DB journal");
+        valid = false; // the journal may now end in a torn record, replay stops there and the next save writes a snapshot
+        return false;
+    }
+
+    stats.journalBytes += written;
+    saved.swap(now);
+    savedStateCrc = newStateCrc;
+    noteSave(written, millis() - start, false);
+    LOG_DEBUG("Journaled %u changed, %u removed nodes%s, %u bytes", (uint32_t)changed.size(), (uint32_t)removed.size(),
+              stateChanged ? " and devicestate" : "", written);
+    return true;
+}
+
+void NodeDBJournal::clear()
+{
+    if (FSCom.exists(NODEDB_JOURNAL_FILE))
+        FSCom.remove(NODEDB_JOURNAL_FILE);
+    stats.journalBytes = 0;
+}
+
+void NodeDBJournal::noteSave(uint32_t bytes, uint32_t msec, bool snapshot)
+{
+    if (snapshot)
+        stats.snapshots++;
+    else if (bytes)
+        stats.appends++;
+    stats.lastSaveMs = msec;
+    if (msec > stats.maxSaveMs)
+        stats.maxSaveMs = msec;
+
+    uint32_t now = millis();
+    if (now - hourStartMsec >= 60 * 60 * 1000UL) {
+        LOG_INFO("Node DB wrote %u bytes to flash in the last hour, slowest save %ums", bytesThisHour, stats.maxSaveMs);
+        bytesLastHour = bytesThisHour;
+        bytesThisHour = 0;
+        hourStartMsec = now;
+        haveFullHour = true;
+    }
+    bytesThisHour += bytes;
+}
+
+uint32_t NodeDBJournal::getBytesPerHour() const
+{
+    if (haveFullHour)
+        return bytesLastHour;
+    uint32_t elapsed = millis() - hourStartMsec;
+    return elapsed ? (uint64_t)bytesThisHour * 60 * 60 * 1000 / elapsed : 0;
+}
+
+#endif
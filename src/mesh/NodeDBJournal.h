@@ -0,0 +1,115 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+
+#include <vector>
+
+// Save node DB changes as small records appended to a journal, instead of rewriting the whole devicestate each time
+#ifndef NODEDB_JOURNAL
+#ifdef FSCom
+#define NODEDB_JOURNAL 1
+#else
+#define NODEDB_JOURNAL 0
+#endif
+#endif
+
+// Once the journal would grow past this (or past half the snapshot) the next save compacts it into a new snapshot instead
+#ifndef NODEDB_JOURNAL_MAX_BYTES
+#if defined(ARCH_PORTDUINO)
+#define NODEDB_JOURNAL_MAX_BYTES (256 * 1024)
+#elif defined(ARCH_NRF52)
+#define NODEDB_JOURNAL_MAX_BYTES (4 * 1024) // InternalFS is tiny and the snapshot has to fit next to it
+#else
+#define NODEDB_JOURNAL_MAX_BYTES (16 * 1024)
+#endif
+#endif
+
+#if NODEDB_JOURNAL
+
+struct NodeDBJournalStats {
+    uint32_t appends;      // saves that only appended to the journal
+    uint32_t snapshots;    // saves that rewrote the whole devicestate
+    uint32_t journalBytes; // current size of the journal file
+    uint32_t lastSaveMs;   // how long the last save blocked the caller
+    uint32_t maxSaveMs;
+};
+
+/**
+ * Append-only log of node DB changes on top of the devicestate snapshot NodeDB::saveProto() writes.
+ *
+ * We remember a CRC of every node (and of the rest of the devicestate) as it is on disk. A save then only encodes the nodes
+ * whose CRC changed, as records of
+ *   [magic][type][payload len (2)][crc32 of payload (4)][payload]
+ * where the payload is an encoded NodeInfoLite, a removed NodeNum, or the devicestate without its nodes. loadFromDisk()
+ * replays the records over the snapshot, stopping at the first torn one.
+ *
+ * When the journal gets too big append() refuses and NodeDB writes a fresh snapshot. The journal is deleted before that
+ * snapshot is written, so after a crash we can lose recent changes but never replay old records over newer state.
+ */
+class NodeDBJournal
+{
+  public:
+    /// Apply the journal left by an earlier run to the devicestate just loaded from the snapshot, false if it was damaged
+    bool replay(meshtastic_DeviceState &state);
+
+    /**
+     * Disk now holds state (just loaded, or a snapshot was just written), so compare future saves against it
+     * @return how many bytes the snapshot of state takes
+     */
+    uint32_t rebase(meshtastic_DeviceState &state, size_t numNodes);
+
+    /// Forget what is on disk, so the next save writes a snapshot
+    void invalidate() { valid = false; }
+
+    /// Append records for everything that changed since the last save, false if a snapshot should be written instead
+    bool append(meshtastic_DeviceState &state, size_t numNodes);
+
+    /// Delete the journal file
+    void clear();
+
+    /// Account one save, of either kind
+    void noteSave(uint32_t bytes, uint32_t msec, bool snapshot);
+
+    /// Bytes saved during the last full hour, or so far this hour scaled up to a whole one if we haven't been up that long
+    uint32_t getBytesPerHour() const;
+
+    const NodeDBJournalStats &getStats() const { return stats; }
+
+  private:
+    struct SavedNode {
+        NodeNum num;
+        uint32_t crc;
+        uint16_t len; // encoded
+
+        bool operator<(const SavedNode &o) const { return num < o.num; }
+    };
+
+    /// What is on disk, sorted by node number
+    std::vector<SavedNode> saved;
+    uint32_t savedStateCrc = 0;
+    bool valid = false;
+
+    /// Size of the last snapshot, a journal half that size is worth compacting
+    uint32_t snapshotBytes = 0;
+
+    NodeDBJournalStats stats = {};
+    uint32_t bytesThisHour = 0, bytesLastHour = 0;
+    uint32_t hourStartMsec = 0;
+    bool haveFullHour = false;
+
+    /**
+     * Current CRCs of the first numNodes nodes in state, sorted like saved
+     * @return how many bytes those nodes take encoded
+     */
+    size_t collect(const meshtastic_DeviceState &state, size_t numNodes, std::vector<SavedNode> &out);
+
+    /// CRC and encoded size of the devicestate without its nodes
+    uint32_t stateCrc(meshtastic_DeviceState &state, size_t *size);
+
+    bool writeRecord(File &f, uint8_t type, const uint8_t *payload, size_t len);
+    bool writeStateRecord(File &f, meshtastic_DeviceState &state, size_t len, uint32_t crc);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "NodeIndex.h"
+#include <algorithm>
+
+void NodeIndex::reset(size_t maxNodes)
+{
+    // Keep the load factor at or below 50% so probe sequences stay short
+    size_t capacity = 16;
+    while (capacity < maxNodes * 2)
+        capacity <<= 1;
+
+    if (slots.size() != capacity) {
+        mask = 0;
+        slots.assign(capacity, Slot{0, EMPTY_SLOT});
+        mask = capacity - 1;
+    } else {
+        std::fill(slots.begin(), slots.end(), Slot{0, EMPTY_SLOT});
+    }
+}
+
+int NodeIndex::find(NodeNum n) const
+{
+    if (slots.empty())
+        return NOT_FOUND;
+
+    uint32_t i = home(n);
+    // Bounded so that a torn table (we might be called from an ISR) can never spin forever
+    for (uint32_t probes = 0; probes <= mask; probes++) {
+        const Slot &s = slots[i];
+        if (s.index == EMPTY_SLOT)
+            return NOT_FOUND;
+        if (s.num == n)
+            return s.index;
+        i = (i + 1) & mask;
+    }
+    return NOT_FOUND;
+}
+
+void NodeIndex::insert(NodeNum n, uint16_t index)
+{
+    if (slots.empty())
+        return;
+
+    uint32_t i = home(n);
+    for (uint32_t probes = 0; probes <= mask; probes++) {
+        Slot &s = slots[i];
+        if (s.index == EMPTY_SLOT || s.num == n) {
+            s.num = n;
+            s.index = index;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+void NodeIndex::remove(NodeNum n)
+{
+    if (slots.empty())
+        return;
+
+    uint32_t i = home(n);
+    for (uint32_t probes = 0; probes <= mask; probes++) {
+        if (slots[i].index == EMPTY_SLOT)
+            return;
+        if (slots[i].num == n)
+            break;
+        i = (i + 1) & mask;
+    }
+    if (slots[i].num != n)
+        return;
+
+    // Backward shift deletion: pull later members of the probe run into the hole so find() never needs tombstones
+    uint32_t hole = i;
+    uint32_t j = (i + 1) & mask;
+    while (slots[j].index != EMPTY_SLOT) {
+        uint32_t h = home(slots[j].num);
+        // Move slots[j] into the hole if its home is not cyclically within (hole, j]
+        if (((j - h) & mask) >= ((j - hole) & mask)) {
+            slots[hole] = slots[j];
+            hole = j;
+        }
+        j = (j + 1) & mask;
+    }
+    slots[hole].index = EMPTY_SLOT;
+}
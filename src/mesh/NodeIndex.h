@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A compact open-addressing NodeNum -> NodeDB slot index.
+ *
+ * NodeDB keeps its nodes in a flat array (so they can be serialized straight to flash), which makes getMeshNode() a linear
+ * scan.  This index sits alongside that array so lookups are O(1) on average.  It uses linear probing with backward shift
+ * deletion (no tombstones), so lookups never degrade as nodes churn.
+ *
+ * Lookups never allocate or block, so they are safe to call from an ISR.  Because a lookup might race a mutation on the main
+ * thread, callers should treat the result as a hint and verify it against the backing array (see NodeDB::getMeshNode).
+ */
+class NodeIndex
+{
+  public:
+    /// Returned by find() if the node is not in the index
+    static constexpr int NOT_FOUND = -1;
+
+    /// Size the table for up to maxNodes entries and remove all entries, call between beginUpdate() and endUpdate()
+    void reset(size_t maxNodes);
+
+    /// @return the slot index for n, or NOT_FOUND
+    int find(NodeNum n) const;
+
+    /// Add (or update) the slot index for n
+    void insert(NodeNum n, uint16_t index);
+
+    /// Remove n from the index (if present)
+    void remove(NodeNum n);
+
+    /// True while the table is being mutated, readers which can't wait (ISRs) should fall back to a scan
+    bool isUpdating() const { return updating; }
+
+    /// Mark the start/end of a mutation, nesting is not supported
+    void beginUpdate() { updating = true; }
+    void endUpdate() { updating = false; }
+
+  private:
+    struct Slot {
+        NodeNum num;
+        uint16_t index; // EMPTY_SLOT if unused
+    };
+
+    static constexpr uint16_t EMPTY_SLOT = UINT16_MAX;
+
+    std::vector<Slot> slots;
+    uint32_t mask = 0; // slots.size() - 1, slots.size() is always a power of two
+    volatile bool updating = false;
+
+    uint32_t home(NodeNum n) const
+    {
+        // Fibonacci hashing, node numbers are mostly derived from mac addresses so the low bits alone are a poor hash
+        return ((n * 2654435769u) >> 16) & mask;
+    }
+};
@@ -0,0 +1,54 @@
+#include "NodeLru.h"
+#include <algorithm>
+
+void NodeLru::reset(size_t maxNodes)
+{
+    prev.assign(maxNodes, NIL);
+    next.assign(maxNodes, NIL);
+    cls.assign(maxNodes, NUM_CLASSES);
+    std::fill(std::begin(head), std::end(head), NIL);
+    std::fill(std::begin(tail), std::end(tail), NIL);
+}
+
+void NodeLru::remove(uint16_t slot)
+{
+    if (slot >= cls.size() || cls[slot] == NUM_CLASSES)
+        return;
+
+    uint8_t c = cls[slot];
+    if (prev[slot] != NIL)
+        next[prev[slot]] = next[slot];
+    else
+        head[c] = next[slot];
+    if (next[slot] != NIL)
+        prev[next[slot]] = prev[slot];
+    else
+        tail[c] = prev[slot];
+
+    prev[slot] = next[slot] = NIL;
+    cls[slot] = NUM_CLASSES;
+}
+
+void NodeLru::touch(uint16_t slot, Class c)
+{
+    if (slot >= cls.size())
+        return;
+
+    remove(slot);
+    link(slot, c, tail[c]);
+}
+
+void NodeLru::link(uint16_t slot, Class c, uint16_t after)
+{
+    cls[slot] = c;
+    prev[slot] = after;
+    next[slot] = after == NIL ? head[c] : next[after];
+    if (prev[slot] != NIL)
+        next[prev[slot]] = slot;
+    else
+        head[c] = slot;
+    if (next[slot] != NIL)
+        prev[next[slot]] = slot;
+    else
+        tail[c] = slot;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Least-recently-heard ordering of NodeDB slots, used to pick which node to evict when the DB is full.
+ *
+ * Slots are kept in one of a few doubly linked lists (one per eviction class) threaded through side arrays indexed by slot
+ * number, so that touching, removing and finding the oldest node are all O(1) and the backing node array never has to be
+ * reordered.
+ */
+class NodeLru
+{
+  public:
+    /// Eviction classes, in the order we prefer to evict from
+    enum Class : uint8_t {
+        BORING = 0, // no public key, evict these first
+        KEYED,      // has a public key, only evicted once we have run out of boring nodes
+        PROTECTED,  // favorite or ignored, never evicted
+        NUM_CLASSES
+    };
+
+    static constexpr int NONE = -1;
+
+    /// Size for up to maxNodes slots and empty all lists
+    void reset(size_t maxNodes);
+
+    /// Mark slot as just heard: move it to the most recent end of the list for its class
+    void touch(uint16_t slot, Class c);
+
+    /**
+     * File slot under class c where it belongs by age, used when a node changes class without being heard (it was
+     * (un)favorited, say). isNewer(other) must say whether slot other was heard more recently than slot.
+     */
+    template <typename F> void insertByAge(uint16_t slot, Class c, F isNewer)
+    {
+        if (slot >= cls.size())
+            return;
+
+        remove(slot);
+        uint16_t after = tail[c];
+        while (after != NIL && isNewer(after))
+            after = prev[after];
+        link(slot, c, after);
+    }
+
+    /// Take slot out of all lists
+    void remove(uint16_t slot);
+
+    /// @return the least recently heard slot of class c, or NONE
+    int oldest(Class c) const { return head[c] == NIL ? NONE : head[c]; }
+
+    /// @return the class slot is currently filed under, or NUM_CLASSES if it is not in any list
+    Class classOf(uint16_t slot) const { return slot < cls.size() ? (Class)cls[slot] : NUM_CLASSES; }
+
+  private:
+    static constexpr uint16_t NIL = UINT16_MAX;
+
+    /// Put slot into list c right after slot after, or at the oldest end if after is NIL
+    void link(uint16_t slot, Class c, uint16_t after);
+
+    std::vector<uint16_t> prev, next;
+    std::vector<uint8_t> cls;
+    uint16_t head[NUM_CLASSES] = {NIL, NIL, NIL};
+    uint16_t tail[NUM_CLASSES] = {NIL, NIL, NIL};
+};
@@ -2,15 +2,18 @@
 #include "configuration.h"
 #include "mesh-pb-constants.h"
 
-#ifdef ARCH_PORTDUINO
-#include "platform/portduino/PortduinoGlue.h"
-#endif
-#include "Throttle.h"
+static_assert((PACKET_HISTORY_BUCKETS & (PACKET_HISTORY_BUCKETS - 1)) == 0, "PACKET_HISTORY_BUCKETS must be a power of two");
 
-PacketHistory::PacketHistory()
+PacketHistory::PacketHistory() {}
+
+/// Mix sender and id so that related packets (same sender, sequential ids) land in different buckets
+uint32_t PacketHistory::bucketOf(NodeNum sender, PacketId id)
 {
-    recentPackets.reserve(MAX_NUM_NODES); // Prealloc the worst case # of records - to prevent heap fragmentation
-                                          // setup our periodic task
+    uint32_t h = sender * 0x9E3779B1u ^ id;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h & (PACKET_HISTORY_BUCKETS - 1);
 }
 
 /**
@@ -23,56 +26,86 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
         return false; // Not a floodable message ID, so we don't care
     }
 
-    PacketRecord r;
-    r.id = p->id;
-    r.sender = getFrom(p);
-    r.rxTimeMsec = millis();
-
-    auto found = recentPackets.find(r);
-    bool seenRecently = (found != recentPackets.end()); // found not equal to .end() means packet was seen recently
+    NodeNum sender = getFrom(p);
+    PacketRecord *bucket = recentPackets[bucketOf(sender, p->id)];
+    stats.lookups++;
 
-    if (seenRecently &&
-        !Throttle::isWithinTimespanMs(found->rxTimeMsec, FLOOD_EXPIRE_TIME)) { // Check whether found packet has already expired
-        recentPackets.erase(found); // Erase and pretend packet has not been seen recently
-        found = recentPackets.end();
-        seenRecently = false;
+    uint32_t now = millis();
+    PacketRecord *found = NULL;
+    PacketRecord *victim = NULL; // where a new record goes: a free slot if there is one, otherwise the oldest
+    for (int i = 0; i < PACKET_HISTORY_WAYS; i++) {
+        PacketRecord &r = bucket[i];
+        if (r.id == p->id && r.sender == sender) {
+            found = &r;
+            break;
+        }
+        if (!victim || (!isExpired(*victim) && (isExpired(r) || now - r.rxTimeMsec > now - victim->rxTimeMsec)))
+            victim = &r;
     }
 
+    bool seenRecently = found && !isExpired(*found);
     if (seenRecently) {
         LOG_DEBUG("Found existing packet record for fr=0x%x,to=0x%x,id=0x%x", p->from, p->to, p->id);
+        stats.hits++;
     }
 
     if (withUpdate) {
-        if (found != recentPackets.end()) { // delete existing to updated timestamp (re-insert)
-            recentPackets.erase(found);     // as unsorted_set::iterator is const (can't update timestamp - so re-insert..)
+        if (!found) {
+            if (!isExpired(*victim)) {
+                stats.evictedLive++;
+                LOG_DEBUG("Packet history bucket full, forget fr=0x%x,id=0x%x early (%u times so far)", victim->sender, victim->id,
+                          stats.evictedLive);
+            }
+            found = victim;
+            found->sender = sender;
+            found->id = p->id;
         }
-        recentPackets.insert(r);
+        if (!seenRecently)
+            stats.inserts++;
+        found->rxTimeMsec = now; // Refresh in place, no need to erase and re-insert
         printPacket("Add packet record", p);
     }
 
-    // Capacity is reerved, so only purge expired packets if recentPackets fills past 90% capacity
-    // Expiry is normally dealt with after having searched/found a packet (above)
-    if (recentPackets.size() > (MAX_NUM_NODES * 0.9)) {
-        clearExpiredRecentPackets();
-    }
-
     return seenRecently;
 }
 
-/**
- * Iterate through all recent packets, and remove all older than FLOOD_EXPIRE_TIME
- */
-void PacketHistory::clearExpiredRecentPackets()
+bool PacketHistory::refreshIfSeen(NodeNum sender, PacketId id)
 {
-    LOG_DEBUG("recentPackets size=%ld", recentPackets.size());
+    if (id == 0)
+        return false;
 
-    for (auto it = recentPackets.begin(); it != recentPackets.end();) {
-        if (!Throttle::isWithinTimespanMs(it->rxTimeMsec, FLOOD_EXPIRE_TIME)) {
-            it = recentPackets.erase(it); // erase returns iterator pointing to element immediately following the one erased
-        } else {
-            ++it;
+    PacketRecord *bucket = recentPackets[bucketOf(sender, id)];
+    stats.lookups++;
+    for (int i = 0; i < PACKET_HISTORY_WAYS; i++) {
+        PacketRecord &r = bucket[i];
+        if (r.id == id && r.sender == sender) {
+            if (isExpired(r))
+                return false;
+            stats.hits++;
+            r.rxTimeMsec = millis();
+            return true;
         }
     }
+    return false;
+}
 
-    LOG_DEBUG("recentPackets size=%ld (after clearing expired packets)", recentPackets.size());
-}
\ No newline at end of file
+bool PacketHistory::isExpired(const PacketRecord &r)
+{
+    return r.id == 0 || !Throttle::isWithinTimespanMs(r.rxTimeMsec, FLOOD_EXPIRE_TIME);
+}
+
+size_t PacketHistory::getOccupancy() const
+{
+    size_t used = 0;
+    for (auto &bucket : recentPackets)
+        for (auto &r : bucket)
+            if (!isExpired(r))
+                used++;
+    return used;
+}
+
+void PacketHistory::logStats() const
+{
+    LOG_DEBUG("Packet history: %u/%u records in use, %u lookups, %u hits, %u inserts, %u live records evicted",
+              (uint32_t)getOccupancy(), (uint32_t)getCapacity(), stats.lookups, stats.hits, stats.inserts, stats.evictedLive);
+}
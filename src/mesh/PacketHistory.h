@@ -1,37 +1,65 @@
 #pragma once
 
 #include "Router.h"
-#include <unordered_set>
+#include "Throttle.h"
 
 /// We clear our old flood record 10 minutes after we see the last of it
 #define FLOOD_EXPIRE_TIME (10 * 60 * 1000L)
 
+/// Number of hash buckets in the packet history, must be a power of two.  Total capacity is
+/// PACKET_HISTORY_BUCKETS * PACKET_HISTORY_WAYS records (of 12 bytes each).
+#ifndef PACKET_HISTORY_BUCKETS
+#if ARCH_PORTDUINO
+#define PACKET_HISTORY_BUCKETS 256
+#else
+#define PACKET_HISTORY_BUCKETS 64
+#endif
+#endif
+
+/// Number of records per bucket, when a bucket is full its oldest record is replaced
+#ifndef PACKET_HISTORY_WAYS
+#define PACKET_HISTORY_WAYS 4
+#endif
+
 /**
  * A record of a recent message broadcast
  */
 struct PacketRecord {
     NodeNum sender;
-    PacketId id;
+    PacketId id;         // 0 if this record is unused
     uint32_t rxTimeMsec; // Unix time in msecs - the time we received it
 
     bool operator==(const PacketRecord &p) const { return sender == p.sender && id == p.id; }
 };
 
-class PacketRecordHashFunction
-{
-  public:
-    size_t operator()(const PacketRecord &p) const { return (std::hash<NodeNum>()(p.sender)) ^ (std::hash<PacketId>()(p.id)); }
+/// Counters so that the behaviour of the packet history can be tuned in the field
+struct PacketHistoryStats {
+    uint32_t lookups;     // calls to wasSeenRecently() with a floodable id
+    uint32_t hits;        // lookups which found an unexpired record
+    uint32_t inserts;     // new records added
+    uint32_t evictedLive; // unexpired records overwritten because their bucket was full, each one can cause a false negative
 };
 
 /**
  * This is a mixin that adds a record of past packets we have seen
+ *
+ * Records live in a fixed size, set associative table (like a CPU cache): each (sender, id) hashes to one bucket of
+ * PACKET_HISTORY_WAYS records.  Nothing is ever allocated, and expiry is lazy - an expired record is simply treated as free the
+ * next time its bucket is visited - so there is never a full walk of the table.  If a bucket is full of live records the oldest
+ * is overwritten, which is counted in evictedLive.
  */
 class PacketHistory
 {
   private:
-    std::unordered_set<PacketRecord, PacketRecordHashFunction> recentPackets;
+    PacketRecord recentPackets[PACKET_HISTORY_BUCKETS][PACKET_HISTORY_WAYS] = {};
 
-    void clearExpiredRecentPackets(); // clear all recentPackets older than FLOOD_EXPIRE_TIME
+    PacketHistoryStats stats = {};
+
+    /// True if r is unused or older than FLOOD_EXPIRE_TIME
+    static bool isExpired(const PacketRecord &r);
+
+  protected:
+    static uint32_t bucketOf(NodeNum sender, PacketId id);
 
   public:
     PacketHistory();
@@ -42,4 +70,22 @@ class PacketHistory
      * @param withUpdate if true and not found we add an entry to recentPackets
      */
     bool wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpdate = true);
+
+    /**
+     * Header-only variant for the radio's receive path: return true (and refresh the record, as wasSeenRecently() would) if
+     * we already hold an unexpired record for this packet.  Unlike wasSeenRecently() it never adds a record, so a packet
+     * that isn't a duplicate still looks new once it reaches the router.
+     */
+    bool refreshIfSeen(NodeNum sender, PacketId id);
+
+    /// @return the number of unexpired records currently held
+    size_t getOccupancy() const;
+
+    /// @return the total number of records we can hold
+    static constexpr size_t getCapacity() { return PACKET_HISTORY_BUCKETS * PACKET_HISTORY_WAYS; }
+
+    const PacketHistoryStats &getStats() const { return stats; }
+
+    /// Log occupancy and the counters, evictedLive in particular since each of those may have let a duplicate through
+    void logStats() const;
 };
@@ -10,9 +10,11 @@
 #include "NodeDB.h"
 #include "PacketHistory.h"
 #include "PhoneAPI.h"
+#include "PhoneConfigSnapshot.h"
 #include "PowerFSM.h"
 #include "RadioInterface.h"
 #include "TypeConversions.h"
+#include "concurrency/OSThread.h"
 #include "main.h"
 #include "xmodem.h"
 
@@ -73,10 +75,7 @@ void PhoneAPI::close()
 #ifdef FSCom
         unobserve(&xModem.packetReady);
 #endif
-        releasePhonePacket(); // Don't leak phone packets on shutdown
-        releaseQueueStatusPhonePacket();
-        releaseMqttClientProxyPhonePacket();
-        releaseClientNotification();
+        releaseMqttClientProxyPhonePacket(); // Don't leak phone packets on shutdown
         onConnectionChanged(false);
         fromRadioScratch = {};
         toRadioScratch = {};
@@ -231,9 +230,8 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
         state = STATE_SEND_CHANNELS;
         break;
 
-    case STATE_SEND_CHANNELS:
-        fromRadioScratch.which_payload_variant = meshtastic_FromRadio_channel_tag;
-        fromRadioScratch.channel = channels.getByIndex(config_state);
+    case STATE_SEND_CHANNELS: {
+        size_t len = phoneConfigSnapshot.getChannel(config_state, buf);
         config_state++;
         // Advance when we have sent all of our Channels
         if (config_state >= MAX_NUM_CHANNELS) {
@@ -241,146 +239,25 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
             state = STATE_SEND_CONFIG;
             config_state = _meshtastic_AdminMessage_ConfigType_MIN + 1;
         }
-        break;
-
-    case STATE_SEND_CONFIG:
-        fromRadioScratch.which_payload_variant = meshtastic_FromRadio_config_tag;
-        switch (config_state) {
-        case meshtastic_Config_device_tag:
-            LOG_DEBUG("Send config: device");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_device_tag;
-            fromRadioScratch.config.payload_variant.device = config.device;
-            break;
-        case meshtastic_Config_position_tag:
-            LOG_DEBUG("Send config: position");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_position_tag;
-            fromRadioScratch.config.payload_variant.position = config.position;
-            break;
-        case meshtastic_Config_power_tag:
-            LOG_DEBUG("Send config: power");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_power_tag;
-            fromRadioScratch.config.payload_variant.power = config.power;
-            fromRadioScratch.config.payload_variant.power.ls_secs = default_ls_secs;
-            break;
-        case meshtastic_Config_network_tag:
-            LOG_DEBUG("Send config: network");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_network_tag;
-            fromRadioScratch.config.payload_variant.network = config.network;
-            break;
-        case meshtastic_Config_display_tag:
-            LOG_DEBUG("Send config: display");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_display_tag;
-            fromRadioScratch.config.payload_variant.display = config.display;
-            break;
-        case meshtastic_Config_lora_tag:
-            LOG_DEBUG("Send config: lora");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_lora_tag;
-            fromRadioScratch.config.payload_variant.lora = config.lora;
-            break;
-        case meshtastic_Config_bluetooth_tag:
-            LOG_DEBUG("Send config: bluetooth");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_bluetooth_tag;
-            fromRadioScratch.config.payload_variant.bluetooth = config.bluetooth;
-            break;
-        case meshtastic_Config_security_tag:
-            LOG_DEBUG("Send config: security");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_security_tag;
-            fromRadioScratch.config.payload_variant.security = config.security;
-            break;
-        case meshtastic_Config_sessionkey_tag:
-            LOG_DEBUG("Send config: sessionkey");
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_sessionkey_tag;
-            break;
-        case meshtastic_Config_device_ui_tag: // NOOP!
-            fromRadioScratch.config.which_payload_variant = meshtastic_Config_device_ui_tag;
-            break;
-        default:
-            LOG_ERROR("Unknown config type %d", config_state);
-        }
-        // NOTE: The phone app needs to know the ls_secs value so it can properly expect sleep behavior.
-        // So even if we internally use 0 to represent 'use default' we still need to send the value we are
-        // using to the app (so that even old phone apps work with new device loads).
+        return len;
+    }
 
+    case STATE_SEND_CONFIG: {
+        // NOTE: The phone app needs to know the ls_secs value so it can properly expect sleep behavior (see fillConfig)
+        LOG_DEBUG("Send config %u", config_state);
+        size_t len = phoneConfigSnapshot.getConfig(config_state, buf);
         config_state++;
         // Advance when we have sent all of our config objects
         if (config_state > (_meshtastic_AdminMessage_ConfigType_MAX + 1)) {
             state = STATE_SEND_MODULECONFIG;
             config_state = _meshtastic_AdminMessage_ModuleConfigType_MIN + 1;
         }
-        break;
-
-    case STATE_SEND_MODULECONFIG:
-        fromRadioScratch.which_payload_variant = meshtastic_FromRadio_moduleConfig_tag;
-        switch (config_state) {
-        case meshtastic_ModuleConfig_mqtt_tag:
-            LOG_DEBUG("Send module config: mqtt");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_mqtt_tag;
-            fromRadioScratch.moduleConfig.payload_variant.mqtt = moduleConfig.mqtt;
-            break;
-        case meshtastic_ModuleConfig_serial_tag:
-            LOG_DEBUG("Send module config: serial");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_serial_tag;
-            fromRadioScratch.moduleConfig.payload_variant.serial = moduleConfig.serial;
-            break;
-        case meshtastic_ModuleConfig_external_notification_tag:
-            LOG_DEBUG("Send module config: ext notification");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_external_notification_tag;
-            fromRadioScratch.moduleConfig.payload_variant.external_notification = moduleConfig.external_notification;
-            break;
-        case meshtastic_ModuleConfig_store_forward_tag:
-            LOG_DEBUG("Send module config: store forward");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_store_forward_tag;
-            fromRadioScratch.moduleConfig.payload_variant.store_forward = moduleConfig.store_forward;
-            break;
-        case meshtastic_ModuleConfig_range_test_tag:
-            LOG_DEBUG("Send module config: range test");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_range_test_tag;
-            fromRadioScratch.moduleConfig.payload_variant.range_test = moduleConfig.range_test;
-            break;
-        case meshtastic_ModuleConfig_telemetry_tag:
-            LOG_DEBUG("Send module config: telemetry");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_telemetry_tag;
-            fromRadioScratch.moduleConfig.payload_variant.telemetry = moduleConfig.telemetry;
-            break;
-        case meshtastic_ModuleConfig_canned_message_tag:
-            LOG_DEBUG("Send module config: canned message");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_canned_message_tag;
-            fromRadioScratch.moduleConfig.payload_variant.canned_message = moduleConfig.canned_message;
-            break;
-        case meshtastic_ModuleConfig_audio_tag:
-            LOG_DEBUG("Send module config: audio");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_audio_tag;
-            fromRadioScratch.moduleConfig.payload_variant.audio = moduleConfig.audio;
-            break;
-        case meshtastic_ModuleConfig_remote_hardware_tag:
-            LOG_DEBUG("Send module config: remote hardware");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_remote_hardware_tag;
-            fromRadioScratch.moduleConfig.payload_variant.remote_hardware = moduleConfig.remote_hardware;
-            break;
-        case meshtastic_ModuleConfig_neighbor_info_tag:
-            LOG_DEBUG("Send module config: neighbor info");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_neighbor_info_tag;
-            fromRadioScratch.moduleConfig.payload_variant.neighbor_info = moduleConfig.neighbor_info;
-            break;
-        case meshtastic_ModuleConfig_detection_sensor_tag:
-            LOG_DEBUG("Send module config: detection sensor");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_detection_sensor_tag;
-            fromRadioScratch.moduleConfig.payload_variant.detection_sensor = moduleConfig.detection_sensor;
-            break;
-        case meshtastic_ModuleConfig_ambient_lighting_tag:
-            LOG_DEBUG("Send module config: ambient lighting");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_ambient_lighting_tag;
-            fromRadioScratch.moduleConfig.payload_variant.ambient_lighting = moduleConfig.ambient_lighting;
-            break;
-        case meshtastic_ModuleConfig_paxcounter_tag:
-            LOG_DEBUG("Send module config: paxcounter");
-            fromRadioScratch.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_paxcounter_tag;
-            fromRadioScratch.moduleConfig.payload_variant.paxcounter = moduleConfig.paxcounter;
-            break;
-        default:
-            LOG_ERROR("Unknown module config type %d", config_state);
-        }
+        return len;
+    }
 
+    case STATE_SEND_MODULECONFIG: {
+        LOG_DEBUG("Send module config %u", config_state);
+        size_t len = phoneConfigSnapshot.getModuleConfig(config_state, buf);
         config_state++;
         // Advance when we have sent all of our ModuleConfig objects
         if (config_state > (_meshtastic_AdminMessage_ModuleConfigType_MAX + 1)) {
@@ -388,24 +265,24 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
             state = config_nonce == SPECIAL_NONCE ? STATE_SEND_FILEMANIFEST : STATE_SEND_OTHER_NODEINFOS;
             config_state = 0;
         }
-        break;
+        return len;
+    }
 
     case STATE_SEND_OTHER_NODEINFOS: {
         LOG_DEBUG("Send known nodes");
-        if (nodeInfoForPhone.num != 0) {
-            LOG_INFO("nodeinfo: num=0x%x, lastseen=%u, id=%s, name=%s", nodeInfoForPhone.num, nodeInfoForPhone.last_heard,
-                     nodeInfoForPhone.user.id, nodeInfoForPhone.user.long_name);
-            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_node_info_tag;
-            fromRadioScratch.node_info = nodeInfoForPhone;
+        uint32_t index = readIndex;
+        auto node = nodeDB->readNextMeshNode(readIndex);
+        if (node) {
+            LOG_INFO("nodeinfo: num=0x%x, lastseen=%u, id=%s, name=%s", node->num, node->last_heard, node->user.id,
+                     node->user.long_name);
             // Stay in current state until done sending nodeinfos
-            nodeInfoForPhone.num = 0; // We just consumed a nodeinfo, will need a new one next time
+            return phoneConfigSnapshot.getNodeInfo(index, node, buf);
         } else {
             LOG_DEBUG("Done sending nodeinfo");
             state = STATE_SEND_FILEMANIFEST;
             // Go ahead and send that ID right now
             return getFromRadio(buf);
         }
-        break;
     }
 
     case STATE_SEND_FILEMANIFEST: {
@@ -433,11 +310,7 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
         pauseBluetoothLogging = false;
         // Do we have a message from the mesh or packet from the local device?
         LOG_DEBUG("FromRadio=STATE_SEND_PACKETS");
-        if (queueStatusPacketForPhone) {
-            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_queueStatus_tag;
-            fromRadioScratch.queueStatus = *queueStatusPacketForPhone;
-            releaseQueueStatusPhonePacket();
-        } else if (mqttClientProxyMessageForPhone) {
+        if (mqttClientProxyMessageForPhone) {
             fromRadioScratch.which_payload_variant = meshtastic_FromRadio_mqttClientProxyMessage_tag;
             fromRadioScratch.mqttClientProxyMessage = *mqttClientProxyMessageForPhone;
             releaseMqttClientProxyPhonePacket();
@@ -445,17 +318,9 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
             fromRadioScratch.which_payload_variant = meshtastic_FromRadio_xmodemPacket_tag;
             fromRadioScratch.xmodemPacket = xmodemPacketForPhone;
             xmodemPacketForPhone = meshtastic_XModem_init_zero;
-        } else if (clientNotification) {
-            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_clientNotification_tag;
-            fromRadioScratch.clientNotification = *clientNotification;
-            releaseClientNotification();
-        } else if (packetForPhone) {
-            printPacket("phone downloaded packet", packetForPhone);
-
-            // Encapsulate as a FromRadio packet
-            fromRadioScratch.which_payload_variant = meshtastic_FromRadio_packet_tag;
-            fromRadioScratch.packet = *packetForPhone;
-            releasePhonePacket();
+        } else {
+            // Everything else was already encoded once for all sessions, just copy the bytes
+            return service->fromRadioBroadcast.read(broadcastCursor, buf);
         }
         break;
 
@@ -480,27 +345,24 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
 void PhoneAPI::sendConfigComplete()
 {
     LOG_INFO("Config Send Complete");
+    pauseBluetoothLogging = false;
+
+    // Log before filling in fromRadioScratch, which StreamAPI also uses to send log records
+    uint32_t onFlash;
+    uint32_t waiting = service->getNumWaitingForPhone(&onFlash);
+    if (waiting)
+        LOG_INFO("%u packets waiting for the phone, %u of them on flash", waiting, onFlash);
+
+    // There is no protobuf for these, clients that turned on the debug log get them as LogRecords
+    concurrency::OSThread::logStats();
+    if (router && router->getPacketHistory())
+        router->getPacketHistory()->logStats();
+
     fromRadioScratch.which_payload_variant = meshtastic_FromRadio_config_complete_id_tag;
     fromRadioScratch.config_complete_id = config_nonce;
     config_nonce = 0;
     state = STATE_SEND_PACKETS;
-    pauseBluetoothLogging = false;
-}
-
-void PhoneAPI::releasePhonePacket()
-{
-    if (packetForPhone) {
-        service->releaseToPool(packetForPhone); // we just copied the bytes, so don't need this buffer anymore
-        packetForPhone = NULL;
-    }
-}
-
-void PhoneAPI::releaseQueueStatusPhonePacket()
-{
-    if (queueStatusPacketForPhone) {
-        service->releaseQueueStatusToPool(queueStatusPacketForPhone);
-        queueStatusPacketForPhone = NULL;
-    }
+    broadcastCursor = service->fromRadioBroadcast.subscribe();
 }
 
 void PhoneAPI::releaseMqttClientProxyPhonePacket()
@@ -511,14 +373,6 @@ void PhoneAPI::releaseMqttClientProxyPhonePacket()
     }
 }
 
-void PhoneAPI::releaseClientNotification()
-{
-    if (clientNotification) {
-        service->releaseClientNotificationToPool(clientNotification);
-        clientNotification = NULL;
-    }
-}
-
 /**
  * Return true if we have data available to send to the phone
  */
@@ -539,25 +393,11 @@ bool PhoneAPI::available()
         return true;
 
     case STATE_SEND_OTHER_NODEINFOS:
-        if (nodeInfoForPhone.num == 0) {
-            auto nextNode = nodeDB->readNextMeshNode(readIndex);
-            if (nextNode) {
-                nodeInfoForPhone = TypeConversions::ConvertToNodeInfo(nextNode);
-                nodeInfoForPhone.hops_away = nodeInfoForPhone.num == nodeDB->getNodeNum() ? 0 : nodeInfoForPhone.hops_away;
-                nodeInfoForPhone.is_favorite =
-                    nodeInfoForPhone.is_favorite || nodeInfoForPhone.num == nodeDB->getNodeNum(); // Our node is always a favorite
-            }
-        }
         return true; // Always say we have something, because we might need to advance our state machine
     case STATE_SEND_PACKETS: {
-        if (!queueStatusPacketForPhone)
-            queueStatusPacketForPhone = service->getQueueStatusForPhone();
         if (!mqttClientProxyMessageForPhone)
             mqttClientProxyMessageForPhone = service->getMqttClientProxyMessageForPhone();
-        if (!clientNotification)
-            clientNotification = service->getClientNotificationForPhone();
-        bool hasPacket = !!queueStatusPacketForPhone || !!mqttClientProxyMessageForPhone || !!clientNotification;
-        if (hasPacket)
+        if (mqttClientProxyMessageForPhone)
             return true;
 
 #ifdef FSCom
@@ -569,18 +409,7 @@ bool PhoneAPI::available()
         }
 #endif
 
-#ifdef ARCH_ESP32
-#if !MESHTASTIC_EXCLUDE_STOREFORWARD
-        // Check if StoreForward has packets stored for us.
-        if (!packetForPhone && storeForwardModule)
-            packetForPhone = storeForwardModule->getForPhone();
-#endif
-#endif
-
-        if (!packetForPhone)
-            packetForPhone = service->getForPhone();
-        hasPacket = !!packetForPhone;
-        return hasPacket;
+        return service->fromRadioBroadcast.available(broadcastCursor);
     }
     default:
         LOG_ERROR("PhoneAPI::available unexpected state %d", state);
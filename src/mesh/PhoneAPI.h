@@ -60,22 +60,16 @@ class PhoneAPI
      */
     uint32_t fromRadioNum = 0;
 
-    /// We temporarily keep the packet here between the call to available and getFromRadio.  We will free it after the phone
-    /// downloads it
-    meshtastic_MeshPacket *packetForPhone = NULL;
+    /// Our position in MeshService's shared ring of encoded packets, queue status and notifications (see FromRadioBroadcast)
+    uint32_t broadcastCursor = 0;
 
     // file transfer packets destined for phone. Push it to the queue then free it.
     meshtastic_XModem xmodemPacketForPhone = meshtastic_XModem_init_zero;
 
-    // Keep QueueStatus packet just as packetForPhone
-    meshtastic_QueueStatus *queueStatusPacketForPhone = NULL;
-
-    // Keep MqttClientProxyMessage packet just as packetForPhone
+    /// We temporarily keep the MqttClientProxyMessage here between the call to available and getFromRadio.  These go to
+    /// exactly one client (so the message is only proxied once) rather than through the shared ring.
     meshtastic_MqttClientProxyMessage *mqttClientProxyMessageForPhone = NULL;
 
-    // Keep ClientNotification packet just as packetForPhone
-    meshtastic_ClientNotification *clientNotification = NULL;
-
     /// We temporarily keep the nodeInfo here between the call to available and getFromRadio
     meshtastic_NodeInfo nodeInfoForPhone = meshtastic_NodeInfo_init_default;
 
@@ -153,14 +147,8 @@ class PhoneAPI
     void handleStartConfig();
 
   private:
-    void releasePhonePacket();
-
-    void releaseQueueStatusPhonePacket();
-
     void releaseMqttClientProxyPhonePacket();
 
-    void releaseClientNotification();
-
     bool wasSeenRecently(uint32_t packetId);
 
     /**
@@ -0,0 +1,249 @@
+#include "PhoneConfigSnapshot.h"
+#include "Channels.h"
+#include "Default.h"
+#include "NodeDB.h"
+#include "TypeConversions.h"
+#include "configuration.h"
+
+PhoneConfigSnapshot phoneConfigSnapshot;
+
+void PhoneConfigSnapshot::fillChannel(meshtastic_FromRadio &f, uint8_t index)
+{
+    f.which_payload_variant = meshtastic_FromRadio_channel_tag;
+    f.channel = channels.getByIndex(index);
+}
+
+void PhoneConfigSnapshot::fillConfig(meshtastic_FromRadio &f, uint8_t type)
+{
+    f.which_payload_variant = meshtastic_FromRadio_config_tag;
+    switch (type) {
+    case meshtastic_Config_device_tag:
+        f.config.which_payload_variant = meshtastic_Config_device_tag;
+        f.config.payload_variant.device = config.device;
+        break;
+    case meshtastic_Config_position_tag:
+        f.config.which_payload_variant = meshtastic_Config_position_tag;
+        f.config.payload_variant.position = config.position;
+        break;
+    case meshtastic_Config_power_tag:
+        f.config.which_payload_variant = meshtastic_Config_power_tag;
+        f.config.payload_variant.power = config.power;
+        f.config.payload_variant.power.ls_secs = default_ls_secs;
+        break;
+    case meshtastic_Config_network_tag:
+        f.config.which_payload_variant = meshtastic_Config_network_tag;
+        f.config.payload_variant.network = config.network;
+        break;
+    case meshtastic_Config_display_tag:
+        f.config.which_payload_variant = meshtastic_Config_display_tag;
+        f.config.payload_variant.display = config.display;
+        break;
+    case meshtastic_Config_lora_tag:
+        f.config.which_payload_variant = meshtastic_Config_lora_tag;
+        f.config.payload_variant.lora = config.lora;
+        break;
+    case meshtastic_Config_bluetooth_tag:
+        f.config.which_payload_variant = meshtastic_Config_bluetooth_tag;
+        f.config.payload_variant.bluetooth = config.bluetooth;
+        break;
+    case meshtastic_Config_security_tag:
+        f.config.which_payload_variant = meshtastic_Config_security_tag;
+        f.config.payload_variant.security = config.security;
+        break;
+    case meshtastic_Config_sessionkey_tag:
+        f.config.which_payload_variant = meshtastic_Config_sessionkey_tag;
+        break;
+    case meshtastic_Config_device_ui_tag: // NOOP!
+        f.config.which_payload_variant = meshtastic_Config_device_ui_tag;
+        break;
+    default:
+        LOG_ERROR("Unknown config type %d", type);
+    }
+    // NOTE: The phone app needs to know the ls_secs value so it can properly expect sleep behavior.
+    // So even if we internally use 0 to represent 'use default' we still need to send the value we are
+    // using to the app (so that even old phone apps work with new device loads).
+}
+
+void PhoneConfigSnapshot::fillModuleConfig(meshtastic_FromRadio &f, uint8_t type)
+{
+    f.which_payload_variant = meshtastic_FromRadio_moduleConfig_tag;
+    switch (type) {
+    case meshtastic_ModuleConfig_mqtt_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_mqtt_tag;
+        f.moduleConfig.payload_variant.mqtt = moduleConfig.mqtt;
+        break;
+    case meshtastic_ModuleConfig_serial_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_serial_tag;
+        f.moduleConfig.payload_variant.serial = moduleConfig.serial;
+        break;
+    case meshtastic_ModuleConfig_external_notification_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_external_notification_tag;
+        f.moduleConfig.payload_variant.external_notification = moduleConfig.external_notification;
+        break;
+    case meshtastic_ModuleConfig_store_forward_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_store_forward_tag;
+        f.moduleConfig.payload_variant.store_forward = moduleConfig.store_forward;
+        break;
+    case meshtastic_ModuleConfig_range_test_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_range_test_tag;
+        f.moduleConfig.payload_variant.range_test = moduleConfig.range_test;
+        break;
+    case meshtastic_ModuleConfig_telemetry_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_telemetry_tag;
+        f.moduleConfig.payload_variant.telemetry = moduleConfig.telemetry;
+        break;
+    case meshtastic_ModuleConfig_canned_message_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_canned_message_tag;
+        f.moduleConfig.payload_variant.canned_message = moduleConfig.canned_message;
+        break;
+    case meshtastic_ModuleConfig_audio_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_audio_tag;
+        f.moduleConfig.payload_variant.audio = moduleConfig.audio;
+        break;
+    case meshtastic_ModuleConfig_remote_hardware_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_remote_hardware_tag;
+        f.moduleConfig.payload_variant.remote_hardware = moduleConfig.remote_hardware;
+        break;
+    case meshtastic_ModuleConfig_neighbor_info_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_neighbor_info_tag;
+        f.moduleConfig.payload_variant.neighbor_info = moduleConfig.neighbor_info;
+        break;
+    case meshtastic_ModuleConfig_detection_sensor_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_detection_sensor_tag;
+        f.moduleConfig.payload_variant.detection_sensor = moduleConfig.detection_sensor;
+        break;
+    case meshtastic_ModuleConfig_ambient_lighting_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_ambient_lighting_tag;
+        f.moduleConfig.payload_variant.ambient_lighting = moduleConfig.ambient_lighting;
+        break;
+    case meshtastic_ModuleConfig_paxcounter_tag:
+        f.moduleConfig.which_payload_variant = meshtastic_ModuleConfig_paxcounter_tag;
+        f.moduleConfig.payload_variant.paxcounter = moduleConfig.paxcounter;
+        break;
+    default:
+        LOG_ERROR("Unknown module config type %d", type);
+    }
+}
+
+void PhoneConfigSnapshot::fillNodeInfo(meshtastic_FromRadio &f, const meshtastic_NodeInfoLite *node)
+{
+    f.which_payload_variant = meshtastic_FromRadio_node_info_tag;
+    f.node_info = TypeConversions::ConvertToNodeInfo(node);
+    bool isUs = f.node_info.num == nodeDB->getNodeNum();
+    f.node_info.hops_away = isUs ? 0 : f.node_info.hops_away;
+    f.node_info.is_favorite = f.node_info.is_favorite || isUs; // Our node is always a favorite
+}
+
+size_t PhoneConfigSnapshot::encode(uint8_t *buf)
+{
+    numEncoded++;
+    return pb_encode_to_bytes(buf, meshtastic_FromRadio_size, &meshtastic_FromRadio_msg, &scratch);
+}
+
+#if PHONEAPI_CONFIG_SNAPSHOT
+
+void PhoneConfigSnapshot::build(Frame &frame)
+{
+    frame.len = encode(frame.bytes);
+}
+
+size_t PhoneConfigSnapshot::copyOut(const Frame &f, uint8_t *buf)
+{
+    numHits++;
+    memcpy(buf, f.bytes, f.len);
+    return f.len;
+}
+
+size_t PhoneConfigSnapshot::getSegmentFrame(Segment &s, const void *source, size_t sourceLen, uint8_t first, uint8_t last,
+                                            FillFn fill, uint8_t index, uint8_t *buf)
+{
+    if (index < first || index > last) {
+        // Not something we snapshot, just encode it
+        memset(&scratch, 0, sizeof(scratch));
+        fill(scratch, index);
+        return encode(buf);
+    }
+
+    if (s.source.size() != sourceLen || memcmp(s.source.data(), source, sourceLen) != 0) {
+        s.source.assign((const uint8_t *)source, (const uint8_t *)source + sourceLen);
+        s.frames.resize(last + 1);
+        for (uint8_t i = first; i <= last; i++) {
+            memset(&scratch, 0, sizeof(scratch));
+            fill(scratch, i);
+            build(s.frames[i]);
+        }
+        version++;
+        LOG_DEBUG("Config snapshot segment rebuilt, version %u", version);
+    }
+    return copyOut(s.frames[index], buf);
+}
+
+size_t PhoneConfigSnapshot::getChannel(uint8_t index, uint8_t *buf)
+{
+    return getSegmentFrame(channelSegment, channelFile.channels, sizeof(channelFile.channels), 0, MAX_NUM_CHANNELS - 1,
+                           fillChannel, index, buf);
+}
+
+size_t PhoneConfigSnapshot::getConfig(uint8_t type, uint8_t *buf)
+{
+    return getSegmentFrame(configSegment, &config, sizeof(config), _meshtastic_AdminMessage_ConfigType_MIN + 1,
+                           _meshtastic_AdminMessage_ConfigType_MAX + 1, fillConfig, type, buf);
+}
+
+size_t PhoneConfigSnapshot::getModuleConfig(uint8_t type, uint8_t *buf)
+{
+    return getSegmentFrame(moduleConfigSegment, &moduleConfig, sizeof(moduleConfig),
+                           _meshtastic_AdminMessage_ModuleConfigType_MIN + 1, _meshtastic_AdminMessage_ModuleConfigType_MAX + 1,
+                           fillModuleConfig, type, buf);
+}
+
+size_t PhoneConfigSnapshot::getNodeInfo(uint32_t index, const meshtastic_NodeInfoLite *node, uint8_t *buf)
+{
+    if (index >= nodeEntries.size())
+        nodeEntries.resize(index + 1);
+
+    // Nodes are compared one by one, so a handful of updated nodes only costs a handful of encodes
+    NodeEntry &e = nodeEntries[index];
+    NodeNum ourNodeNum = nodeDB->getNodeNum();
+    if (e.frame.len == 0 || e.ourNodeNum != ourNodeNum || memcmp(&e.source, node, sizeof(e.source)) != 0) {
+        memcpy(&e.source, node, sizeof(e.source));
+        e.ourNodeNum = ourNodeNum;
+        memset(&scratch, 0, sizeof(scratch));
+        fillNodeInfo(scratch, node);
+        build(e.frame);
+        version++;
+    }
+    return copyOut(e.frame, buf);
+}
+
+#else
+
+size_t PhoneConfigSnapshot::getChannel(uint8_t index, uint8_t *buf)
+{
+    memset(&scratch, 0, sizeof(scratch));
+    fillChannel(scratch, index);
+    return encode(buf);
+}
+
+size_t PhoneConfigSnapshot::getConfig(uint8_t type, uint8_t *buf)
+{
+    memset(&scratch, 0, sizeof(scratch));
+    fillConfig(scratch, type);
+    return encode(buf);
+}
+
+size_t PhoneConfigSnapshot::getModuleConfig(uint8_t type, uint8_t *buf)
+{
+    memset(&scratch, 0, sizeof(scratch));
+    fillModuleConfig(scratch, type);
+    return encode(buf);
+}
+
+size_t PhoneConfigSnapshot::getNodeInfo(uint32_t index, const meshtastic_NodeInfoLite *node, uint8_t *buf)
+{
+    memset(&scratch, 0, sizeof(scratch));
+    fillNodeInfo(scratch, node);
+    return encode(buf);
+}
+
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "mesh-pb-constants.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Keep the encoded config handshake around between client connections.  Costs a frame per node, so only on by default for
+// the native daemon where there is RAM to spare and many clients (and nodes).
+#ifndef PHONEAPI_CONFIG_SNAPSHOT
+#ifdef ARCH_PORTDUINO
+#define PHONEAPI_CONFIG_SNAPSHOT 1
+#else
+#define PHONEAPI_CONFIG_SNAPSHOT 0
+#endif
+#endif
+
+/**
+ * Encodes the channel, config, module config and node info frames of the PhoneAPI config handshake.
+ *
+ * With PHONEAPI_CONFIG_SNAPSHOT each segment (and each node) keeps its encoded frames along with a copy of the state they
+ * were built from.  A frame is only re-encoded when that state no longer matches, so connecting clients mostly get
+ * memcpy'd bytes.  Comparing against a copy (rather than relying on change notifications) also catches the many places that
+ * write to config/channelFile/meshNodes directly.  Every rebuild bumps getVersion().
+ *
+ * Without it every call just fills and encodes a FromRadio, exactly like PhoneAPI used to.  Frames are always built in our
+ * own scratch FromRadio, never the caller's: StreamAPI reuses its fromRadioScratch for log records, so a log line in the
+ * middle of a build would otherwise end up in the snapshot.  All methods must be called from the main thread.
+ */
+class PhoneConfigSnapshot
+{
+  public:
+    /// Fill one handshake frame, shared by the cached and uncached paths
+    static void fillChannel(meshtastic_FromRadio &f, uint8_t index);
+    static void fillConfig(meshtastic_FromRadio &f, uint8_t type);
+    static void fillModuleConfig(meshtastic_FromRadio &f, uint8_t type);
+    static void fillNodeInfo(meshtastic_FromRadio &f, const meshtastic_NodeInfoLite *node);
+
+    /**
+     * Encode (or copy from the snapshot) one frame into buf, which must hold meshtastic_FromRadio_size bytes.  Returns the
+     * encoded length.  Callers must not log between this and sending buf, StreamAPI encodes log records into the same buffer.
+     */
+    size_t getChannel(uint8_t index, uint8_t *buf);
+    size_t getConfig(uint8_t type, uint8_t *buf);
+    size_t getModuleConfig(uint8_t type, uint8_t *buf);
+    /// index is the node's position in NodeDB (as used by readNextMeshNode)
+    size_t getNodeInfo(uint32_t index, const meshtastic_NodeInfoLite *node, uint8_t *buf);
+
+    uint32_t getVersion() const { return version; }
+    uint32_t getNumHits() const { return numHits; }
+    uint32_t getNumEncoded() const { return numEncoded; }
+
+  private:
+    uint32_t version = 0;
+    uint32_t numHits = 0, numEncoded = 0;
+
+    meshtastic_FromRadio scratch = meshtastic_FromRadio_init_zero;
+
+#if PHONEAPI_CONFIG_SNAPSHOT
+    struct Frame {
+        uint16_t len = 0;
+        uint8_t bytes[meshtastic_FromRadio_size];
+    };
+
+    /// A run of frames all derived from one blob of state (channelFile.channels, config or moduleConfig)
+    struct Segment {
+        std::vector<uint8_t> source;
+        std::vector<Frame> frames;
+    };
+
+    struct NodeEntry {
+        meshtastic_NodeInfoLite source;
+        uint32_t ourNodeNum;
+        Frame frame;
+    };
+
+    Segment channelSegment, configSegment, moduleConfigSegment;
+    std::vector<NodeEntry> nodeEntries;
+
+    typedef void (*FillFn)(meshtastic_FromRadio &f, uint8_t index);
+
+    /// Rebuild the segment's frames [first, last] if its source changed, then copy out frame index
+    size_t getSegmentFrame(Segment &s, const void *source, size_t sourceLen, uint8_t first, uint8_t last, FillFn fill,
+                           uint8_t index, uint8_t *buf);
+
+    /// Encode scratch into frame
+    void build(Frame &frame);
+
+    size_t copyOut(const Frame &f, uint8_t *buf);
+#endif
+
+    /// Encode scratch into buf
+    size_t encode(uint8_t *buf);
+};
+
+extern PhoneConfigSnapshot phoneConfigSnapshot;
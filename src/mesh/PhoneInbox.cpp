@@ -0,0 +1,270 @@
+#include "PhoneInbox.h"
+#include "concurrency/LockGuard.h"
+#include "meshUtils.h"
+#include <algorithm>
+#include <pb_encode.h>
+#include <string.h>
+
+static_assert(PHONE_INBOX_BYTES >= 2 * (sizeof(uint32_t) * 3 + meshtastic_FromRadio_size),
+              "PHONE_INBOX_BYTES must hold a couple of the biggest packets");
+
+void PhoneInbox::ringWrite(uint32_t at, const void *src, size_t len)
+{
+    at %= PHONE_INBOX_BYTES;
+    size_t first = std::min(len, (size_t)(PHONE_INBOX_BYTES - at));
+    memcpy(ring + at, src, first);
+    memcpy(ring, (const uint8_t *)src + first, len - first);
+}
+
+void PhoneInbox::ringRead(uint32_t at, void *dst, size_t len) const
+{
+    at %= PHONE_INBOX_BYTES;
+    size_t first = std::min(len, (size_t)(PHONE_INBOX_BYTES - at));
+    memcpy(dst, ring + at, first);
+    memcpy((uint8_t *)dst + first, ring, len - first);
+}
+
+void PhoneInbox::push(const meshtastic_MeshPacket &p)
+{
+    concurrency::LockGuard guard(&lock);
+
+    // Encode it as a FromRadio with only its packet field set, without copying it into a FromRadio first
+    pb_ostream_t stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+    if (!pb_encode_tag(&stream, PB_WT_STRING, meshtastic_FromRadio_packet_tag) ||
+        !pb_encode_submessage(&stream, &meshtastic_MeshPacket_msg, &p)) {
+        LOG_ERROR("Can't encode packet for phone: %s", PB_GET_ERROR(&stream));
+        stats.dropped++;
+        return;
+    }
+
+    // Like the old queue, texts and range tests may push out other packets but nothing pushes them out except newer texts
+    bool isText = p.which_payload_variant == meshtastic_MeshPacket_decoded_tag &&
+                  (p.decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
+                   p.decoded.portnum == meshtastic_PortNum_RANGE_TEST_APP);
+    EntryHeader h = {(uint16_t)stream.bytes_written, isText, p.id, p.to};
+    size_t need = sizeof(h) + h.len;
+    while (PHONE_INBOX_BYTES - usedBytes < need) {
+        if (spillOldest())
+            continue;
+        if (!isText) {
+            LOG_WARN("ToPhone queue is full, drop packet");
+            stats.dropped++;
+            return;
+        }
+        dropOldest();
+    }
+
+    ringWrite(readPos + usedBytes, &h, sizeof(h));
+    ringWrite(readPos + usedBytes + sizeof(h), encoded, h.len);
+    usedBytes += need;
+    numInRam++;
+    stats.queued++;
+}
+
+bool PhoneInbox::spillOldest()
+{
+#if PHONE_INBOX_SPILL_BYTES
+    EntryHeader h;
+    ringRead(readPos, &h, sizeof(h));
+    if (spill(readPos + sizeof(h), h.len)) {
+        stats.spilled++;
+        removeEntry(readPos, sizeof(h) + h.len);
+        return true;
+    }
+#endif
+    return false;
+}
+
+void PhoneInbox::dropOldest()
+{
+    // The oldest entry that isn't a text, or failing that the oldest text
+    uint32_t victim = readPos, at = readPos;
+    EntryHeader h, victimHeader;
+    ringRead(readPos, &victimHeader, sizeof(victimHeader));
+    for (uint32_t i = 0; i < numInRam; i++) {
+        ringRead(at, &h, sizeof(h));
+        if (!h.isText) {
+            victim = at;
+            victimHeader = h;
+            break;
+        }
+        at += sizeof(h) + h.len;
+    }
+
+    LOG_WARN("ToPhone queue is full, discard oldest");
+    stats.dropped++;
+    removeEntry(victim, sizeof(victimHeader) + victimHeader.len);
+}
+
+void PhoneInbox::removeEntry(uint32_t at, size_t len)
+{
+    // Slide the older entries up over it, so what's left stays contiguous. Only dropping a packet from the middle (which
+    // means losing one) needs to move anything.
+    for (uint32_t i = at - readPos; i-- > 0;)
+        ring[(readPos + len + i) % PHONE_INBOX_BYTES] = ring[(readPos + i) % PHONE_INBOX_BYTES];
+
+    readPos = (readPos + len) % PHONE_INBOX_BYTES;
+    usedBytes -= len;
+    numInRam--;
+}
+
+size_t PhoneInbox::pop(uint8_t *buf)
+{
+    concurrency::LockGuard guard(&lock);
+
+#if PHONE_INBOX_SPILL_BYTES
+    // Everything on flash is older than what is in RAM
+    if (numSpilled) {
+        size_t len = popSpilled(buf);
+        if (len)
+            return len;
+    }
+#endif
+    if (!numInRam)
+        return 0;
+
+    EntryHeader h;
+    ringRead(readPos, &h, sizeof(h));
+    ringRead(readPos + sizeof(h), buf, h.len);
+    readPos = (readPos + sizeof(h) + h.len) % PHONE_INBOX_BYTES;
+    usedBytes -= sizeof(h) + h.len;
+    numInRam--;
+    return h.len;
+}
+
+bool PhoneInbox::isEmpty()
+{
+    return numWaiting() == 0;
+}
+
+uint32_t PhoneInbox::numWaiting(uint32_t *onFlash)
+{
+    concurrency::LockGuard guard(&lock);
+    uint32_t spilled = 0;
+#if PHONE_INBOX_SPILL_BYTES
+    spilled = numSpilled;
+#endif
+    if (onFlash)
+        *onFlash = spilled;
+    return numInRam + spilled;
+}
+
+NodeNum PhoneInbox::findDest(PacketId id)
+{
+    concurrency::LockGuard guard(&lock);
+    NodeNum dest = 0;
+    uint32_t at = readPos;
+    for (uint32_t i = 0; i < numInRam; i++) {
+        EntryHeader h;
+        ringRead(at, &h, sizeof(h));
+        if (h.id == id)
+            dest = h.to; // keep looking, like the old queue we want the newest match
+        at += sizeof(h) + h.len;
+    }
+    return dest;
+}
+
+#if PHONE_INBOX_SPILL_BYTES
+
+#define PHONE_INBOX_DIR "/inbox"
+#define PHONE_INBOX_SPILL_FILE PHONE_INBOX_DIR "/spill.log"
+
+#ifdef ARCH_NRF52
+#define FILE_O_APPEND FILE_O_WRITE // Adafruit LittleFS always opens for writing at the end of the file
+#else
+#define FILE_O_APPEND "a"
+#endif
+
+static const uint8_t RECORD_MAGIC = 0xa7;
+static const size_t RECORD_HEADER_SIZE = 8; // magic, reserved, payload len (2), crc32 (4)
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool PhoneInbox::spill(uint32_t at, size_t len)
+{
+    if (spillWritePos + RECORD_HEADER_SIZE + len > PHONE_INBOX_SPILL_BYTES)
+        return false;
+
+    if (spillWritePos == 0) {
+        // Starting a new log, whatever a previous run left behind is stale
+        FSCom.mkdir(PHONE_INBOX_DIR);
+        if (FSCom.exists(PHONE_INBOX_SPILL_FILE))
+            FSCom.remove(PHONE_INBOX_SPILL_FILE);
+        LOG_INFO("ToPhone queue is full, spill to flash");
+    }
+
+    // The payload may wrap around the end of the ring
+    at %= PHONE_INBOX_BYTES;
+    size_t first = std::min(len, (size_t)(PHONE_INBOX_BYTES - at));
+    uint8_t hdr[RECORD_HEADER_SIZE] = {RECORD_MAGIC, 0, (uint8_t)len, (uint8_t)(len >> 8)};
+    putU32(hdr + 4, crc32(ring, len - first, crc32(ring + at, first)));
+
+    auto f = FSCom.open(PHONE_INBOX_SPILL_FILE, FILE_O_APPEND);
+    if (!f) {
+        LOG_ERROR("Can't open %s", PHONE_INBOX_SPILL_FILE);
+        return false;
+    }
+    bool ok = f.write(hdr, sizeof(hdr)) == sizeof(hdr) && f.write(ring + at, first) == first &&
+              f.write(ring, len - first) == len - first;
+    f.close();
+
+    if (!ok) {
+        // The log may now end in a torn record, so don't append after it. popSpilled() stops there.
+        LOG_ERROR("Can't write %s", PHONE_INBOX_SPILL_FILE);
+        spillWritePos = PHONE_INBOX_SPILL_BYTES;
+        return false;
+    }
+    spillWritePos += RECORD_HEADER_SIZE + len;
+    numSpilled++;
+    return true;
+}
+
+size_t PhoneInbox::popSpilled(uint8_t *buf)
+{
+    uint8_t hdr[RECORD_HEADER_SIZE];
+    size_t len = 0;
+    auto f = FSCom.open(PHONE_INBOX_SPILL_FILE, FILE_O_READ);
+    bool ok = f && f.seek(spillReadPos) && f.read(hdr, sizeof(hdr)) == sizeof(hdr) && hdr[0] == RECORD_MAGIC;
+    if (ok) {
+        len = hdr[2] | (hdr[3] << 8);
+        // Read into encoded rather than buf, so buf is untouched if the record turns out to be bad
+        ok = len <= sizeof(encoded) && f.read(encoded, len) == len && crc32(encoded, len) == getU32(hdr + 4);
+    }
+    if (f)
+        f.close();
+
+    if (!ok) {
+        LOG_ERROR("Spilled ToPhone queue is damaged, drop %u packets", numSpilled);
+        stats.dropped += numSpilled;
+        clearSpill();
+        return 0;
+    }
+
+    memcpy(buf, encoded, len);
+    spillReadPos += RECORD_HEADER_SIZE + len;
+    if (--numSpilled == 0) {
+        LOG_INFO("Spilled ToPhone queue drained: queued=%u spilled=%u dropped=%u", stats.queued, stats.spilled, stats.dropped);
+        clearSpill();
+    }
+    return len;
+}
+
+void PhoneInbox::clearSpill()
+{
+    FSCom.remove(PHONE_INBOX_SPILL_FILE);
+    spillReadPos = spillWritePos = 0;
+    numSpilled = 0;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "MeshTypes.h"
+#include "concurrency/Lock.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+
+// RAM for packets waiting for the phone. They are kept protobuf encoded, so a short text costs tens of bytes instead of a whole
+// MeshPacket
+#ifndef PHONE_INBOX_BYTES
+#ifdef ARCH_PORTDUINO
+#define PHONE_INBOX_BYTES (64 * 1024)
+#else
+#define PHONE_INBOX_BYTES (4 * 1024)
+#endif
+#endif
+
+// Once that RAM is full the oldest packets move to a log on flash of at most this many bytes, 0 drops them instead
+#ifndef PHONE_INBOX_SPILL_BYTES
+#if !defined(FSCom) || defined(ARCH_NRF52) // InternalFS on nRF52 is already mostly taken by the node DB
+#define PHONE_INBOX_SPILL_BYTES 0
+#elif defined(ARCH_PORTDUINO)
+#define PHONE_INBOX_SPILL_BYTES (1024 * 1024)
+#else
+#define PHONE_INBOX_SPILL_BYTES (32 * 1024)
+#endif
+#endif
+
+struct PhoneInboxStats {
+    uint32_t queued;  // packets accepted for the phone
+    uint32_t spilled; // packets moved to flash because RAM was full
+    uint32_t dropped; // packets lost because RAM and flash were both full (or the flash log was damaged)
+};
+
+/**
+ * Packets received for the phone, waiting for a PhoneAPI session to download them.
+ *
+ * Each packet is encoded as the FromRadio frame the phone will get as soon as it is queued, and kept with a small header in a
+ * ring of PHONE_INBOX_BYTES. When the ring is full the oldest frames are appended to a log on flash, so a phone that was away
+ * overnight still gets everything in order once it reconnects: the flash log is drained first, then the ring. Only when the
+ * flash log is full too (or there is none) are packets dropped and counted. Text messages and range tests are kept over
+ * everything else, as the old queue did: a new one drops the oldest other packet still in RAM, or failing that the oldest
+ * text, while any other new packet is itself dropped.
+ *
+ * The flash log is thrown away on boot, like the in-RAM queue always was.
+ */
+class PhoneInbox
+{
+  public:
+    /// Queue a packet for the phone, making room by spilling or dropping older ones (or dropping this one, see above)
+    void push(const meshtastic_MeshPacket &p);
+
+    /**
+     * Copy the oldest waiting packet, as an encoded FromRadio, into buf (which must hold meshtastic_FromRadio_size bytes)
+     * @return its length, 0 if nothing is waiting (and then buf is left alone)
+     */
+    size_t pop(uint8_t *buf);
+
+    bool isEmpty();
+
+    /// Packets waiting, and how many of them are on flash
+    uint32_t numWaiting(uint32_t *onFlash = NULL);
+
+    /// Destination of the last waiting packet with this id, 0 if there is none. Only packets still in RAM are searched.
+    NodeNum findDest(PacketId id);
+
+    const PhoneInboxStats &getStats() const { return stats; }
+
+  private:
+    struct EntryHeader {
+        uint16_t len; // of the encoded FromRadio that follows
+        bool isText;  // a text message or range test, which only newer ones of those may push out
+        PacketId id;
+        NodeNum to;
+    };
+
+    uint8_t ring[PHONE_INBOX_BYTES];
+    uint32_t readPos = 0;   // offset of the oldest entry
+    uint32_t usedBytes = 0; // the next entry goes at readPos + usedBytes
+    uint32_t numInRam = 0;
+
+    /// The entry being pushed (it can't be encoded straight into the ring before we know how much room to make), or the one
+    /// being read back from flash
+    uint8_t encoded[meshtastic_FromRadio_size];
+
+#if PHONE_INBOX_SPILL_BYTES
+    uint32_t spillReadPos = 0, spillWritePos = 0;
+    uint32_t numSpilled = 0;
+
+    /// Append the entry payload at ring offset at to the flash log
+    bool spill(uint32_t at, size_t len);
+
+    /// Read the oldest packet from the flash log, 0 if it is damaged
+    size_t popSpilled(uint8_t *buf);
+
+    void clearSpill();
+#endif
+
+    PhoneInboxStats stats = {};
+
+    concurrency::Lock lock;
+
+    void ringWrite(uint32_t at, const void *src, size_t len);
+    void ringRead(uint32_t at, void *dst, size_t len) const;
+
+    /// Move the oldest entry in the ring to the flash log, false if it can't go there
+    bool spillOldest();
+
+    /// Lose the oldest entry in the ring that isn't a text, or the oldest text if there are only texts
+    void dropOldest();
+
+    /// Take the len byte entry at ring offset at out of the ring
+    void removeEntry(uint32_t at, size_t len);
+};
@@ -2,6 +2,7 @@
 #include "MeshTypes.h"
 #include "NodeDB.h"
 #include "PowerMon.h"
+#include "Router.h"
 #include "SPILock.h"
 #include "Throttle.h"
 #include "configuration.h"
@@ -371,6 +372,18 @@ void RadioLibInterface::completeSending()
     }
 }
 
+/// Router::perhapsHandleReceived() logs even duplicate packets when tracing, so they must reach it
+static bool traceAllPackets()
+{
+#if ENABLE_JSON_LOGGING
+    return true;
+#elif ARCH_PORTDUINO
+    return settingsStrings[traceFilename] != "" || settingsMap[logoutputlevel] == level_trace;
+#else
+    return false;
+#endif
+}
+
 void RadioLibInterface::handleReceiveInterrupt()
 {
     uint32_t xmitMsec;
@@ -426,6 +439,13 @@ void RadioLibInterface::handleReceiveInterrupt()
                 return;
             }
 
+            // Most of what we hear in a busy mesh is flood duplicates, let the router reject those from the header alone
+            // before we allocate a packet and queue it up (unless we're tracing every packet, which needs the full thing)
+            if (!traceAllPackets() && router && router->filterDuplicateHeader(radioBuffer.header, xmitMsec)) {
+                airTime->logAirtime(RX_LOG, xmitMsec);
+                return;
+            }
+
             // Note: we deliver _all_ packets to our router (i.e. our interface is intentionally promiscuous).
             // This allows the router and other apps on our node to sniff packets (usually routing) between other
             // nodes.
@@ -5,6 +5,7 @@
 #include "mesh-pb-constants.h"
 #include "modules/NodeInfoModule.h"
 #include "modules/RoutingModule.h"
+#include <algorithm>
 
 // ReliableRouter::ReliableRouter() {}
 
@@ -21,18 +22,18 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
         if (p->hop_limit == 0) {
             p->hop_limit = Default::getConfiguredOrDefaultHopLimit(config.lora.hop_limit);
         }
-
-        auto copy = packetPool.allocCopy(*p);
-        startRetransmission(copy);
     }
 
-    /* If we have pending retransmissions, add the airtime of this packet to it, because during that time we cannot receive an
-       (implicit) ACK. Otherwise, we might retransmit too early.
+    /* If we have pending retransmissions, add the airtime of this packet to them, because during that time we cannot receive an
+       (implicit) ACK. Otherwise, we might retransmit too early.  This is done before queuing p itself, so its own deadline is
+       not pushed back.
      */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        if (i->first.id != p->id) {
-            i->second.nextTxMsec += iface->getPacketTime(p);
-        }
+    if (!pending.empty())
+        airtimeDelay += iface->getPacketTime(p);
+
+    if (p->want_ack) {
+        auto copy = packetPool.allocCopy(*p);
+        startRetransmission(copy);
     }
 
     return FloodingRouter::send(p);
@@ -58,7 +59,8 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
             // marked as wantAck
             sendAckNak(meshtastic_Routing_Error_NONE, getFrom(p), p->id, old->packet->channel);
 
-            stopRetransmission(key);
+            if (stopRetransmission(key))
+                stats.acks++;
         } else {
             LOG_DEBUG("Didn't find pending packet");
         }
@@ -69,13 +71,23 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
        because while receiving this packet, we could not have received an (implicit) ACK for it.
        If we don't add this, we will likely retransmit too early.
     */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        i->second.nextTxMsec += iface->getPacketTime(p);
-    }
+    if (!pending.empty())
+        airtimeDelay += iface->getPacketTime(p);
 
     return FloodingRouter::shouldFilterReceived(p);
 }
 
+bool ReliableRouter::filterDuplicateHeader(const PacketHeader &h, uint32_t airtimeMsec)
+{
+    if (h.from == getNodeNum() || !FloodingRouter::filterDuplicateHeader(h, airtimeMsec))
+        return false;
+
+    // Same as shouldFilterReceived(): we couldn't have heard an ack while this was on the air
+    if (!pending.empty())
+        airtimeDelay += airtimeMsec;
+    return true;
+}
+
 /**
  * If we receive a want_ack packet (do not check for wasSeenRecently), send back an ack (this might generate multiple ack sends in
  * case the our first ack gets lost)
@@ -130,9 +142,11 @@ void ReliableRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
         if (ackId || nakId) {
             LOG_DEBUG("Received a %s for 0x%x, stopping retransmissions", ackId ? "ACK" : "NAK", ackId);
             if (ackId) {
-                stopRetransmission(p->to, ackId);
+                if (stopRetransmission(p->to, ackId))
+                    stats.acks++;
             } else {
-                stopRetransmission(p->to, nakId);
+                if (stopRetransmission(p->to, nakId))
+                    stats.naks++;
             }
         }
     }
@@ -179,6 +193,7 @@ bool ReliableRouter::stopRetransmission(GlobalPacketId key)
         }
         // now free the pooled copy for retransmission too
         packetPool.release(p);
+        // Any heap entry for this packet is left behind and skipped once it reaches the top
         auto numErased = pending.erase(key);
         assert(numErased == 1);
         return true;
@@ -192,14 +207,42 @@ bool ReliableRouter::stopRetransmission(GlobalPacketId key)
 PendingPacket *ReliableRouter::startRetransmission(meshtastic_MeshPacket *p)
 {
     auto id = GlobalPacketId(p);
-    auto rec = PendingPacket(p);
 
     stopRetransmission(getFrom(p), p->id);
 
-    setNextTx(&rec);
-    pending[id] = rec;
+    PendingPacket *rec = &(pending[id] = PendingPacket(p));
+    setNextTx(rec);
+
+    return rec;
+}
+
+/// Wrap-safe "a is due before b", valid while the two are within ~24 days of each other
+static bool isBefore(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/// Heap ordering: std::push_heap keeps the "largest" on top, so invert to get the earliest deadline there
+static bool isLaterTimer(const RetransmissionTimer &a, const RetransmissionTimer &b)
+{
+    return isBefore(b.dueMsec, a.dueMsec);
+}
+
+void ReliableRouter::scheduleTimer(PendingPacket *rec)
+{
+    rec->generation = ++nextGeneration;
+
+    // Cancelled and rescheduled packets leave entries behind, if they pile up (lots of fast acks) start afresh
+    if (timers.size() > 2 * pending.size() + 16) {
+        timers.clear();
+        for (auto &i : pending)
+            if (&i.second != rec)
+                timers.push_back({i.second.nextTxMsec, i.first, i.second.generation});
+        std::make_heap(timers.begin(), timers.end(), isLaterTimer);
+    }
 
-    return &pending[id];
+    timers.push_back({rec->nextTxMsec, GlobalPacketId(rec->packet), rec->generation});
+    std::push_heap(timers.begin(), timers.end(), isLaterTimer);
 }
 
 /**
@@ -208,56 +251,58 @@ PendingPacket *ReliableRouter::startRetransmission(meshtastic_MeshPacket *p)
 int32_t ReliableRouter::doRetransmissions()
 {
     uint32_t now = millis();
-    int32_t d = INT32_MAX;
-
-    // FIXME, we should use a better datastructure rather than walking through this map.
-    // for(auto el: pending) {
-    for (auto it = pending.begin(), nextIt = it; it != pending.end(); it = nextIt) {
-        ++nextIt; // we use this odd pattern because we might be deleting it...
-        auto &p = it->second;
-
-        bool stillValid = true; // assume we'll keep this record around
-
-        // FIXME, handle 51 day rollover here!!!
-        if (p.nextTxMsec <= now) {
-            if (p.numRetransmissions == 0) {
-                LOG_DEBUG("Reliable send failed, return a nak for fr=0x%x,to=0x%x,id=0x%x", p.packet->from, p.packet->to,
-                          p.packet->id);
-                sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p.packet), p.packet->id, p.packet->channel);
-                // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
-                stopRetransmission(it->first);
-                stillValid = false; // just deleted it
-            } else {
-                LOG_DEBUG("Send reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d", p.packet->from, p.packet->to,
-                          p.packet->id, p.numRetransmissions);
 
-                // Note: we call the superclass version because we don't want to have our version of send() add a new
-                // retransmission record
-                FloodingRouter::send(packetPool.allocCopy(*p.packet));
+    while (!timers.empty()) {
+        const RetransmissionTimer &top = timers.front();
+        auto p = findPendingPacket(top.key);
 
-                // Queue again
-                --p.numRetransmissions;
-                setNextTx(&p);
-            }
+        if (!p || p->generation != top.generation) {
+            // Acked/cancelled or rescheduled since this entry was pushed
+            std::pop_heap(timers.begin(), timers.end(), isLaterTimer);
+            timers.pop_back();
+            continue;
         }
 
-        if (stillValid) {
-            // Update our desired sleep delay
-            int32_t t = p.nextTxMsec - now;
+        uint32_t due = top.dueMsec + airtimeDelay;
+        if (isBefore(now, due))
+            return due - now; // Update our desired sleep delay
+
+        auto key = top.key;
+        std::pop_heap(timers.begin(), timers.end(), isLaterTimer);
+        timers.pop_back();
+
+        if (p->numRetransmissions == 0) {
+            LOG_DEBUG("Reliable send failed, return a nak for fr=0x%x,to=0x%x,id=0x%x", p->packet->from, p->packet->to,
+                      p->packet->id);
+            stats.timeouts++;
+            sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p->packet), p->packet->id, p->packet->channel);
+            // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
+            stopRetransmission(key);
+        } else {
+            LOG_DEBUG("Send reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d", p->packet->from, p->packet->to,
+                      p->packet->id, p->numRetransmissions);
+            stats.retries++;
 
-            d = min(t, d);
+            // Note: we call the superclass version because we don't want to have our version of send() add a new
+            // retransmission record
+            FloodingRouter::send(packetPool.allocCopy(*p->packet));
+
+            // Queue again
+            --p->numRetransmissions;
+            setNextTx(p);
         }
     }
 
-    return d;
+    return INT32_MAX;
 }
 
 void ReliableRouter::setNextTx(PendingPacket *pending)
 {
     assert(iface);
     auto d = iface->getRetransmissionMsec(pending->packet);
-    pending->nextTxMsec = millis() + d;
+    pending->nextTxMsec = millis() + d - airtimeDelay;
+    scheduleTimer(pending);
     LOG_DEBUG("Set next retransmission in %u msecs: ", d);
     printPacket("", pending->packet);
     setReceivedMessage(); // Run ASAP, so we can figure out our correct sleep time
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 
 #include "FloodingRouter.h"
 #include <unordered_map>
+#include <vector>
 
 /**
  * An identifier for a globally unique message - a pair of the sending nodenum and the packet id assigned
@@ -32,16 +33,43 @@ struct GlobalPacketId {
 struct PendingPacket {
     meshtastic_MeshPacket *packet;
 
-    /** The next time we should try to retransmit this packet */
+    /** The next time we should try to retransmit this packet, not counting ReliableRouter::airtimeDelay (see there) */
     uint32_t nextTxMsec = 0;
 
     /** Starts at NUM_RETRANSMISSIONS -1(normally 3) and counts down.  Once zero it will be removed from the list */
     uint8_t numRetransmissions = 0;
 
+    /**
+     * Set from ReliableRouter::nextGeneration each time we are (re)scheduled, so older entries for us in the retransmission
+     * heap can be recognized and skipped, even ones left by an earlier record for the same packet id
+     */
+    uint32_t generation = 0;
+
     PendingPacket() {}
     explicit PendingPacket(meshtastic_MeshPacket *p);
 };
 
+/**
+ * An entry in the retransmission heap.  Cancelling or rescheduling a packet doesn't touch the heap, the old entry is just
+ * dropped when it reaches the top and no longer matches its PendingPacket.
+ */
+struct RetransmissionTimer {
+    /** Same time base as PendingPacket::nextTxMsec */
+    uint32_t dueMsec;
+    GlobalPacketId key;
+    uint32_t generation;
+};
+
+/**
+ * Counters for how our reliable sends turned out
+ */
+struct ReliableRouterStats {
+    uint32_t retries;  // retransmissions sent
+    uint32_t timeouts; // packets that ran out of retransmissions
+    uint32_t acks;     // pending packets cleared by an explicit or implicit ack
+    uint32_t naks;     // pending packets cleared by a nak
+};
+
 class GlobalPacketIdHashFunction
 {
   public:
@@ -56,6 +84,21 @@ class ReliableRouter : public FloodingRouter
   private:
     std::unordered_map<GlobalPacketId, PendingPacket, GlobalPacketIdHashFunction> pending;
 
+    /** Min-heap (by wrap-safe due time) of scheduled retransmissions, may hold stale entries (see RetransmissionTimer) */
+    std::vector<RetransmissionTimer> timers;
+
+    /** Shared by all records rather than counted per record, so a stopped and restarted packet never reuses a generation */
+    uint32_t nextGeneration = 0;
+
+    /**
+     * Total airtime of the packets sent and received while something was pending.  Every pending deadline is pushed back by
+     * that airtime (we couldn't have heard an ack meanwhile), so rather than touching each record we keep deadlines relative
+     * to this and add it when comparing against millis().
+     */
+    uint32_t airtimeDelay = 0;
+
+    ReliableRouterStats stats = {};
+
   public:
     /**
      * Constructor
@@ -70,6 +113,11 @@ class ReliableRouter : public FloodingRouter
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    const ReliableRouterStats &getStats() const { return stats; }
+
+    /** Like FloodingRouter, but leaves rebroadcasts of our own packets (implicit acks) to shouldFilterReceived() */
+    virtual bool filterDuplicateHeader(const PacketHeader &h, uint32_t airtimeMsec) override;
+
     /** Do our retransmission handling */
     virtual int32_t runOnce() override
     {
@@ -120,4 +168,7 @@ class ReliableRouter : public FloodingRouter
     int32_t doRetransmissions();
 
     void setNextTx(PendingPacket *pending);
+
+    /** Push a heap entry for the pending packet's current nextTxMsec, superseding any older one */
+    void scheduleTimer(PendingPacket *rec);
 };
@@ -21,23 +21,39 @@
 #if ENABLE_JSON_LOGGING || ARCH_PORTDUINO
 #include "serialization/MeshPacketSerializer.h"
 #endif
+#if ARCH_PORTDUINO
+#include "DecodeWorkerPool.h"
+#endif
 
 #define MAX_RX_FROMRADIO                                                                                                         \
     4 // max number of packets destined to our queue, we dispatch packets quickly so it doesn't need to be big
 
-// I think this is right, one packet for each of the three fifos + one packet being currently assembled for TX or RX
+// I think this is right, one packet for each of the fifos + one packet being currently assembled for TX or RX
 // And every TX packet might have a retransmission packet or an ack alive at any moment
+// Packets for the phone don't count, MeshService keeps those encoded in its PhoneInbox
 #define MAX_PACKETS                                                                                                              \
-    (MAX_RX_TOPHONE + MAX_RX_FROMRADIO + 2 * MAX_TX_QUEUE +                                                                      \
-     2) // max number of packets which can be in flight (either queued from reception or queued for sending)
+    (MAX_RX_FROMRADIO + 2 * MAX_TX_QUEUE + 2) // max number of packets which can be in flight (either queued from reception or
+                                              // queued for sending)
 
-// static MemoryPool<MeshPacket> staticPool(MAX_PACKETS);
-static MemoryDynamic<meshtastic_MeshPacket> staticPool;
+// Packets are churned on every RX/TX/ack, so keep them in a fixed slab rather than fragmenting the heap.  If we ever have more
+// than MAX_PACKETS in flight the pool falls back to the heap.
+static MemoryPool<meshtastic_MeshPacket, MAX_PACKETS> staticPool;
 
 Allocator<meshtastic_MeshPacket> &packetPool = staticPool;
 
+void logPacketPoolStats()
+{
+    LOG_DEBUG("Packet pool: %u/%d in use, high water %u, %u heap fallbacks, %u failures", staticPool.getNumInUse(),
+              staticPool.capacity(), staticPool.getHighWaterMark(), staticPool.getSlabMisses(), staticPool.getAllocFailures());
+}
+
+// Scratch space for decrypting on the main thread (under cryptLock), decode workers have their own
 static uint8_t bytes[MAX_LORA_PAYLOAD_LEN + 1] __attribute__((__aligned__));
 
+#if ENABLE_JSON_LOGGING || ARCH_PORTDUINO
+static char traceJson[MESHPACKET_JSON_MAX_LEN]; // packets are traced as JSON, without going through the heap
+#endif
+
 /**
  * Constructor
  *
@@ -65,6 +81,22 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
 int32_t Router::runOnce()
 {
     meshtastic_MeshPacket *mp;
+#if ARCH_PORTDUINO
+    if (decodeWorkers) {
+        // Everything goes through the pool, even packets it won't decrypt itself, so we still handle them in arrival order
+        while (!decodeWorkers->isFull() && (mp = fromRadioQueue.dequeuePtr(0)) != NULL)
+            decodeWorkers->submit(mp);
+
+        const DecodeJob *job;
+        while ((job = decodeWorkers->front()) != NULL) {
+            perhapsHandleReceived(job->p, job->offloaded ? &job->result : NULL);
+            decodeWorkers->pop();
+        }
+
+        // A decryption only takes microseconds, so poll for the ones still in flight rather than having workers wake us
+        return decodeWorkers->isIdle() ? INT32_MAX : 1;
+    }
+#endif
     while ((mp = fromRadioQueue.dequeuePtr(0)) != NULL) {
         // printPacket("handle fromRadioQ", mp);
         perhapsHandleReceived(mp);
@@ -93,6 +125,18 @@ void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
     setReceivedMessage();
 }
 
+#if ARCH_PORTDUINO
+void Router::startDecodeWorkers(int numWorkers)
+{
+    if (decodeWorkers || numWorkers <= 0)
+        return;
+    if (numWorkers > DECODE_WORKERS_MAX)
+        numWorkers = DECODE_WORKERS_MAX;
+    LOG_INFO("Decrypt received packets on %d worker threads", numWorkers);
+    decodeWorkers = new DecodeWorkerPool(numWorkers);
+}
+#endif
+
 /// Generate a unique packet id
 // FIXME, move this someplace better
 PacketId generatePacketId()
@@ -302,7 +346,43 @@ void Router::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Rout
     // FIXME, update nodedb here for any packet that passes through us
 }
 
-bool perhapsDecode(meshtastic_MeshPacket *p)
+/**
+ * Cheap sanity check of a decrypted payload before attempting a full decode.  We (nanopb) always encode fields in tag order,
+ * and a Data with portnum UNKNOWN_APP is rejected anyway, so a valid payload must start with the varint key for portnum (field 1)
+ * followed by a nonzero value.
+ */
+static bool looksLikeData(const uint8_t *plaintext, size_t len)
+{
+    const uint8_t portnumKey = (meshtastic_Data_portnum_tag << 3) | PB_WT_VARINT;
+    return len >= 2 && plaintext[0] == portnumKey && plaintext[1] != 0;
+}
+
+ChannelDecodeResult decodeChannelPayload(CryptoEngine *engine, uint8_t *scratch, const meshtastic_MeshPacket *p, size_t rawSize,
+                                         meshtastic_Data *decoded)
+{
+    // we have to copy into a scratch buffer, because these bytes are a union with the decoded protobuf. Create a
+    // fresh copy for each decrypt attempt.
+    memcpy(scratch, p->encrypted.bytes, rawSize);
+    // Try to decrypt the packet if we can
+    engine->decrypt(p->from, p->id, rawSize, scratch);
+
+    // printBytes("plaintext", scratch, p->encrypted.size);
+
+    // Every Data we send starts with its (nonzero) portnum, so a wrong key almost always fails this cheap check
+    // before we pay for a full protobuf decode
+    if (!looksLikeData(scratch, rawSize))
+        return CHANNEL_DECODE_NOT_DATA;
+
+    // Take those raw bytes and convert them back into a well structured protobuf we can understand
+    memset(decoded, 0, sizeof(*decoded));
+    if (!pb_decode_from_bytes(scratch, rawSize, &meshtastic_Data_msg, decoded))
+        return CHANNEL_DECODE_BAD_PROTOBUF;
+    if (decoded->portnum == meshtastic_PortNum_UNKNOWN_APP)
+        return CHANNEL_DECODE_BAD_PORTNUM;
+    return CHANNEL_DECODE_OK;
+}
+
+bool perhapsDecode(meshtastic_MeshPacket *p, const PredecodedPayload *predecoded)
 {
     concurrency::LockGuard g(cryptLock);
 
@@ -326,11 +406,19 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
     }
     bool decrypted = false;
     ChannelIndex chIndex = 0;
+    if (predecoded) {
+        // A decode worker already tried every channel key for this hash, we only need to take its result
+        if (predecoded->ok) {
+            p->decoded = predecoded->decoded;
+            chIndex = predecoded->chIndex;
+            decrypted = true;
+        }
+    }
 #if !(MESHTASTIC_EXCLUDE_PKI)
     // Attempt PKI decryption first
-    if (p->channel == 0 && isToUs(p) && p->to > 0 && !isBroadcast(p->to) && nodeDB->getMeshNode(p->from) != nullptr &&
-        nodeDB->getMeshNode(p->from)->user.public_key.size > 0 && nodeDB->getMeshNode(p->to)->user.public_key.size > 0 &&
-        rawSize > MESHTASTIC_PKC_OVERHEAD) {
+    else if (p->channel == 0 && isToUs(p) && p->to > 0 && !isBroadcast(p->to) && nodeDB->getMeshNode(p->from) != nullptr &&
+             nodeDB->getMeshNode(p->from)->user.public_key.size > 0 && nodeDB->getMeshNode(p->to)->user.public_key.size > 0 &&
+             rawSize > MESHTASTIC_PKC_OVERHEAD) {
         LOG_DEBUG("Attempt PKI decryption");
 
         if (crypto->decryptCurve25519(p->from, nodeDB->getMeshNode(p->from)->user.public_key, p->id, rawSize, p->encrypted.bytes,
@@ -356,28 +444,22 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
 #endif
 
     // assert(p->which_payloadVariant == MeshPacket_encrypted_tag);
-    if (!decrypted) {
-        // Try to find a channel that works with this hash
-        for (chIndex = 0; chIndex < channels.getNumChannels(); chIndex++) {
+    if (!decrypted && !predecoded) {
+        // Try each channel that has this hash (usually there is only one)
+        uint8_t candidates = channels.getChannelsForHash(p->channel);
+        for (chIndex = 0; candidates; chIndex++, candidates >>= 1) {
             // Try to use this hash/channel pair
-            if (channels.decryptForHash(chIndex, p->channel)) {
-                // we have to copy into a scratch buffer, because these bytes are a union with the decoded protobuf. Create a
-                // fresh copy for each decrypt attempt.
-                memcpy(bytes, p->encrypted.bytes, rawSize);
-                // Try to decrypt the packet if we can
-                crypto->decrypt(p->from, p->id, rawSize, bytes);
-
-                // printBytes("plaintext", bytes, p->encrypted.size);
-
-                // Take those raw bytes and convert them back into a well structured protobuf we can understand
-                memset(&p->decoded, 0, sizeof(p->decoded));
-                if (!pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &p->decoded)) {
-                    LOG_ERROR("Invalid protobufs in received mesh packet id=0x%08x (bad psk?)!", p->id);
-                } else if (p->decoded.portnum == meshtastic_PortNum_UNKNOWN_APP) {
-                    LOG_ERROR("Invalid portnum (bad psk?)!");
-                } else {
+            if ((candidates & 1) && channels.decryptForHash(chIndex, p->channel)) {
+                ChannelDecodeResult result = decodeChannelPayload(crypto, bytes, p, rawSize, &p->decoded);
+                if (result == CHANNEL_DECODE_OK) {
                     decrypted = true;
                     break;
+                } else if (result == CHANNEL_DECODE_NOT_DATA) {
+                    LOG_DEBUG("Plaintext is not a Data for channel %d (bad psk?)", chIndex);
+                } else if (result == CHANNEL_DECODE_BAD_PROTOBUF) {
+                    LOG_ERROR("Invalid protobufs in received mesh packet id=0x%08x (bad psk?)!", p->id);
+                } else {
+                    LOG_ERROR("Invalid portnum (bad psk?)!");
                 }
             }
         }
@@ -411,10 +493,12 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
 
         printPacket("decoded message", p);
 #if ENABLE_JSON_LOGGING
-        LOG_TRACE("%s", MeshPacketSerializer::JsonSerialize(p, false).c_str());
+        if (MeshPacketSerializer::JsonSerialize(p, traceJson, sizeof(traceJson), false))
+            LOG_TRACE("%s", traceJson);
 #elif ARCH_PORTDUINO
         if (settingsStrings[traceFilename] != "" || settingsMap[logoutputlevel] == level_trace) {
-            LOG_TRACE("%s", MeshPacketSerializer::JsonSerialize(p, false).c_str());
+            if (MeshPacketSerializer::JsonSerialize(p, traceJson, sizeof(traceJson), false))
+                LOG_TRACE("%s", traceJson);
         }
 #endif
         return true;
@@ -566,7 +650,7 @@ NodeNum Router::getNodeNum()
  * Handle any packet that is received by an interface on this node.
  * Note: some packets may merely being passed through this node and will be forwarded elsewhere.
  */
-void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
+void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src, const PredecodedPayload *predecoded)
 {
     bool skipHandle = false;
     // Also, we should set the time from the ISR and it should have msec level resolution
@@ -575,7 +659,7 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
     meshtastic_MeshPacket *p_encrypted = packetPool.allocCopy(*p);
 
     // Take those raw bytes and convert them back into a well structured protobuf we can understand
-    bool decoded = perhapsDecode(p);
+    bool decoded = perhapsDecode(p, predecoded);
     if (decoded) {
         // parsing was successful, queue for our recipient
         if (src == RX_SRC_LOCAL)
@@ -630,41 +714,43 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
     packetPool.release(p_encrypted); // Release the encrypted packet
 }
 
-void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
+const char *Router::ignoredSenderReason(NodeNum from, bool viaMqtt)
+{
+    if (is_in_repeated(config.lora.ignore_incoming, from))
+        return "it is in our ignore list";
+
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(from);
+    if (node != NULL && node->is_ignored)
+        return "it is ignored";
+
+    if (from == NODENUM_BROADCAST)
+        return "the broadcast address";
+
+    if (config.lora.ignore_mqtt && viaMqtt)
+        return "it came in via MQTT";
+
+    return NULL;
+}
+
+void Router::perhapsHandleReceived(meshtastic_MeshPacket *p, const PredecodedPayload *predecoded)
 {
 #if ENABLE_JSON_LOGGING
     // Even ignored packets get logged in the trace
     p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
-    LOG_TRACE("%s", MeshPacketSerializer::JsonSerializeEncrypted(p).c_str());
+    if (MeshPacketSerializer::JsonSerializeEncrypted(p, traceJson, sizeof(traceJson)))
+        LOG_TRACE("%s", traceJson);
 #elif ARCH_PORTDUINO
     // Even ignored packets get logged in the trace
     if (settingsStrings[traceFilename] != "" || settingsMap[logoutputlevel] == level_trace) {
         p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
-        LOG_TRACE("%s", MeshPacketSerializer::JsonSerializeEncrypted(p).c_str());
+        if (MeshPacketSerializer::JsonSerializeEncrypted(p, traceJson, sizeof(traceJson)))
+            LOG_TRACE("%s", traceJson);
     }
 #endif
     // assert(radioConfig.has_preferences);
-    if (is_in_repeated(config.lora.ignore_incoming, p->from)) {
-        LOG_DEBUG("Ignore msg, 0x%x is in our ignore list", p->from);
-        packetPool.release(p);
-        return;
-    }
-
-    meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(p->from);
-    if (node != NULL && node->is_ignored) {
-        LOG_DEBUG("Ignore msg, 0x%x is ignored", p->from);
-        packetPool.release(p);
-        return;
-    }
-
-    if (p->from == NODENUM_BROADCAST) {
-        LOG_DEBUG("Ignore msg from broadcast address");
-        packetPool.release(p);
-        return;
-    }
-
-    if (config.lora.ignore_mqtt && p->via_mqtt) {
-        LOG_DEBUG("Msg came in via MQTT from 0x%x", p->from);
+    const char *ignoreReason = ignoredSenderReason(p->from, p->via_mqtt);
+    if (ignoreReason) {
+        LOG_DEBUG("Ignore msg from 0x%x, %s", p->from, ignoreReason);
         packetPool.release(p);
         return;
     }
@@ -677,6 +763,6 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 
     // Note: we avoid calling shouldFilterReceived if we are supposed to ignore certain nodes - because some overrides might
     // cache/learn of the existence of nodes (i.e. FloodRouter) that they should not
-    handleReceived(p);
+    handleReceived(p, RX_SRC_RADIO, predecoded);
     packetPool.release(p);
 }
\ No newline at end of file
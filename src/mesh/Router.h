@@ -8,6 +8,18 @@
 #include "RadioInterface.h"
 #include "concurrency/OSThread.h"
 
+class PacketHistory;
+#if ARCH_PORTDUINO
+class DecodeWorkerPool;
+#endif
+
+/// A channel packet that was decrypted ahead of time (i.e. by a DecodeWorkerPool), for perhapsDecode() to adopt
+struct PredecodedPayload {
+    bool ok; // false if none of the channel keys produced a valid Data
+    ChannelIndex chIndex;
+    meshtastic_Data decoded;
+};
+
 /**
  * A mesh aware router that supports multiple interfaces.
  */
@@ -82,10 +94,31 @@ class Router : protected concurrency::OSThread
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p);
 
+    /**
+     * Called by the radio with just the header of a packet it has received, before anything is allocated for it.
+     *
+     * @return true if this is a duplicate which has been fully dealt with here, so the radio can drop it
+     */
+    virtual bool filterDuplicateHeader(const PacketHeader &h, uint32_t airtimeMsec) { return false; }
+
     /* Statistics for the amount of duplicate received packets and the amount of times we cancel a relay because someone did it
         before us */
     uint32_t rxDupe = 0, txRelayCanceled = 0;
 
+    /// How many of rxDupe were rejected by filterDuplicateHeader() without ever becoming a MeshPacket
+    uint32_t rxDupeHeaderOnly = 0;
+
+    /// The record of recently seen packets duplicates are detected with, NULL if this router keeps none
+    virtual const PacketHistory *getPacketHistory() const { return NULL; }
+
+#if ARCH_PORTDUINO
+    /**
+     * Decrypt received channel packets on this many worker threads instead of on the main thread.  Everything after the
+     * decryption (filters, modules, MQTT, the phone) still happens here in runOnce(), in the order the packets arrived.
+     */
+    void startDecodeWorkers(int numWorkers);
+#endif
+
   protected:
     friend class RoutingModule;
 
@@ -99,6 +132,14 @@ class Router : protected concurrency::OSThread
      */
     virtual bool shouldFilterReceived(const meshtastic_MeshPacket *p) { return false; }
 
+    /**
+     * Why we ignore everything from this sender (our ignore lists, the broadcast address or MQTT when ignore_mqtt is set)
+     *
+     * Such packets are dropped before shouldFilterReceived(), so nothing learns of them.
+     * @return NULL if we don't
+     */
+    static const char *ignoredSenderReason(NodeNum from, bool viaMqtt);
+
     /**
      * Every (non duplicate) packet this node receives will be passed through this method.  This allows subclasses to
      * update routing tables etc... based on what we overhear (even for messages not destined to our node)
@@ -111,6 +152,10 @@ class Router : protected concurrency::OSThread
     void sendAckNak(meshtastic_Routing_Error err, NodeNum to, PacketId idFrom, ChannelIndex chIndex, uint8_t hopLimit = 0);
 
   private:
+#if ARCH_PORTDUINO
+    DecodeWorkerPool *decodeWorkers = NULL;
+#endif
+
     /**
      * Called from loop()
      * Handle any packet that is received by an interface on this node.
@@ -118,8 +163,9 @@ class Router : protected concurrency::OSThread
      *
      * Note: this packet will never be called for messages sent/generated by this node.
      * Note: this method will free the provided packet.
+     * @param predecoded if not NULL, the already decrypted payload of p
      */
-    void perhapsHandleReceived(meshtastic_MeshPacket *p);
+    void perhapsHandleReceived(meshtastic_MeshPacket *p, const PredecodedPayload *predecoded = NULL);
 
     /**
      * Called from perhapsHandleReceived() - allows subclass message delivery behavior.
@@ -129,7 +175,7 @@ class Router : protected concurrency::OSThread
      * Note: this packet will never be called for messages sent/generated by this node.
      * Note: this method will free the provided packet.
      */
-    void handleReceived(meshtastic_MeshPacket *p, RxSource src = RX_SRC_RADIO);
+    void handleReceived(meshtastic_MeshPacket *p, RxSource src = RX_SRC_RADIO, const PredecodedPayload *predecoded = NULL);
 
     /** Frees the provided packet, and generates a NAK indicating the specifed error while sending */
     void abortSendAndNak(meshtastic_Routing_Error err, meshtastic_MeshPacket *p);
@@ -138,9 +184,26 @@ class Router : protected concurrency::OSThread
 /** FIXME - move this into a mesh packet class
  * Remove any encryption and decode the protobufs inside this packet (if necessary).
  *
+ * @param predecoded if not NULL, use this result of decrypting p with the channel keys instead of decrypting it here
  * @return true for success, false for corrupt packet.
  */
-bool perhapsDecode(meshtastic_MeshPacket *p);
+bool perhapsDecode(meshtastic_MeshPacket *p, const PredecodedPayload *predecoded = NULL);
+
+/// Outcome of decodeChannelPayload()
+enum ChannelDecodeResult {
+    CHANNEL_DECODE_OK,
+    CHANNEL_DECODE_NOT_DATA,     // the plaintext doesn't even start like a Data
+    CHANNEL_DECODE_BAD_PROTOBUF, // pb_decode failed
+    CHANNEL_DECODE_BAD_PORTNUM   // decoded, but to portnum UNKNOWN_APP
+};
+
+/**
+ * Decrypt the first rawSize bytes of p->encrypted with the key the engine is currently set to and decode them into decoded.
+ * scratch must hold at least MAX_LORA_PAYLOAD_LEN + 1 bytes.  Doesn't log or touch any globals, so decode workers can call this
+ * with their own engine and scratch buffer.
+ */
+ChannelDecodeResult decodeChannelPayload(CryptoEngine *engine, uint8_t *scratch, const meshtastic_MeshPacket *p, size_t rawSize,
+                                         meshtastic_Data *decoded);
 
 /** Return 0 for success or a Routing_Error code for failure
  */
@@ -22,9 +22,10 @@ int32_t StreamAPI::runOncePart()
 int32_t StreamAPI::readStream()
 {
     if (!stream->available()) {
-        // Nothing available this time, if the computer has talked to us recently, poll often, otherwise let CPU sleep a long time
-        bool recentRx = Throttle::isWithinTimespanMs(lastRxMsec, 2000);
-        return recentRx ? 5 : 250;
+        // Nothing available this time. Right after the computer talked to us poll often, then back off to let the CPU sleep
+        uint32_t wait = rxPollMsec;
+        rxPollMsec = min(rxPollMsec * 2, (uint32_t)STREAM_API_SLOW_POLL_MSEC);
+        return wait;
     } else {
         while (stream->available()) { // Currently we never want to block
             int cInt = stream->read();
@@ -71,7 +72,7 @@ int32_t StreamAPI::readStream()
         }
 
         // we had bytes available this time, so assume we might have them next time also
-        lastRxMsec = millis();
+        rxPollMsec = STREAM_API_FAST_POLL_MSEC;
         return 0;
     }
 }
@@ -84,7 +85,9 @@ void StreamAPI::writeStream()
     if (canWrite) {
         uint32_t len;
         do {
-            // Send every packet we can
+            // Send every packet we can, stopping early if the link can't take any more right now
+            if (!hasTxRoom())
+                break;
             len = getFromRadio(txBuf + HEADER_LEN);
             emitTxBuffer(len);
         } while (len);
@@ -102,12 +105,16 @@ void StreamAPI::emitTxBuffer(size_t len)
         txBuf[2] = (len >> 8) & 0xff;
         txBuf[3] = len & 0xff;
 
-        auto totalLen = len + HEADER_LEN;
-        stream->write(txBuf, totalLen);
-        stream->flush();
+        writeFrame(txBuf, len + HEADER_LEN);
     }
 }
 
+void StreamAPI::writeFrame(const uint8_t *frame, size_t len)
+{
+    stream->write(frame, len);
+    stream->flush();
+}
+
 void StreamAPI::emitRebooted()
 {
     // In case we send a FromRadio packet
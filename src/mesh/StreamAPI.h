@@ -8,6 +8,15 @@
 // A To/FromRadio packet + our 32 bit header
 #define MAX_STREAM_BUF_SIZE (MAX_TO_FROM_RADIO_SIZE + sizeof(uint32_t))
 
+// How often we look for bytes from the client: fast right after it sent us something, doubling each time we find nothing until
+// we reach the slow rate an idle link stays at
+#ifndef STREAM_API_FAST_POLL_MSEC
+#define STREAM_API_FAST_POLL_MSEC 5
+#endif
+#ifndef STREAM_API_SLOW_POLL_MSEC
+#define STREAM_API_SLOW_POLL_MSEC 250
+#endif
+
 /**
  * A version of our 'phone' API that talks over a Stream.  So therefore well suited to use with serial links
  * or TCP connections.
@@ -39,8 +48,8 @@ class StreamAPI : public PhoneAPI
     uint8_t rxBuf[MAX_STREAM_BUF_SIZE] = {0};
     size_t rxPtr = 0;
 
-    /// time of last rx, used, to slow down our polling if we haven't heard from anyone
-    uint32_t lastRxMsec = 0;
+    /// how long to wait before looking for rx again, grows while the link is quiet
+    uint32_t rxPollMsec = STREAM_API_SLOW_POLL_MSEC;
 
   public:
     StreamAPI(Stream *_stream) : stream(_stream) {}
@@ -78,6 +87,17 @@ class StreamAPI : public PhoneAPI
      */
     void emitTxBuffer(size_t len);
 
+    /**
+     * Deliver one fully framed packet, by default straight to the stream.  Subclasses may queue it instead.
+     */
+    virtual void writeFrame(const uint8_t *frame, size_t len);
+
+    /**
+     * Subclasses that queue outbound frames (i.e. ServerAPI) return false while they cannot accept another full frame, so
+     * writeStream() leaves packets waiting in the PhoneAPI instead of pulling them for a stalled link
+     */
+    virtual bool hasTxRoom() { return true; }
+
     /// Are we allowed to write packets to our output stream (subclasses can turn this off - i.e. SerialConsole)
     bool canWrite = true;
 
@@ -1,4 +1,5 @@
 #include "ServerAPI.h"
+#include "Throttle.h"
 #include "configuration.h"
 #include <Arduino.h>
 
@@ -16,6 +17,7 @@ template <typename T> ServerAPI<T>::~ServerAPI()
 template <typename T> void ServerAPI<T>::close()
 {
     client.stop(); // drop tcp connection
+    txQueueLen = 0;
     StreamAPI::close();
 }
 
@@ -25,26 +27,86 @@ template <typename T> bool ServerAPI<T>::checkIsConnected()
     return client.connected();
 }
 
+template <typename T> void ServerAPI<T>::writeFrame(const uint8_t *frame, size_t len)
+{
+    if (txQueueLen + len > sizeof(txQueue)) {
+        // Only unsolicited frames (log records) can get here, writeStream() stops pulling packets while we are full
+        droppedFrames++;
+        return;
+    }
+    if (txQueueLen == 0)
+        lastDrainMsec = millis();
+    memcpy(txQueue + txQueueLen, frame, len);
+    txQueueLen += len;
+}
+
+template <typename T> bool ServerAPI<T>::drainTxQueue()
+{
+    if (txQueueLen == 0)
+        return true;
+
+    size_t written = client.write(txQueue, txQueueLen);
+    if (written > 0) {
+        client.flush();
+        if (written < txQueueLen)
+            memmove(txQueue, txQueue + written, txQueueLen - written);
+        txQueueLen -= written;
+        lastDrainMsec = millis();
+        return true;
+    }
+
+    return Throttle::isWithinTimespanMs(lastDrainMsec, SERVER_API_STALL_TIMEOUT_MS);
+}
+
 template <class T> int32_t ServerAPI<T>::runOnce()
 {
     if (client.connected()) {
-        return StreamAPI::runOncePart();
+        auto result = StreamAPI::runOncePart();
+        if (!drainTxQueue()) {
+            LOG_WARN("API client stalled for %us, %u frames dropped, disconnect", SERVER_API_STALL_TIMEOUT_MS / 1000,
+                     droppedFrames);
+        } else {
+            // Poll quickly while we still have bytes waiting on the socket
+            return txQueueLen ? 5 : result;
+        }
     } else {
         LOG_INFO("Client dropped connection, suspend API service");
-        enabled = false; // we no longer need to run
-        return 0;
     }
+    close();
+    enabled = false; // we no longer need to run, APIServerPort will delete us
+    return 0;
 }
 
 template <class T, class U> APIServerPort<T, U>::APIServerPort(int port) : U(port), concurrency::OSThread("ApiServer") {}
 
+template <class T, class U> APIServerPort<T, U>::~APIServerPort()
+{
+    for (int i = 0; i < numOpen; i++)
+        delete openAPIs[i];
+    numOpen = 0;
+}
+
 template <class T, class U> void APIServerPort<T, U>::init()
 {
     U::begin();
 }
 
+template <class T, class U> void APIServerPort<T, U>::reapClosed()
+{
+    int kept = 0;
+    for (int i = 0; i < numOpen; i++) {
+        if (openAPIs[i]->isFinished())
+            delete openAPIs[i];
+        else
+            openAPIs[kept++] = openAPIs[i];
+    }
+    numOpen = kept;
+}
+
 template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
 {
+    reapClosed();
+
 #ifdef ARCH_ESP32
 #if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 0)
     auto client = U::accept();
@@ -55,8 +117,8 @@ template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
     auto client = U::available();
 #endif
     if (client) {
-        // Close any previous connection (see FIXME in header file)
-        if (openAPI) {
+        // Out of slots, close the oldest session to make room (with a single slot this is the old one-client behaviour)
+        if (numOpen == MAX_SERVER_API_CLIENTS) {
 #if RAK_4631
             // RAK13800 Ethernet requests periodically take more time
             // This backoff addresses most cases keeping max wait < 1s
@@ -67,15 +129,19 @@ template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
                 return waitTime;
             }
 #endif
-            LOG_INFO("Force close previous TCP connection");
-            delete openAPI;
+            LOG_INFO("All %d API slots in use, force close oldest TCP connection", MAX_SERVER_API_CLIENTS);
+            delete openAPIs[0];
+            memmove(openAPIs, openAPIs + 1, (numOpen - 1) * sizeof(openAPIs[0]));
+            numOpen--;
         }
 
-        openAPI = new T(client);
+        openAPIs[numOpen++] = new T(client);
+        LOG_DEBUG("%d API clients connected", numOpen);
     }
 
 #if RAK_4631
     waitTime = 100;
 #endif
-    return 100; // only check occasionally for incoming connections
+    // Several clients may be connecting at once, drain the accept backlog before going back to slow polling
+    return client ? 0 : 100; // only check occasionally for incoming connections
 }
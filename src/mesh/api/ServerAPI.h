@@ -4,15 +4,53 @@
 
 #define SERVER_API_DEFAULT_PORT 4403
 
+// How many TCP API clients may be connected at once.  When all slots are taken the oldest session is closed to make room.
+#ifndef MAX_SERVER_API_CLIENTS
+#ifdef ARCH_PORTDUINO
+#define MAX_SERVER_API_CLIENTS 64
+#else
+#define MAX_SERVER_API_CLIENTS 1
+#endif
+#endif
+static_assert(MAX_SERVER_API_CLIENTS >= 1, "MAX_SERVER_API_CLIENTS must allow at least one client");
+
+// Bytes of encoded frames each session may have waiting for its socket
+#ifndef SERVER_API_TX_QUEUE_SIZE
+#ifdef ARCH_PORTDUINO
+#define SERVER_API_TX_QUEUE_SIZE (8 * MAX_STREAM_BUF_SIZE)
+#else
+#define SERVER_API_TX_QUEUE_SIZE (2 * MAX_STREAM_BUF_SIZE)
+#endif
+#endif
+
+// A client whose queue has not drained at all for this long is disconnected
+#ifndef SERVER_API_STALL_TIMEOUT_MS
+#define SERVER_API_STALL_TIMEOUT_MS (30 * 1000)
+#endif
+
 /**
  * Provides both debug printing and, if the client starts sending protobufs to us, switches to send/receive protobufs
  * (and starts dropping debug printing - FIXME, eventually those prints should be encapsulated in protobufs).
+ *
+ * Outbound frames go through a small per-session queue, so one slow reader only ever holds back its own packets.
  */
 template <class T> class ServerAPI : public StreamAPI, private concurrency::OSThread
 {
   private:
     T client;
 
+    uint8_t txQueue[SERVER_API_TX_QUEUE_SIZE];
+    size_t txQueueLen = 0;
+
+    /// When the queue last made progress (or became non-empty)
+    uint32_t lastDrainMsec = 0;
+
+    /// Frames we had to discard because the queue was full (log records only, packets wait in the PhoneAPI instead)
+    uint32_t droppedFrames = 0;
+
+    /// Push as much of txQueue to the socket as it will take, returns false if the client has stalled for too long
+    bool drainTxQueue();
+
   public:
     explicit ServerAPI(T &_client);
 
@@ -21,6 +59,9 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
     /// override close to also shutdown the TCP link
     virtual void close();
 
+    /// True once the remote end has gone away and this session can be deleted
+    bool isFinished() const { return !enabled; }
+
   protected:
     /// We override this method to prevent publishing EVENT_SERIAL_CONNECTED/DISCONNECTED for wifi links (we want the board to
     /// stay in the POWERED state to prevent disabling wifi)
@@ -30,6 +71,14 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
 
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override;
+
+    /// Queue the frame rather than writing it straight to the socket
+    virtual void writeFrame(const uint8_t *frame, size_t len) override;
+
+    virtual bool hasTxRoom() override { return txQueueLen + MAX_STREAM_BUF_SIZE <= sizeof(txQueue); }
+
+    /// Send packets for the client right away rather than at our next poll for rx
+    virtual void onNowHasData(uint32_t fromRadioNum) override { setIntervalFromNow(0); }
 };
 
 /**
@@ -37,20 +86,22 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
  */
 template <class T, class U> class APIServerPort : public U, private concurrency::OSThread
 {
-    /** The currently open port
-     *
-     * FIXME: We currently only allow one open TCP connection at a time, because we depend on the loop() call in this class to
-     * delegate to the worker.  Once coroutines are implemented we can relax this restriction.
-     */
-    T *openAPI = NULL;
+    /** The currently open sessions, oldest first. Each one is its own OSThread, we only create and reap them here. */
+    T *openAPIs[MAX_SERVER_API_CLIENTS] = {};
+    int numOpen = 0;
 #if RAK_4631
     // Track wait time for RAK13800 Ethernet requests
     int32_t waitTime = 100;
 #endif
 
+    /// Delete sessions whose client has disconnected
+    void reapClosed();
+
   public:
     explicit APIServerPort(int port);
 
+    virtual ~APIServerPort();
+
     void init();
 
   protected:
@@ -37,14 +37,18 @@ mail:   marchammermann@googlemail.com
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PiWebServer.h"
+#include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketHistory.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
 #include "airtime.h"
+#include "concurrency/OSThread.h"
 #include "graphics/Screen.h"
 #include "main.h"
 #include "mesh/wifi/WiFiAPClient.h"
+#include "serialization/JSONWriter.h"
 #include "sleep.h"
 #include <openssl/bn.h>
 #include <openssl/evp.h>
@@ -301,6 +305,116 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
     return U_CALLBACK_COMPLETE;
 }
 
+/// Send what json holds, or a 500 if it didn't fit in its buffer
+static int sendJSONResponse(struct _u_response *res, const JSONWriter &json, const char *buf)
+{
+    if (json.overflowed()) {
+        ulfius_set_string_body_response(res, 500, "Response too big");
+        return U_CALLBACK_COMPLETE;
+    }
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, buf);
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * Runtime accounting for every OSThread, see OSThreadStats
+ */
+int handleThreadStats(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    char buf[8192];
+    JSONWriter json(buf, sizeof(buf));
+
+    json.beginObject();
+    json.member("uptime_ms", millis());
+    json.member("wakeups_per_hour", concurrency::mainDelay.getWakeupsPerHour());
+    json.key("threads");
+    json.beginArray();
+    for (const concurrency::OSThread *t = concurrency::OSThread::getFirst(); t; t = t->getNext()) {
+        const concurrency::OSThreadStats &stats = t->getStats();
+        json.beginObject();
+        json.member("name", t->ThreadName.c_str());
+        json.member("runs", stats.runs);
+        json.member("total_ms", stats.totalUs / 1000);
+        json.member("max_us", stats.maxUs);
+        json.member("late_total_ms", stats.totalLateMs);
+        json.member("late_max_ms", stats.maxLateMs);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    return sendJSONResponse(res, json, buf);
+}
+
+/*
+ * Packets waiting for the phone, see PhoneInboxStats
+ */
+int handlePhoneInboxStats(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    char buf[512];
+    JSONWriter json(buf, sizeof(buf));
+
+    json.beginObject();
+    if (service) {
+        const PhoneInboxStats &inbox = service->getPhoneInboxStats();
+        uint32_t onFlash;
+        json.member("waiting", service->getNumWaitingForPhone(&onFlash));
+        json.member("on_flash", onFlash);
+        json.member("queued", inbox.queued);
+        json.member("spilled", inbox.spilled);
+        json.member("dropped", inbox.dropped);
+    }
+    json.endObject();
+    return sendJSONResponse(res, json, buf);
+}
+
+/*
+ * Flash writes of the node DB, see NodeDBJournalStats
+ */
+int handleNodeDBStats(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    char buf[512];
+    JSONWriter json(buf, sizeof(buf));
+
+    json.beginObject();
+#if NODEDB_JOURNAL
+    if (nodeDB) {
+        const NodeDBJournal &journal = nodeDB->getJournal();
+        json.member("bytes_per_hour", journal.getBytesPerHour());
+        json.member("journal_bytes", journal.getStats().journalBytes);
+        json.member("appends", journal.getStats().appends);
+        json.member("snapshots", journal.getStats().snapshots);
+        json.member("last_save_ms", journal.getStats().lastSaveMs);
+        json.member("max_save_ms", journal.getStats().maxSaveMs);
+    }
+#endif
+    json.endObject();
+    return sendJSONResponse(res, json, buf);
+}
+
+/*
+ * Duplicate detection records, see PacketHistoryStats
+ */
+int handlePacketHistoryStats(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    char buf[512];
+    JSONWriter json(buf, sizeof(buf));
+
+    json.beginObject();
+    const PacketHistory *history = router ? router->getPacketHistory() : NULL;
+    if (history) {
+        const PacketHistoryStats &stats = history->getStats();
+        json.member("occupancy", history->getOccupancy());
+        json.member("capacity", history->getCapacity());
+        json.member("lookups", stats.lookups);
+        json.member("hits", stats.hits);
+        json.member("inserts", stats.inserts);
+        json.member("evicted_live", stats.evictedLive);
+    }
+    json.endObject();
+    return sendJSONResponse(res, json, buf);
+}
+
 /*
 OpenSSL RSA Key Gen
 */
@@ -501,6 +615,10 @@ PiWebServerThread::PiWebServerThread()
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, configWeb.rootPath);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/threads", 1, &handleThreadStats, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/phone_inbox", 1, &handlePhoneInboxStats, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/nodedb", 1, &handleNodeDBStats, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/packet_history", 1, &handlePacketHistoryStats, NULL);
 
         // Add callback function to all endpoints for the Web Server
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", NULL, "/*", 2, &callback_static_file, &configWeb);
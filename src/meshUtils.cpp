@@ -1,5 +1,8 @@
 #include "meshUtils.h"
 #include <string.h>
+#ifdef ARCH_ESP32
+#include <esp_rom_crc.h>
+#endif
 
 /*
  * Find the first occurrence of find in s, where the search is limited to the
@@ -94,6 +97,26 @@ bool isOneOf(int item, int count, ...)
     return found;
 }
 
+uint32_t crc32(const uint8_t *buf, size_t len, uint32_t crc)
+{
+#ifdef ARCH_ESP32
+    // The ROM has a table driven one, which costs us no flash
+    return esp_rom_crc32_le(crc, buf, len);
+#else
+    // Half a byte at a time, SafeFile runs whole files through this but a 256 entry table is more flash than it is worth
+    static const uint32_t nibbleTable[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                             0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                             0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        crc = (crc >> 4) ^ nibbleTable[crc & 0x0f];
+        crc = (crc >> 4) ^ nibbleTable[crc & 0x0f];
+    }
+    return ~crc;
+#endif
+}
+
 const std::string vformat(const char *const zcFormat, ...)
 {
     va_list vaArgs;
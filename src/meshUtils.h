@@ -24,6 +24,9 @@ bool memfll(const uint8_t *mem, uint8_t find, size_t numbytes);
 
 bool isOneOf(int item, int count, ...);
 
+/// Standard CRC-32 (IEEE, as zlib), pass the previous result as crc to continue over several buffers
+uint32_t crc32(const uint8_t *buf, size_t len, uint32_t crc = 0);
+
 const std::string vformat(const char *const zcFormat, ...);
 
 #define IS_ONE_OF(item, ...) isOneOf(item, sizeof((int[]){__VA_ARGS__}) / sizeof(int), __VA_ARGS__)
@@ -282,6 +282,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->set_favorite_node);
         if (node != NULL) {
             node->is_favorite = true;
+            nodeDB->updateEvictionClass(r->set_favorite_node);
             saveChanges(SEGMENT_DEVICESTATE, false);
         }
         break;
@@ -291,6 +292,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->remove_favorite_node);
         if (node != NULL) {
             node->is_favorite = false;
+            nodeDB->updateEvictionClass(r->remove_favorite_node);
             saveChanges(SEGMENT_DEVICESTATE, false);
         }
         break;
@@ -302,8 +304,13 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
             node->is_ignored = true;
             node->has_device_metrics = false;
             node->has_position = false;
+#if !(MESHTASTIC_EXCLUDE_PKI)
+            if (node->user.public_key.size > 0)
+                crypto->forgetSharedKey(node->user.public_key.bytes);
+#endif
             node->user.public_key.size = 0;
             node->user.public_key.bytes[0] = 0;
+            nodeDB->updateEvictionClass(r->set_ignored_node);
             saveChanges(SEGMENT_DEVICESTATE, false);
         }
         break;
@@ -313,6 +320,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->remove_ignored_node);
         if (node != NULL) {
             node->is_ignored = false;
+            nodeDB->updateEvictionClass(r->remove_ignored_node);
             saveChanges(SEGMENT_DEVICESTATE, false);
         }
         break;
@@ -40,25 +40,36 @@
 #include "Sensor/TSL2591Sensor.h"
 #include "Sensor/VEML7700Sensor.h"
 
-BMP085Sensor bmp085Sensor;
-BMP280Sensor bmp280Sensor;
-BME280Sensor bme280Sensor;
-BME680Sensor bme680Sensor;
-MCP9808Sensor mcp9808Sensor;
-SHTC3Sensor shtc3Sensor;
-LPS22HBSensor lps22hbSensor;
-SHT31Sensor sht31Sensor;
-VEML7700Sensor veml7700Sensor;
-TSL2591Sensor tsl2591Sensor;
-OPT3001Sensor opt3001Sensor;
-SHT4XSensor sht4xSensor;
-RCWL9620Sensor rcwl9620Sensor;
-AHT10Sensor aht10Sensor;
-MLX90632Sensor mlx90632Sensor;
-DFRobotLarkSensor dfRobotLarkSensor;
-NAU7802Sensor nau7802Sensor;
-BMP3XXSensor bmp3xxSensor;
-CGRadSensSensor cgRadSens;
+#define NEW_SENSOR(type, Class) {meshtastic_TelemetrySensorType_##type, []() -> TelemetrySensor * { return new Class(); }}
+// Owned by Power, which reads them for PowerTelemetry too
+#define SHARED_SENSOR(type, instance) {meshtastic_TelemetrySensorType_##type, []() -> TelemetrySensor * { return &instance; }}
+
+// Every sensor kind we can read, only the ones ScanI2C found get created. Later ones win when several measure the same thing.
+static const TelemetrySensorFactory environmentSensors[] = {
+    NEW_SENSOR(DFROBOT_LARK, DFRobotLarkSensor),
+    NEW_SENSOR(SHT31, SHT31Sensor),
+    NEW_SENSOR(SHT4X, SHT4XSensor),
+    NEW_SENSOR(LPS22, LPS22HBSensor),
+    NEW_SENSOR(SHTC3, SHTC3Sensor),
+    NEW_SENSOR(BMP085, BMP085Sensor),
+    NEW_SENSOR(BMP280, BMP280Sensor),
+    NEW_SENSOR(BME280, BME280Sensor),
+    NEW_SENSOR(BMP3XX, BMP3XXSensor),
+    NEW_SENSOR(BME680, BME680Sensor),
+    NEW_SENSOR(MCP9808, MCP9808Sensor),
+    SHARED_SENSOR(INA219, ina219Sensor),
+    SHARED_SENSOR(INA260, ina260Sensor),
+    SHARED_SENSOR(INA3221, ina3221Sensor),
+    NEW_SENSOR(VEML7700, VEML7700Sensor),
+    NEW_SENSOR(TSL25911FN, TSL2591Sensor),
+    NEW_SENSOR(OPT3001, OPT3001Sensor),
+    NEW_SENSOR(MLX90632, MLX90632Sensor),
+    NEW_SENSOR(RCWL9620, RCWL9620Sensor),
+    NEW_SENSOR(NAU7802, NAU7802Sensor),
+    NEW_SENSOR(AHT10, AHT10Sensor),
+    SHARED_SENSOR(MAX17048, max17048Sensor),
+    NEW_SENSOR(RADSENS, CGRadSensSensor),
+};
 #endif
 #ifdef T1000X_SENSOR_EN
 #include "Sensor/T1000xSensor.h"
@@ -113,52 +124,9 @@ int32_t EnvironmentTelemetryModule::runOnce()
 #ifdef T1000X_SENSOR_EN
             result = t1000xSensor.runOnce();
 #elif !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
-            if (dfRobotLarkSensor.hasSensor())
-                result = dfRobotLarkSensor.runOnce();
-            if (bmp085Sensor.hasSensor())
-                result = bmp085Sensor.runOnce();
-            if (bmp280Sensor.hasSensor())
-                result = bmp280Sensor.runOnce();
-            if (bme280Sensor.hasSensor())
-                result = bme280Sensor.runOnce();
-            if (bmp3xxSensor.hasSensor())
-                result = bmp3xxSensor.runOnce();
-            if (bme680Sensor.hasSensor())
-                result = bme680Sensor.runOnce();
-            if (mcp9808Sensor.hasSensor())
-                result = mcp9808Sensor.runOnce();
-            if (shtc3Sensor.hasSensor())
-                result = shtc3Sensor.runOnce();
-            if (lps22hbSensor.hasSensor())
-                result = lps22hbSensor.runOnce();
-            if (sht31Sensor.hasSensor())
-                result = sht31Sensor.runOnce();
-            if (sht4xSensor.hasSensor())
-                result = sht4xSensor.runOnce();
-            if (ina219Sensor.hasSensor())
-                result = ina219Sensor.runOnce();
-            if (ina260Sensor.hasSensor())
-                result = ina260Sensor.runOnce();
-            if (ina3221Sensor.hasSensor())
-                result = ina3221Sensor.runOnce();
-            if (veml7700Sensor.hasSensor())
-                result = veml7700Sensor.runOnce();
-            if (tsl2591Sensor.hasSensor())
-                result = tsl2591Sensor.runOnce();
-            if (opt3001Sensor.hasSensor())
-                result = opt3001Sensor.runOnce();
-            if (rcwl9620Sensor.hasSensor())
-                result = rcwl9620Sensor.runOnce();
-            if (aht10Sensor.hasSensor())
-                result = aht10Sensor.runOnce();
-            if (mlx90632Sensor.hasSensor())
-                result = mlx90632Sensor.runOnce();
-            if (nau7802Sensor.hasSensor())
-                result = nau7802Sensor.runOnce();
-            if (max17048Sensor.hasSensor())
-                result = max17048Sensor.runOnce();
-            if (cgRadSens.hasSensor())
-                result = cgRadSens.runOnce();
+            sensors.probe(environmentSensors, sizeof(environmentSensors) / sizeof(environmentSensors[0]));
+            for (size_t i = 0; i < sensors.size(); i++)
+                result = sensors.at(i)->runOnce();
 #endif
         }
         return result;
@@ -168,8 +136,9 @@ int32_t EnvironmentTelemetryModule::runOnce()
             return disable();
         } else {
 #if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
-            if (bme680Sensor.hasSensor())
-                result = bme680Sensor.runTrigger();
+            auto bme680 = static_cast<BME680Sensor *>(sensors.find(meshtastic_TelemetrySensorType_BME680));
+            if (bme680 && bme680->hasSensor())
+                result = bme680->runTrigger();
 #endif
         }
 
@@ -312,113 +281,26 @@ bool EnvironmentTelemetryModule::getEnvironmentTelemetry(meshtastic_Telemetry *m
 #ifdef T1000X_SENSOR_EN // add by WayenWeng
     valid = valid && t1000xSensor.getMetrics(m);
     hasSensor = true;
-#else
-    if (dfRobotLarkSensor.hasSensor()) {
-        valid = valid && dfRobotLarkSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (sht31Sensor.hasSensor()) {
-        valid = valid && sht31Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (sht4xSensor.hasSensor()) {
-        valid = valid && sht4xSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (lps22hbSensor.hasSensor()) {
-        valid = valid && lps22hbSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (shtc3Sensor.hasSensor()) {
-        valid = valid && shtc3Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp085Sensor.hasSensor()) {
-        valid = valid && bmp085Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp280Sensor.hasSensor()) {
-        valid = valid && bmp280Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bme280Sensor.hasSensor()) {
-        valid = valid && bme280Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp3xxSensor.hasSensor()) {
-        valid = valid && bmp3xxSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bme680Sensor.hasSensor()) {
-        valid = valid && bme680Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (mcp9808Sensor.hasSensor()) {
-        valid = valid && mcp9808Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina219Sensor.hasSensor()) {
-        valid = valid && ina219Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina260Sensor.hasSensor()) {
-        valid = valid && ina260Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina3221Sensor.hasSensor()) {
-        valid = valid && ina3221Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (veml7700Sensor.hasSensor()) {
-        valid = valid && veml7700Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (tsl2591Sensor.hasSensor()) {
-        valid = valid && tsl2591Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (opt3001Sensor.hasSensor()) {
-        valid = valid && opt3001Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (mlx90632Sensor.hasSensor()) {
-        valid = valid && mlx90632Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (rcwl9620Sensor.hasSensor()) {
-        valid = valid && rcwl9620Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (nau7802Sensor.hasSensor()) {
-        valid = valid && nau7802Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (aht10Sensor.hasSensor()) {
-        if (!bmp280Sensor.hasSensor() && !bmp3xxSensor.hasSensor()) {
-            valid = valid && aht10Sensor.getMetrics(m);
-            hasSensor = true;
-        } else if (bmp280Sensor.hasSensor()) {
-            // prefer bmp280 temp if both sensors are present, fetch only humidity
-            meshtastic_Telemetry m_ahtx = meshtastic_Telemetry_init_zero;
-            LOG_INFO("AHTX0+BMP280 module detected: using temp from BMP280 and humy from AHTX0");
-            aht10Sensor.getMetrics(&m_ahtx);
-            m->variant.environment_metrics.relative_humidity = m_ahtx.variant.environment_metrics.relative_humidity;
-            m->variant.environment_metrics.has_relative_humidity = m_ahtx.variant.environment_metrics.has_relative_humidity;
-        } else {
-            // prefer bmp3xx temp if both sensors are present, fetch only humidity
+#elif !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
+    bool hasBMP280 = nodeTelemetrySensorsMap[meshtastic_TelemetrySensorType_BMP280].first > 0;
+    bool hasBMP3XX = nodeTelemetrySensorsMap[meshtastic_TelemetrySensorType_BMP3XX].first > 0;
+    for (size_t i = 0; i < sensors.size(); i++) {
+        TelemetrySensor *sensor = sensors.at(i);
+        if (!sensor->isRunning()) // detected, but couldn't be opened
+            continue;
+
+        if (sensor->getType() == meshtastic_TelemetrySensorType_AHT10 && (hasBMP280 || hasBMP3XX)) {
+            // prefer the bmp280/bmp3xx temp if both sensors are present, fetch only humidity
             meshtastic_Telemetry m_ahtx = meshtastic_Telemetry_init_zero;
-            LOG_INFO("AHTX0+BMP3XX module detected: using temp from BMP3XX and humy from AHTX0");
-            aht10Sensor.getMetrics(&m_ahtx);
+            LOG_INFO("AHTX0+%s module detected: using temp from %s and humy from AHTX0", hasBMP280 ? "BMP280" : "BMP3XX",
+                     hasBMP280 ? "BMP280" : "BMP3XX");
+            sensors.read(i, &m_ahtx);
             m->variant.environment_metrics.relative_humidity = m_ahtx.variant.environment_metrics.relative_humidity;
             m->variant.environment_metrics.has_relative_humidity = m_ahtx.variant.environment_metrics.has_relative_humidity;
+            continue;
         }
-    }
-    if (max17048Sensor.hasSensor()) {
-        valid = valid && max17048Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (cgRadSens.hasSensor()) {
-        valid = valid && cgRadSens.getMetrics(m);
+
+        valid = valid && sensors.read(i, m);
         hasSensor = true;
     }
 #endif
@@ -513,113 +395,10 @@ AdminMessageHandleResult EnvironmentTelemetryModule::handleAdminMessageForModule
 {
     AdminMessageHandleResult result = AdminMessageHandleResult::NOT_HANDLED;
 #if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
-    if (dfRobotLarkSensor.hasSensor()) {
-        result = dfRobotLarkSensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (sht31Sensor.hasSensor()) {
-        result = sht31Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (lps22hbSensor.hasSensor()) {
-        result = lps22hbSensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (shtc3Sensor.hasSensor()) {
-        result = shtc3Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bmp085Sensor.hasSensor()) {
-        result = bmp085Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bmp280Sensor.hasSensor()) {
-        result = bmp280Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bme280Sensor.hasSensor()) {
-        result = bme280Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bmp3xxSensor.hasSensor()) {
-        result = bmp3xxSensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bme680Sensor.hasSensor()) {
-        result = bme680Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (mcp9808Sensor.hasSensor()) {
-        result = mcp9808Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (ina219Sensor.hasSensor()) {
-        result = ina219Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (ina260Sensor.hasSensor()) {
-        result = ina260Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (ina3221Sensor.hasSensor()) {
-        result = ina3221Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (veml7700Sensor.hasSensor()) {
-        result = veml7700Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (tsl2591Sensor.hasSensor()) {
-        result = tsl2591Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (opt3001Sensor.hasSensor()) {
-        result = opt3001Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (mlx90632Sensor.hasSensor()) {
-        result = mlx90632Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (rcwl9620Sensor.hasSensor()) {
-        result = rcwl9620Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (nau7802Sensor.hasSensor()) {
-        result = nau7802Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (aht10Sensor.hasSensor()) {
-        result = aht10Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (max17048Sensor.hasSensor()) {
-        result = max17048Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (cgRadSens.hasSensor()) {
-        result = cgRadSens.handleAdminMessage(mp, request, response);
+    for (size_t i = 0; i < sensors.size(); i++) {
+        if (!sensors.at(i)->isRunning())
+            continue;
+        result = sensors.at(i)->handleAdminMessage(mp, request, response);
         if (result != AdminMessageHandleResult::NOT_HANDLED)
             return result;
     }
@@ -6,6 +6,7 @@
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "NodeDB.h"
 #include "ProtobufModule.h"
+#include "TelemetrySensorRegistry.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
 
@@ -58,6 +59,9 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     uint32_t lastSentToMesh = 0;
     uint32_t lastSentToPhone = 0;
     uint32_t sensor_read_error_count = 0;
+
+    /// The sensors ScanI2C found, created the first time we run
+    TelemetrySensorRegistry sensors;
 };
 
 #endif
\ No newline at end of file
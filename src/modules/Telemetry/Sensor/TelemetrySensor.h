@@ -51,6 +51,9 @@ class TelemetrySensor
 
     bool hasSensor() { return nodeTelemetrySensorsMap[sensorType].first > 0; }
 
+    meshtastic_TelemetrySensorType getType() const { return sensorType; }
+    const char *getName() const { return sensorName; }
+
     virtual int32_t runOnce() = 0;
     virtual bool isInitialized() { return initialized; }
     virtual bool isRunning() { return status > 0; }
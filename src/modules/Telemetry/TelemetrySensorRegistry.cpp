@@ -0,0 +1,44 @@
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#include "TelemetrySensorRegistry.h"
+
+void TelemetrySensorRegistry::probe(const TelemetrySensorFactory *table, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (nodeTelemetrySensorsMap[table[i].type].first > 0 && !find(table[i].type)) {
+            TelemetrySensor *sensor = table[i].create();
+            LOG_DEBUG("Use detected %s sensor", sensor->getName());
+            slots.push_back({sensor, {}});
+        }
+    }
+}
+
+TelemetrySensor *TelemetrySensorRegistry::find(meshtastic_TelemetrySensorType type) const
+{
+    for (auto &slot : slots)
+        if (slot.sensor->getType() == type)
+            return slot.sensor;
+    return NULL;
+}
+
+bool TelemetrySensorRegistry::read(size_t i, meshtastic_Telemetry *m)
+{
+    Slot &slot = slots[i];
+    uint32_t start = micros();
+    bool ok = slot.sensor->getMetrics(m);
+    uint32_t took = micros() - start;
+
+    slot.stats.reads++;
+    if (!ok)
+        slot.stats.failures++;
+    slot.stats.lastUs = took;
+    if (took > slot.stats.maxUs)
+        slot.stats.maxUs = took;
+    LOG_DEBUG("%s read in %uus (max %uus, %u of %u failed)", slot.sensor->getName(), took, slot.stats.maxUs,
+              slot.stats.failures, slot.stats.reads);
+    return ok;
+}
+
+#endif
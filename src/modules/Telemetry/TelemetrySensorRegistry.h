@@ -0,0 +1,55 @@
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#pragma once
+#include "Sensor/TelemetrySensor.h"
+#include <vector>
+
+/// How a telemetry module gets hold of one kind of sensor. create is only called if ScanI2C found that kind.
+struct TelemetrySensorFactory {
+    meshtastic_TelemetrySensorType type;
+    TelemetrySensor *(*create)();
+};
+
+struct TelemetrySensorStats {
+    uint32_t reads;
+    uint32_t failures; // getMetrics() returned false
+    uint32_t lastUs;   // how long the last getMetrics() took
+    uint32_t maxUs;
+};
+
+/**
+ * The sensors a telemetry module actually has, picked from a table of every kind it supports.
+ *
+ * Sensor objects can be big (driver state, calibration blobs), so rather than constructing one of each up front we only
+ * create the ones ScanI2C put in nodeTelemetrySensorsMap. The module then walks this short list instead of asking every
+ * supported kind whether it is there, and each read is timed.
+ */
+class TelemetrySensorRegistry
+{
+  public:
+    /// Create the detected sensors, in table order (which is also the order their metrics get merged in)
+    void probe(const TelemetrySensorFactory *table, size_t count);
+
+    size_t size() const { return slots.size(); }
+    TelemetrySensor *at(size_t i) const { return slots[i].sensor; }
+
+    /// The sensor of this kind, NULL if it wasn't detected
+    TelemetrySensor *find(meshtastic_TelemetrySensorType type) const;
+
+    /// getMetrics() of sensor i, accounting how long it took
+    bool read(size_t i, meshtastic_Telemetry *m);
+
+    const TelemetrySensorStats &getStats(size_t i) const { return slots[i].stats; }
+
+  private:
+    struct Slot {
+        TelemetrySensor *sensor;
+        TelemetrySensorStats stats;
+    };
+
+    std::vector<Slot> slots;
+};
+
+#endif
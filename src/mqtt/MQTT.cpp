@@ -45,6 +45,10 @@ constexpr int reconnectMax = 5;
 // FIXME - this size calculation is super sloppy, but it will go away once we dynamically alloc meshpackets
 static uint8_t bytes[meshtastic_MqttClientProxyMessage_size + 30]; // 12 for channel name and 16 for nodeid
 
+#if !defined(ARCH_NRF52) || defined(NRF52_USE_JSON)
+static char jsonBuffer[MESHPACKET_JSON_MAX_LEN]; // the json topic copy of whatever is in bytes
+#endif
+
 static bool isMqttServerAddressPrivate = false;
 
 inline void onReceiveProto(char *topic, byte *payload, size_t length)
@@ -329,6 +333,10 @@ MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE)
             reconnectCount = 0;
             publishNodeInfo();
         }
+#if MQTT_SPOOL
+        if (!spool.init())
+            LOG_WARN("MQTT spool unavailable, only %d messages can be held while disconnected", MAX_MQTT_QUEUE);
+#endif
         // preflightSleepObserver.observe(&preflightSleep);
     } else {
         disable();
@@ -550,6 +558,12 @@ int32_t MQTT::runOnce()
             pubSub.disconnect();
         }
 
+        // Drain anything held while we were disconnected, a batch at a time so we don't starve the rest of the system
+        if (hasQueuedMessages() && !Throttle::isWithinTimespanMs(lastReplayMsec, MQTT_REPLAY_INTERVAL_MS)) {
+            lastReplayMsec = millis();
+            publishQueuedMessages();
+        }
+
         powerFSM.trigger(EVENT_CONTACT_FROM_PHONE); // Suppress entering light sleep (because that would turn off bluetooth)
         return 20;
     }
@@ -561,29 +575,63 @@ void MQTT::publishNodeInfo()
 {
     // TODO: NodeInfo broadcast over MQTT only (NODENUM_BROADCAST_NO_LORA)
 }
+
+bool MQTT::hasQueuedMessages()
+{
+#if MQTT_SPOOL
+    if (!spool.isEmpty())
+        return true;
+#endif
+    return !mqttQueue.isEmpty();
+}
+
 void MQTT::publishQueuedMessages()
 {
-    if (mqttQueue.isEmpty())
+    if (!hasQueuedMessages())
         return;
 
-    LOG_DEBUG("Publish enqueued MQTT message");
-    const std::unique_ptr<QueueEntry> entry(mqttQueue.dequeuePtr(0));
-    LOG_INFO("publish %s, %u bytes from queue", entry->topic.c_str(), entry->envBytes.size());
-    publish(entry->topic.c_str(), entry->envBytes.data(), entry->envBytes.size(), false);
+    size_t published = 0;
+    while (published < MQTT_REPLAY_BATCH && !mqttQueue.isEmpty()) {
+        const std::unique_ptr<QueueEntry> entry(mqttQueue.dequeuePtr(0));
+        LOG_INFO("publish %s, %u bytes from queue", entry->topic.c_str(), entry->envBytes.size());
+        publishEnvelope(entry->topic.c_str(), entry->envBytes.data(), entry->envBytes.size());
+        published++;
+    }
+
+#if MQTT_SPOOL
+    if (published < MQTT_REPLAY_BATCH && !spool.isEmpty()) {
+        size_t replayed = spool.replay(MQTT_REPLAY_BATCH - published, [this](const char *topic, const uint8_t *payload,
+                                                                             size_t length) {
+            return publishEnvelope(topic, payload, length);
+        });
+        LOG_DEBUG("Publish %u MQTT messages from spool, %u left", (unsigned)replayed, (unsigned)spool.pending());
+        if (spool.isEmpty()) {
+            const MQTTSpoolStats &st = spool.getStats();
+            LOG_INFO("MQTT spool drained: spooled=%u replayed=%u dropped=%u corrupt=%u", st.spooled, st.replayed, st.dropped,
+                     st.corrupt);
+        }
+    }
+#endif
+}
+
+bool MQTT::publishEnvelope(const char *topic, const uint8_t *envBytes, size_t length)
+{
+    if (!publish(topic, envBytes, length, false))
+        return false;
 
 #if !defined(ARCH_NRF52) ||                                                                                                      \
     defined(NRF52_USE_JSON) // JSON is not supported on nRF52, see issue #2804 ### Fixed by using ArduinoJson ###
     if (!moduleConfig.mqtt.json_enabled)
-        return;
+        return true;
 
     // handle json topic
-    const DecodedServiceEnvelope env(entry->envBytes.data(), entry->envBytes.size());
+    const DecodedServiceEnvelope env(envBytes, length);
     if (!env.validDecode || env.packet == NULL || env.channel_id == NULL)
-        return;
+        return true;
 
-    auto jsonString = MeshPacketSerializer::JsonSerialize(env.packet);
-    if (jsonString.length() == 0)
-        return;
+    size_t jsonLen = MeshPacketSerializer::JsonSerialize(env.packet, jsonBuffer, sizeof(jsonBuffer));
+    if (jsonLen == 0)
+        return true;
 
     std::string topicJson;
     if (env.packet->pki_encrypted) {
@@ -591,9 +639,10 @@ void MQTT::publishQueuedMessages()
     } else {
         topicJson = jsonTopic + env.channel_id + "/" + owner.id;
     }
-    LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), jsonString.length(), jsonString.c_str());
-    publish(topicJson.c_str(), jsonString.c_str(), false);
+    LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), (unsigned int)jsonLen, jsonBuffer);
+    publish(topicJson.c_str(), jsonBuffer, false);
 #endif // ARCH_NRF52 NRF52_USE_JSON
+    return true;
 }
 
 void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex)
@@ -661,18 +710,27 @@ void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_Me
         if (!moduleConfig.mqtt.json_enabled)
             return;
         // handle json topic
-        auto jsonString = MeshPacketSerializer::JsonSerialize(&mp_decoded);
-        if (jsonString.length() == 0)
+        size_t jsonLen = MeshPacketSerializer::JsonSerialize(&mp_decoded, jsonBuffer, sizeof(jsonBuffer));
+        if (jsonLen == 0)
             return;
         std::string topicJson = jsonTopic + channelId + "/" + owner.id;
-        LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), jsonString.length(), jsonString.c_str());
-        publish(topicJson.c_str(), jsonString.c_str(), false);
+        LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), (unsigned int)jsonLen, jsonBuffer);
+        publish(topicJson.c_str(), jsonBuffer, false);
 #endif // ARCH_NRF52 NRF52_USE_JSON
     } else {
+#if MQTT_SPOOL
+        if (spool.append(topic.c_str(), bytes, numBytes)) {
+            LOG_INFO("MQTT not connected, spool packet");
+            return;
+        }
+#endif
         LOG_INFO("MQTT not connected, queue packet");
         QueueEntry *entry;
         if (mqttQueue.numFree() == 0) {
             LOG_WARN("MQTT queue is full, discard oldest");
+#if MQTT_SPOOL
+            spool.noteDropped();
+#endif
             entry = mqttQueue.dequeuePtr(0);
         } else {
             entry = new QueueEntry;
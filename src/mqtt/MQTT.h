@@ -2,6 +2,7 @@
 
 #include "configuration.h"
 
+#include "MQTTSpool.h"
 #include "concurrency/OSThread.h"
 #include "mesh/Channels.h"
 #include "mesh/generated/meshtastic/mqtt.pb.h"
@@ -27,6 +28,14 @@
 
 #define MAX_MQTT_QUEUE 16
 
+// How many queued/spooled messages to publish at once after reconnecting, and the pause between those batches
+#ifndef MQTT_REPLAY_BATCH
+#define MQTT_REPLAY_BATCH 8
+#endif
+#ifndef MQTT_REPLAY_INTERVAL_MS
+#define MQTT_REPLAY_INTERVAL_MS 100
+#endif
+
 /**
  * Our wrapper/singleton for sending/receiving MQTT "udp" packets.  This object isolates the MQTT protocol implementation from
  * the two components that use it: MQTTPlugin and MQTTSimInterface.
@@ -65,12 +74,20 @@ class MQTT : private concurrency::OSThread
 
     bool isUsingDefaultServer() { return isConfiguredForDefaultServer; }
 
+#if MQTT_SPOOL
+    const MQTTSpoolStats &getSpoolStats() const { return spool.getStats(); }
+#endif
+
   protected:
     struct QueueEntry {
         std::string topic;
         std::basic_string<uint8_t> envBytes; // binary/pb_encode_to_bytes ServiceEnvelope
     };
-    PointerQueue<QueueEntry> mqttQueue;
+    PointerQueue<QueueEntry> mqttQueue; // fallback if the spool is unavailable or failed to write
+#if MQTT_SPOOL
+    MQTTSpool spool;
+#endif
+    uint32_t lastReplayMsec = 0;
 
     int reconnectCount = 0;
     bool isConfiguredForDefaultServer = true;
@@ -125,8 +142,14 @@ class MQTT : private concurrency::OSThread
     /// Called when a new publish arrives from the MQTT server
     void onReceive(char *topic, byte *payload, size_t length);
 
+    /// Publish up to MQTT_REPLAY_BATCH messages from the in-RAM queue and the spool
     void publishQueuedMessages();
 
+    bool hasQueuedMessages();
+
+    /// Publish one ServiceEnvelope and, if enabled, its JSON rendering.  Returns false if the envelope was not published
+    bool publishEnvelope(const char *topic, const uint8_t *envBytes, size_t length);
+
     void publishNodeInfo();
 
     // Check if we should report unencrypted information about our node for consumption by a map
@@ -0,0 +1,288 @@
+#include "MQTTSpool.h"
+
+#if MQTT_SPOOL
+#include "meshUtils.h"
+
+#define MQTT_SPOOL_DIR "/mqtt"
+
+#ifndef FILE_APPEND
+#define FILE_APPEND "a"
+#endif
+
+static const uint32_t SEGMENT_MAGIC = 0x5053514d; // "MQSP"
+static const uint8_t RECORD_MAGIC = 0xa5;
+static const size_t SEGMENT_HEADER_SIZE = 8;       // magic, seq
+static const size_t RECORD_HEADER_SIZE = 8;        // magic, topic len, payload len (2), crc32 (4)
+static const size_t MAX_RECORD_PAYLOAD = 512;      // a ServiceEnvelope is far below this
+static const size_t MAX_RECORD_TOPIC = UINT8_MAX;
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/** One record read back from a segment */
+struct SpoolRecord {
+    size_t topicLen, payloadLen;
+    char topic[MAX_RECORD_TOPIC + 1];
+    uint8_t payload[MAX_RECORD_PAYLOAD];
+
+    size_t size() const { return RECORD_HEADER_SIZE + topicLen + payloadLen; }
+
+    /// Read the record at the current file position, false if it is truncated or fails its CRC
+    bool read(File &f)
+    {
+        uint8_t hdr[RECORD_HEADER_SIZE];
+        if (f.read(hdr, sizeof(hdr)) != sizeof(hdr) || hdr[0] != RECORD_MAGIC)
+            return false;
+        topicLen = hdr[1];
+        payloadLen = hdr[2] | (hdr[3] << 8);
+        if (payloadLen > sizeof(payload))
+            return false;
+        if (f.read((uint8_t *)topic, topicLen) != topicLen || f.read(payload, payloadLen) != payloadLen)
+            return false;
+        topic[topicLen] = '\0';
+        uint32_t crc = crc32((const uint8_t *)topic, topicLen);
+        return crc32(payload, payloadLen, crc) == getU32(hdr + 4);
+    }
+};
+
+static SpoolRecord record; // too big for the stack of the mqtt thread on some targets
+
+void MQTTSpool::pathFor(int slot, char *path, size_t len)
+{
+    snprintf(path, len, MQTT_SPOOL_DIR "/spool%d.seg", slot);
+}
+
+bool MQTTSpool::init()
+{
+    FSCom.mkdir(MQTT_SPOOL_DIR);
+    for (int slot = 0; slot < MQTT_SPOOL_SEGMENTS; slot++)
+        scanSegment(slot);
+    updateHeadTail();
+    if (tail >= 0)
+        nextSeq = segments[tail].seq + 1;
+    readOffset = SEGMENT_HEADER_SIZE;
+    readRecords = 0;
+    ready = true;
+
+    if (pending())
+        LOG_INFO("MQTT spool holds %u messages from a previous run", (unsigned)pending());
+    return ready;
+}
+
+void MQTTSpool::scanSegment(int slot)
+{
+    char path[32];
+    pathFor(slot, path, sizeof(path));
+    Segment &s = segments[slot];
+    s = {};
+    if (!FSCom.exists(path))
+        return;
+
+    File f = FSCom.open(path, FILE_O_READ);
+    uint8_t hdr[SEGMENT_HEADER_SIZE];
+    if (!f || f.read(hdr, sizeof(hdr)) != sizeof(hdr) || getU32(hdr) != SEGMENT_MAGIC) {
+        LOG_WARN("Remove unreadable MQTT spool segment %s", path);
+        if (f)
+            f.close();
+        FSCom.remove(path);
+        return;
+    }
+
+    s.used = true;
+    s.seq = getU32(hdr + 4);
+    s.bytes = SEGMENT_HEADER_SIZE;
+    size_t fileSize = f.size();
+    while (s.bytes < fileSize && record.read(f)) {
+        s.bytes += record.size();
+        s.records++;
+    }
+    f.close();
+
+    if (s.bytes < fileSize) {
+        // Torn tail from a crash mid append, keep what is valid but never write after the garbage
+        LOG_WARN("MQTT spool segment %s has %u bad trailing bytes", path, (unsigned)(fileSize - s.bytes));
+        stats.corrupt++;
+        s.sealed = true;
+    }
+}
+
+void MQTTSpool::updateHeadTail()
+{
+    head = tail = -1;
+    for (int slot = 0; slot < MQTT_SPOOL_SEGMENTS; slot++) {
+        if (!segments[slot].used)
+            continue;
+        // sequence numbers are compared wrap safe, like our millis() deadlines
+        if (head < 0 || (int32_t)(segments[slot].seq - segments[head].seq) < 0)
+            head = slot;
+        if (tail < 0 || (int32_t)(segments[slot].seq - segments[tail].seq) > 0)
+            tail = slot;
+    }
+}
+
+void MQTTSpool::removeSegment(int slot)
+{
+    char path[32];
+    pathFor(slot, path, sizeof(path));
+    FSCom.remove(path);
+    if (slot == head) {
+        readOffset = SEGMENT_HEADER_SIZE;
+        readRecords = 0;
+    }
+    segments[slot] = {};
+    updateHeadTail();
+}
+
+bool MQTTSpool::openSegment()
+{
+    int slot = -1;
+    for (int i = 0; i < MQTT_SPOOL_SEGMENTS && slot < 0; i++)
+        if (!segments[i].used)
+            slot = i;
+
+#ifdef ARCH_ESP32
+    // The spool shares the filesystem with our prefs, never let it eat the space they need
+    bool lowSpace = FSCom.totalBytes() - FSCom.usedBytes() < 4 * MQTT_SPOOL_SEGMENT_BYTES;
+#else
+    bool lowSpace = false;
+#endif
+    if ((slot < 0 || lowSpace) && head >= 0) {
+        uint32_t lost = segments[head].records - readRecords;
+        LOG_WARN("MQTT spool full, drop %u oldest messages", (unsigned)lost);
+        stats.dropped += lost;
+        slot = head;
+        removeSegment(head);
+    }
+    if (slot < 0)
+        return false;
+
+    char path[32];
+    pathFor(slot, path, sizeof(path));
+    File f = FSCom.open(path, FILE_O_WRITE);
+    if (!f)
+        return false;
+    uint8_t hdr[SEGMENT_HEADER_SIZE];
+    putU32(hdr, SEGMENT_MAGIC);
+    putU32(hdr + 4, nextSeq);
+    bool ok = f.write(hdr, sizeof(hdr)) == sizeof(hdr);
+    f.close();
+    if (!ok) {
+        FSCom.remove(path);
+        return false;
+    }
+
+    segments[slot] = {true, false, nextSeq++, SEGMENT_HEADER_SIZE, 0};
+    updateHeadTail();
+    return true;
+}
+
+bool MQTTSpool::append(const char *topic, const uint8_t *payload, size_t length)
+{
+    size_t topicLen = strlen(topic);
+    if (!ready || topicLen > MAX_RECORD_TOPIC || length > MAX_RECORD_PAYLOAD)
+        return false;
+
+    size_t recordLen = RECORD_HEADER_SIZE + topicLen + length;
+    if (tail < 0 || segments[tail].sealed || segments[tail].bytes + recordLen > MQTT_SPOOL_SEGMENT_BYTES) {
+        if (!openSegment())
+            return false;
+    }
+
+    uint8_t hdr[RECORD_HEADER_SIZE];
+    hdr[0] = RECORD_MAGIC;
+    hdr[1] = topicLen;
+    hdr[2] = length;
+    hdr[3] = length >> 8;
+    putU32(hdr + 4, crc32(payload, length, crc32((const uint8_t *)topic, topicLen)));
+
+    char path[32];
+    pathFor(tail, path, sizeof(path));
+    File f = FSCom.open(path, FILE_APPEND);
+    if (!f)
+        return false;
+    bool ok = f.write(hdr, sizeof(hdr)) == sizeof(hdr) && f.write((const uint8_t *)topic, topicLen) == topicLen &&
+              f.write(payload, length) == length;
+    f.close();
+
+    Segment &s = segments[tail];
+    if (!ok) {
+        // Whatever part made it to disk is a torn record now, nothing may follow it
+        s.sealed = true;
+        return false;
+    }
+    s.bytes += recordLen;
+    s.records++;
+    stats.spooled++;
+    return true;
+}
+
+size_t MQTTSpool::replay(size_t maxMessages, const PublishFn &publish)
+{
+    size_t done = 0;
+    while (done < maxMessages && head >= 0) {
+        int slot = head;
+        Segment &s = segments[slot];
+        if (readOffset >= s.bytes) {
+            // Fully replayed, a partially written tail segment is abandoned too so the next append starts clean
+            removeSegment(slot);
+            continue;
+        }
+
+        char path[32];
+        pathFor(slot, path, sizeof(path));
+        File f = FSCom.open(path, FILE_O_READ);
+        if (!f || !f.seek(readOffset)) {
+            LOG_ERROR("Can't read MQTT spool segment %s", path);
+            stats.dropped += s.records - readRecords;
+            if (f)
+                f.close();
+            removeSegment(slot);
+            continue;
+        }
+
+        bool stopped = false;
+        while (done < maxMessages && readOffset < s.bytes) {
+            if (!record.read(f)) {
+                LOG_WARN("Corrupt record in MQTT spool segment %s, skip the rest of it", path);
+                stats.corrupt++;
+                stats.dropped += s.records - readRecords;
+                readOffset = s.bytes;
+                break;
+            }
+            if (!publish(record.topic, record.payload, record.payloadLen)) {
+                stopped = true;
+                break;
+            }
+            readOffset += record.size();
+            readRecords++;
+            stats.replayed++;
+            done++;
+        }
+        f.close();
+
+        if (stopped)
+            break;
+    }
+    return done;
+}
+
+uint32_t MQTTSpool::pending() const
+{
+    uint32_t n = 0;
+    for (int slot = 0; slot < MQTT_SPOOL_SEGMENTS; slot++)
+        if (segments[slot].used)
+            n += segments[slot].records;
+    return n - (head >= 0 ? readRecords : 0);
+}
+
+#endif
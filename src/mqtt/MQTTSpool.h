@@ -0,0 +1,99 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "configuration.h"
+
+#include <functional>
+
+// Spool packets we could not publish to the filesystem, so a gateway with a flaky uplink doesn't lose them on a long outage
+#ifndef MQTT_SPOOL
+#if defined(FSCom) && (defined(ARCH_ESP32) || defined(ARCH_RP2040) || defined(ARCH_PORTDUINO))
+#define MQTT_SPOOL 1
+#else
+#define MQTT_SPOOL 0
+#endif
+#endif
+
+// The spool is a ring of this many segment files, so it never takes more than MQTT_SPOOL_SEGMENTS * MQTT_SPOOL_SEGMENT_BYTES
+#ifndef MQTT_SPOOL_SEGMENTS
+#define MQTT_SPOOL_SEGMENTS 8
+#endif
+
+#ifndef MQTT_SPOOL_SEGMENT_BYTES
+#ifdef ARCH_PORTDUINO
+#define MQTT_SPOOL_SEGMENT_BYTES (1024 * 1024)
+#else
+#define MQTT_SPOOL_SEGMENT_BYTES (16 * 1024)
+#endif
+#endif
+
+struct MQTTSpoolStats {
+    uint32_t spooled;  // messages written while the broker was unreachable
+    uint32_t replayed; // messages published from the spool after reconnecting
+    uint32_t dropped;  // messages lost because the spool (or the in-RAM fallback queue) was full
+    uint32_t corrupt;  // records that failed their CRC, e.g. torn by a power cut mid write
+};
+
+/**
+ * Append-only on-disk queue of MQTT messages.
+ *
+ * Each segment file starts with a small header carrying a sequence number, followed by records of
+ *   [magic][topic len][payload len][crc32 of topic + payload][topic][payload]
+ * so after a crash we can find the oldest segment again without an index and stop at the first torn record. When the ring
+ * is full the oldest segment is dropped as a whole. Delivery is at least once: the read position is only kept in RAM, so a
+ * reboot in the middle of a replay will publish the head segment again.
+ */
+class MQTTSpool
+{
+  public:
+    /// Called for each replayed message, return false to stop (and keep the message for the next attempt)
+    typedef std::function<bool(const char *topic, const uint8_t *payload, size_t length)> PublishFn;
+
+    /// Scan the spool directory left by a previous run, returns false if the spool can't be used
+    bool init();
+
+    /// Append one message, returns false if it could not be written (the caller should keep it some other way)
+    bool append(const char *topic, const uint8_t *payload, size_t length);
+
+    /// Publish up to maxMessages, oldest first, returns how many were published
+    size_t replay(size_t maxMessages, const PublishFn &publish);
+
+    /// Number of messages waiting to be replayed
+    uint32_t pending() const;
+
+    bool isEmpty() const { return pending() == 0; }
+
+    /// Account for a message lost outside the spool, so all drops show up in one place
+    void noteDropped() { stats.dropped++; }
+
+    const MQTTSpoolStats &getStats() const { return stats; }
+
+  private:
+    struct Segment {
+        bool used;
+        bool sealed; // don't append, e.g. because its tail was torn
+        uint32_t seq;
+        uint32_t bytes;   // valid bytes, including the header
+        uint32_t records; // valid records
+    };
+
+    Segment segments[MQTT_SPOOL_SEGMENTS] = {};
+    MQTTSpoolStats stats = {};
+    bool ready = false;
+    uint32_t nextSeq = 1;
+    int head = -1, tail = -1;  // oldest and newest used slot
+    uint32_t readOffset = 0;   // position of the next record to replay in the head segment
+    uint32_t readRecords = 0;  // records of the head segment already replayed
+
+    static void pathFor(int slot, char *path, size_t len);
+
+    /// Validate one segment file and count its records
+    void scanSegment(int slot);
+
+    /// Start a new segment in a free slot, dropping the oldest one if the ring is full
+    bool openSegment();
+
+    void removeSegment(int slot);
+
+    void updateHeadTail();
+};
@@ -5,18 +5,31 @@
 #include "PowerFSM.h"
 
 #include "main.h"
+#include "mesh/FromRadioBatcher.h"
 #include "mesh/PhoneAPI.h"
 #include "mesh/mesh-pb-constants.h"
 #include "sleep.h"
 #include <NimBLEDevice.h>
+#include <algorithm>
 
 NimBLECharacteristic *fromNumCharacteristic;
 NimBLECharacteristic *BatteryCharacteristic;
 NimBLECharacteristic *logRadioCharacteristic;
+NimBLECharacteristic *fromRadioBatchCharacteristic;
 NimBLEServer *bleServer;
 
 static bool passkeyShowing;
 
+static FromRadioBatcher fromRadioBatcher;
+
+/// ATT MTU the phone negotiated, a read response can carry 3 bytes less than this
+static uint16_t peerMTU = BLE_ATT_MTU_DFLT;
+
+static size_t batchPayloadSize()
+{
+    return std::min((size_t)peerMTU - 3, (size_t)MAX_TO_FROM_RADIO_SIZE);
+}
+
 class BluetoothPhoneAPI : public PhoneAPI
 {
     /**
@@ -77,6 +90,19 @@ class NimbleBluetoothFromRadioCallback : public NimBLECharacteristicCallbacks
     }
 };
 
+/// The batcher is only ever filled from here, on the NimBLE host task, so it needs no locking.  Batch clients learn about
+/// new packets from fromNum like everyone else and then read this.
+class NimbleBluetoothFromRadioBatchCallback : public NimBLECharacteristicCallbacks
+{
+    virtual void onRead(NimBLECharacteristic *pCharacteristic)
+    {
+        uint8_t batch[MAX_TO_FROM_RADIO_SIZE];
+        size_t numBytes = fromRadioBatcher.fill(*bluetoothPhoneAPI, batch, batchPayloadSize());
+
+        pCharacteristic->setValue(batch, numBytes);
+    }
+};
+
 class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
 {
     virtual uint32_t onPassKeyRequest()
@@ -140,11 +166,20 @@ class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
         if (bluetoothPhoneAPI) {
             bluetoothPhoneAPI->close();
         }
+        fromRadioBatcher.reset();
+        peerMTU = BLE_ATT_MTU_DFLT;
+    }
+
+    virtual void onMTUChange(uint16_t MTU, ble_gap_conn_desc *desc)
+    {
+        LOG_INFO("BLE MTU %u", MTU);
+        peerMTU = MTU;
     }
 };
 
 static NimbleBluetoothToRadioCallback *toRadioCallbacks;
 static NimbleBluetoothFromRadioCallback *fromRadioCallbacks;
+static NimbleBluetoothFromRadioBatchCallback *fromRadioBatchCallbacks;
 
 void NimbleBluetooth::shutdown()
 {
@@ -221,6 +256,7 @@ void NimbleBluetooth::setupService()
     if (config.bluetooth.mode == meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         ToRadioCharacteristic = bleService->createCharacteristic(TORADIO_UUID, NIMBLE_PROPERTY::WRITE);
         FromRadioCharacteristic = bleService->createCharacteristic(FROMRADIO_UUID, NIMBLE_PROPERTY::READ);
+        fromRadioBatchCharacteristic = bleService->createCharacteristic(FROMRADIO_BATCH_UUID, NIMBLE_PROPERTY::READ, 512U);
         fromNumCharacteristic = bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ);
         logRadioCharacteristic =
             bleService->createCharacteristic(LOGRADIO_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, 512U);
@@ -229,6 +265,8 @@ void NimbleBluetooth::setupService()
             TORADIO_UUID, NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_AUTHEN | NIMBLE_PROPERTY::WRITE_ENC);
         FromRadioCharacteristic = bleService->createCharacteristic(
             FROMRADIO_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
+        fromRadioBatchCharacteristic = bleService->createCharacteristic(
+            FROMRADIO_BATCH_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC, 512U);
         fromNumCharacteristic =
             bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ |
                                                                NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
@@ -244,6 +282,9 @@ void NimbleBluetooth::setupService()
     fromRadioCallbacks = new NimbleBluetoothFromRadioCallback();
     FromRadioCharacteristic->setCallbacks(fromRadioCallbacks);
 
+    fromRadioBatchCallbacks = new NimbleBluetoothFromRadioBatchCallback();
+    fromRadioBatchCharacteristic->setCallbacks(fromRadioBatchCallbacks);
+
     bleService->start();
 
     // Setup the battery service
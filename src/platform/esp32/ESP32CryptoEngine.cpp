@@ -7,6 +7,7 @@ class ESP32CryptoEngine : public CryptoEngine
 {
 
     mbedtls_aes_context aes;
+    CryptoKey aesKey = {}; // the key aes was last set up with, so we only expand the key schedule when it changes
 
   public:
     ESP32CryptoEngine() { mbedtls_aes_init(&aes); }
@@ -23,7 +24,10 @@ class ESP32CryptoEngine : public CryptoEngine
     {
         if (_key.length > 0) {
             if (numBytes <= MAX_BLOCKSIZE) {
-                mbedtls_aes_setkey_enc(&aes, _key.bytes, _key.length * 8);
+                if (aesKey.length != _key.length || memcmp(aesKey.bytes, _key.bytes, sizeof(_key.bytes)) != 0) {
+                    mbedtls_aes_setkey_enc(&aes, _key.bytes, _key.length * 8);
+                    aesKey = _key;
+                }
                 static uint8_t scratch[MAX_BLOCKSIZE];
                 uint8_t stream_block[16];
                 size_t nc_off = 0;
@@ -65,7 +65,8 @@ enum configNames {
     maxnodes,
     ascii_logs,
     config_directory,
-    mac_address
+    mac_address,
+    routerThreads
 };
 enum { no_screen, x11, st7789, st7735, st7735s, st7796, ili9341, ili9342, ili9486, ili9488, hx8357d };
 enum { no_touchscreen, xpt2046, stmpe610, gt911, ft5x06 };
@@ -0,0 +1,158 @@
+#include "JSONWriter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+JSONWriter::JSONWriter(char *buf, size_t bufLen) : buf(buf), bufLen(bufLen)
+{
+    if (bufLen > 0)
+        buf[0] = '\0';
+    else
+        overflow = true;
+}
+
+void JSONWriter::put(char c)
+{
+    put(&c, 1);
+}
+
+void JSONWriter::put(const char *str, size_t n)
+{
+    if (overflow)
+        return;
+    if (len + n >= bufLen) {
+        overflow = true;
+        return;
+    }
+    memcpy(buf + len, str, n);
+    len += n;
+    buf[len] = '\0';
+}
+
+void JSONWriter::separate()
+{
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (depth == 0)
+        return;
+    uint32_t bit = 1UL << (depth - 1);
+    if (hasItems & bit)
+        put(',');
+    hasItems |= bit;
+}
+
+void JSONWriter::open(char bracket)
+{
+    separate();
+    put(bracket);
+    if (depth >= MAX_DEPTH) {
+        overflow = true;
+        return;
+    }
+    depth++;
+    hasItems &= ~(1UL << (depth - 1));
+}
+
+void JSONWriter::close(char bracket)
+{
+    if (depth > 0)
+        depth--;
+    put(bracket);
+}
+
+void JSONWriter::key(const char *name)
+{
+    separate();
+    escape(name);
+    put(':');
+    afterKey = true;
+}
+
+void JSONWriter::string(const char *str)
+{
+    separate();
+    escape(str);
+}
+
+void JSONWriter::number(double value)
+{
+    separate();
+    if (isinf(value) || isnan(value)) {
+        put("null", 4);
+        return;
+    }
+    char tmp[32];
+    // Most of our numbers are integers, which "%.15g" prints as plain digits below 1e15, do those without printf
+    if (value > -1e15 && value < 1e15 && value == (double)(int64_t)value && !(value == 0 && signbit(value))) {
+        uint64_t u = value < 0 ? (uint64_t)-(int64_t)value : (uint64_t)value;
+        char *p = tmp + sizeof(tmp);
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while (u);
+        if (value < 0)
+            *--p = '-';
+        put(p, tmp + sizeof(tmp) - p);
+        return;
+    }
+    // What a std::stringstream with precision(15) prints, as used by JSONValue
+    int n = snprintf(tmp, sizeof(tmp), "%.15g", value);
+    if (n > 0)
+        put(tmp, (size_t)n < sizeof(tmp) ? n : sizeof(tmp) - 1);
+}
+
+void JSONWriter::boolean(bool value)
+{
+    separate();
+    if (value)
+        put("true", 4);
+    else
+        put("false", 5);
+}
+
+void JSONWriter::raw(const char *json, size_t n)
+{
+    separate();
+    put(json, n);
+}
+
+void JSONWriter::escape(const char *str)
+{
+    put('"');
+    for (const char *p = str; *p; p++) {
+        // Same escapes as JSONValue::StringifyString(), including its odd handling of chars outside of ASCII
+        char chr = *p;
+        if (chr == '"' || chr == '\\' || chr == '/') {
+            char esc[2] = {'\\', chr};
+            put(esc, 2);
+        } else if (chr == '\b') {
+            put("\\b", 2);
+        } else if (chr == '\f') {
+            put("\\f", 2);
+        } else if (chr == '\n') {
+            put("\\n", 2);
+        } else if (chr == '\r') {
+            put("\\r", 2);
+        } else if (chr == '\t') {
+            put("\\t", 2);
+        } else if (chr < ' ' || chr > 126) {
+            char esc[6] = {'\\', 'u'};
+            size_t n = 2;
+            for (int i = 0; i < 4; i++) {
+                int value = (chr >> 12) & 0xf;
+                if (value >= 0 && value <= 9)
+                    esc[n++] = (char)('0' + value);
+                else if (value >= 10 && value <= 15)
+                    esc[n++] = (char)('A' + (value - 10));
+                chr = (char)((unsigned char)chr << 4);
+            }
+            put(esc, n);
+        } else {
+            put(chr);
+        }
+    }
+    put('"');
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Streaming JSON emitter that writes straight into a caller supplied buffer, without allocating.
+ *
+ * Values are formatted exactly like JSONValue::Stringify() does (numbers with 15 significant digits, the same string
+ * escapes, no whitespace), so code moved over from a JSONValue tree produces the same bytes. Unlike JSONObject the writer
+ * does not sort keys, callers that need that must emit them in order.
+ *
+ * If the buffer fills up the writer stops and overflowed() turns true, the output is always NUL terminated.
+ */
+class JSONWriter
+{
+  public:
+    JSONWriter(char *buf, size_t bufLen);
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    /// Start a member of the current object, must be followed by exactly one value
+    void key(const char *name);
+
+    void string(const char *str);
+    void number(double value);
+    void boolean(bool value);
+
+    /// Append already serialized JSON as the next value
+    void raw(const char *json, size_t len);
+
+    /// Shortcuts for one object member
+    void member(const char *name, const char *str)
+    {
+        key(name);
+        string(str);
+    }
+    void member(const char *name, double value)
+    {
+        key(name);
+        number(value);
+    }
+
+    size_t length() const { return len; }
+    bool overflowed() const { return overflow; }
+
+  private:
+    static const uint8_t MAX_DEPTH = 32;
+
+    char *buf;
+    size_t bufLen;
+    size_t len = 0;
+    bool overflow = false;
+    bool afterKey = false;
+    uint8_t depth = 0;
+    uint32_t hasItems = 0; // one bit per nesting level, set once that level needs a comma before the next item
+
+    void put(char c);
+    void put(const char *str, size_t n);
+
+    /// Write str as a quoted JSON string
+    void escape(const char *str);
+
+    /// Write the comma that goes before an array element or object member, if one is needed
+    void separate();
+
+    void open(char bracket);
+    void close(char bracket);
+};
@@ -3,9 +3,19 @@
 
 static const char hexChars[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
+// Enough for the worst case packet: a traceroute through 8 hops whose long names need \u escapes for every byte
+#ifndef MESHPACKET_JSON_MAX_LEN
+#define MESHPACKET_JSON_MAX_LEN 3072
+#endif
+
 class MeshPacketSerializer
 {
   public:
+    /// Write the JSON for a packet into buf, returns its length or 0 if it didn't fit. Doesn't allocate, except for text
+    /// messages that are JSON themselves.
+    static size_t JsonSerialize(const meshtastic_MeshPacket *mp, char *buf, size_t bufLen, bool shouldLog = true);
+    static size_t JsonSerializeEncrypted(const meshtastic_MeshPacket *mp, char *buf, size_t bufLen);
+
     static std::string JsonSerialize(const meshtastic_MeshPacket *mp, bool shouldLog = true);
     static std::string JsonSerializeEncrypted(const meshtastic_MeshPacket *mp);
 
@@ -20,4 +30,4 @@ class MeshPacketSerializer
         }
         return result;
     }
-};
\ No newline at end of file
+};
@@ -351,4 +351,26 @@ std::string MeshPacketSerializer::JsonSerializeEncrypted(const meshtastic_MeshPa
 
     return jsonStr;
 }
-#endif
\ No newline at end of file
+
+static size_t copyOut(const std::string &jsonStr, char *buf, size_t bufLen)
+{
+    if (bufLen == 0)
+        return 0;
+    if (jsonStr.length() >= bufLen) {
+        buf[0] = '\0';
+        return 0;
+    }
+    memcpy(buf, jsonStr.c_str(), jsonStr.length() + 1);
+    return jsonStr.length();
+}
+
+size_t MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp, char *buf, size_t bufLen, bool shouldLog)
+{
+    return copyOut(JsonSerialize(mp, shouldLog), buf, bufLen);
+}
+
+size_t MeshPacketSerializer::JsonSerializeEncrypted(const meshtastic_MeshPacket *mp, char *buf, size_t bufLen)
+{
+    return copyOut(JsonSerializeEncrypted(mp), buf, bufLen);
+}
+#endif
@@ -1,6 +1,8 @@
+#include "NodeDB.h"
 #include "SerialConsole.h"
 #include "concurrency/OSThread.h"
 #include "gps/RTC.h"
+#include <stdio.h>
 
 #include "TestUtil.h"
 
@@ -15,4 +17,28 @@ void initializeTestEnvironment()
     perhapsSetRTC(RTCQualityNTP, &tv);
 #endif
     concurrency::OSThread::setup();
-}
\ No newline at end of file
+}
+
+meshtastic_NodeInfoLite *hearTestNode(NodeNum n, uint32_t rxTime)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = n;
+    p.rx_time = rxTime;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    nodeDB->updateFrom(p);
+    return nodeDB->getMeshNode(n);
+}
+
+void printBenchResult(const char *name, const char *impl, long param, uint32_t iterations, long nsPerOp, const char *extra)
+{
+    // One printf for the whole line, so it can't be split by logging from other threads
+    char line[512];
+    int len = snprintf(line, sizeof(line), "{\"bench\":\"%s\"", name);
+    if (impl)
+        len += snprintf(line + len, sizeof(line) - len, ",\"impl\":\"%s\"", impl);
+    len += snprintf(line + len, sizeof(line) - len, ",\"param\":%ld,\"iterations\":%u,\"ns_per_op\":%ld", param, iterations,
+                    nsPerOp);
+    if (extra && *extra)
+        len += snprintf(line + len, sizeof(line) - len, ",%s", extra);
+    printf("%s}\n", line);
+}
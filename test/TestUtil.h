@@ -1,4 +1,38 @@
 #pragma once
 
+#include "NodeDB.h"
+
+#include <chrono>
+
 // Initialize testing environment.
-void initializeTestEnvironment();
\ No newline at end of file
+void initializeTestEnvironment();
+
+// Add (or refresh) node n in nodeDB the way hearing a packet from it would, through the public NodeDB API.
+// Returns the node, or NULL if the DB had no room for it.
+meshtastic_NodeInfoLite *hearTestNode(NodeNum n, uint32_t rxTime);
+
+/**
+ * Benchmarks print one JSON line per case, the format bin/bench-diff.py compares between runs:
+ *   {"bench":"<name>","impl":"<impl>","param":<param>,"iterations":<n>,"ns_per_op":<mean>,<extra>}
+ * impl is left out when NULL, extra is optional and holds already formatted "key":value pairs.
+ */
+void printBenchResult(const char *name, const char *impl, long param, uint32_t iterations, long nsPerOp,
+                      const char *extra = NULL);
+
+// Call fn(i) for i in [0, iterations) and return the mean nanoseconds per call.
+template <typename F> long timeBench(uint32_t iterations, F fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+        fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (long)(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations);
+}
+
+// Warm up with a tenth of the iterations (at least one call), then time fn(i) and print the result line.
+template <typename F> void bench(const char *name, uint32_t param, uint32_t iterations, F fn)
+{
+    for (uint32_t i = 0; i < iterations / 10 || i == 0; i++)
+        fn(i);
+    printBenchResult(name, NULL, param, iterations, timeBench(iterations, fn));
+}
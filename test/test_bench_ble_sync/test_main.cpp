@@ -0,0 +1,163 @@
+#include "FSCommon.h"
+#include "FromRadioBatcher.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "PhoneAPI.h"
+
+#include "TestUtil.h"
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include <vector>
+
+/**
+ * How long a phone takes to download our config and node DB over BLE, one frame per read (the FROMRADIO characteristic)
+ * versus batched up to the MTU (FROMRADIO_BATCH). On a real link the cost is dominated by read round trips, so each case
+ * prints
+ *   {"bench":"ble_sync","impl":"<frame|mtuN>","param":<nodes>,"iterations":<n>,"ns_per_op":<cpu per sync>,
+ *    "reads":<per sync>,"est_sync_ms":<reads at MS_PER_READ plus cpu>}
+ * which bin/bench-diff.py can compare between releases.
+ */
+
+static const NodeNum REMOTE_NODE = 0x12345678;
+
+/// One read round trip, at the 30 ms connection interval phones typically settle on
+static const uint32_t MS_PER_READ = 30;
+
+/// A client that is always connected, so we can run the config handshake without a transport
+class BenchPhoneAPI : public PhoneAPI
+{
+  public:
+    void startConfig() { handleStartConfig(); }
+
+  protected:
+    virtual bool checkIsConnected() override { return true; }
+};
+
+static void fillNodeDB(size_t numNodes)
+{
+    nodeDB->resetNodes();
+    for (size_t i = 1; i < numNodes; i++) {
+        meshtastic_NodeInfoLite *node = hearTestNode(REMOTE_NODE + i, 1700000000 + i);
+        node->has_user = true;
+        snprintf(node->user.long_name, sizeof(node->user.long_name), "Meshtastic %04x", (unsigned)i);
+        snprintf(node->user.short_name, sizeof(node->user.short_name), "%04x", (unsigned)i);
+        node->user.hw_model = meshtastic_HardwareModel_TBEAM;
+        node->has_position = true;
+        node->position.latitude_i = 374200000 + i;
+        node->position.longitude_i = -1220800000 - i;
+        node->snr = 6.25f;
+    }
+}
+
+/// Run a whole handshake, calling read until it returns an empty value
+template <typename F> static uint32_t sync(BenchPhoneAPI &api, F read)
+{
+    api.startConfig();
+    uint32_t reads = 1; // the empty one that tells the client it is done
+    while (read())
+        reads++;
+    return reads;
+}
+
+static uint32_t syncFrames(BenchPhoneAPI &api, std::vector<std::vector<uint8_t>> *frames = NULL)
+{
+    uint8_t buf[meshtastic_FromRadio_size];
+    return sync(api, [&]() {
+        size_t len = api.getFromRadio(buf);
+        if (frames && len)
+            frames->emplace_back(buf, buf + len);
+        return len;
+    });
+}
+
+static uint32_t syncBatches(BenchPhoneAPI &api, FromRadioBatcher &batcher, size_t maxLen,
+                            std::vector<std::vector<uint8_t>> *frames = NULL)
+{
+    uint8_t buf[MAX_TO_FROM_RADIO_SIZE];
+    return sync(api, [&]() {
+        size_t len = batcher.fill(api, buf, maxLen);
+        size_t numFrames = 0;
+        for (size_t at = 0; at < len; numFrames++) {
+            size_t frameLen = buf[at] | (buf[at + 1] << 8);
+            at += FROMRADIO_BATCH_HEADER_SIZE;
+            TEST_ASSERT_TRUE(at + frameLen <= len); // never split
+            if (frames)
+                frames->emplace_back(buf + at, buf + at + frameLen);
+            at += frameLen;
+        }
+        TEST_ASSERT_TRUE(len <= maxLen || numFrames == 1); // only a frame too big on its own may overflow
+        return len;
+    });
+}
+
+void test_BatchesCarrySameFrames(void)
+{
+    fillNodeDB(MAX_NUM_NODES / 2);
+    BenchPhoneAPI api;
+    FromRadioBatcher batcher;
+
+    std::vector<std::vector<uint8_t>> single, batched;
+    uint32_t singleReads = syncFrames(api, &single);
+    TEST_ASSERT_EQUAL(single.size() + 1, singleReads);
+    TEST_ASSERT_TRUE(single.size() > MAX_NUM_NODES / 2);
+
+    for (size_t maxLen : {(size_t)20, (size_t)182, (size_t)244, (size_t)509}) {
+        batched.clear();
+        uint32_t reads = syncBatches(api, batcher, maxLen, &batched);
+        TEST_ASSERT_EQUAL(single.size(), batched.size());
+        for (size_t i = 0; i < single.size(); i++)
+            TEST_ASSERT_TRUE(single[i] == batched[i]);
+
+        if (maxLen == 20) // every frame is bigger than that, so it goes alone
+            TEST_ASSERT_EQUAL(singleReads, reads);
+        else
+            TEST_ASSERT_TRUE(reads < singleReads);
+    }
+}
+
+void test_SyncTime(void)
+{
+    static const struct {
+        const char *impl;
+        size_t maxLen; // 0 for one frame per read
+    } transports[] = {{"frame", 0}, {"mtu185", 185 - 3}, {"mtu247", 247 - 3}, {"mtu512", 512 - 3}};
+    static const uint32_t iterations = 20;
+
+    for (size_t numNodes : {10, MAX_NUM_NODES / 2, MAX_NUM_NODES}) {
+        fillNodeDB(numNodes);
+        for (auto &t : transports) {
+            BenchPhoneAPI api;
+            FromRadioBatcher batcher;
+            uint32_t reads = 0;
+
+            long ns = timeBench(iterations,
+                                [&](uint32_t) { reads = t.maxLen ? syncBatches(api, batcher, t.maxLen) : syncFrames(api); });
+
+            char extra[64];
+            snprintf(extra, sizeof(extra), "\"reads\":%u,\"est_sync_ms\":%ld", reads, reads * MS_PER_READ + ns / 1000000);
+            printBenchResult("ble_sync", t.impl, numNodes, iterations, ns, extra);
+        }
+    }
+    nodeDB->resetNodes();
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB;
+    service = new MeshService;
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_BatchesCarrySameFrames);
+    RUN_TEST(test_SyncTime);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
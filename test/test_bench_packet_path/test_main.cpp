@@ -0,0 +1,202 @@
+#include "FSCommon.h"
+#include "MeshModule.h"
+#include "MeshPacketQueue.h"
+#include "NodeDB.h"
+#include "PacketHistory.h"
+#include "Router.h"
+#include "SinglePortModule.h"
+#include "mesh-pb-constants.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+/**
+ * Microbenchmarks for the receive/transmit hot path. Each case prints one JSON line:
+ *   {"bench":"<name>","param":<size or 0>,"iterations":<n>,"ns_per_op":<mean>}
+ * (see printBenchResult()), so the output of two releases can be compared with bin/bench-diff.py.
+ */
+
+static const NodeNum REMOTE_NODE = 0x12345678;
+
+static meshtastic_MeshPacket makeTextPacket(size_t payloadLen)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = REMOTE_NODE;
+    p.to = NODENUM_BROADCAST;
+    p.id = 0x1000;
+    p.channel = 0;
+    p.hop_limit = 3;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    p.decoded.payload.size = payloadLen;
+    for (size_t i = 0; i < payloadLen; i++)
+        p.decoded.payload.bytes[i] = 'a' + i % 26;
+    return p;
+}
+
+/** A module that only wants one private portnum, so callModules() has to ask every instance */
+class BenchModule : public SinglePortModule
+{
+  public:
+    uint32_t handled = 0;
+
+    explicit BenchModule(meshtastic_PortNum port) : SinglePortModule("bench", port) {}
+
+  protected:
+    virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override
+    {
+        handled++;
+        return ProcessMessage::CONTINUE;
+    }
+};
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_PbEncodeData(void)
+{
+    static uint8_t buf[meshtastic_Constants_DATA_PAYLOAD_LEN + 32];
+    for (size_t len : {16, 64, 200}) {
+        meshtastic_MeshPacket p = makeTextPacket(len);
+        size_t encoded = 0;
+        bench("pb_encode_data", len, 100000,
+              [&](uint32_t) { encoded = pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_Data_msg, &p.decoded); });
+        TEST_ASSERT_TRUE(encoded > len);
+    }
+}
+
+void test_PerhapsEncodeDecode(void)
+{
+    for (size_t len : {16, 64, 200}) {
+        const meshtastic_MeshPacket plain = makeTextPacket(len);
+        meshtastic_MeshPacket p;
+
+        // Both cases include the copy of a fresh packet, since encode/decode rewrite it in place
+        bench("perhaps_encode", len, 20000, [&](uint32_t) {
+            p = plain;
+            perhapsEncode(&p);
+        });
+        TEST_ASSERT_EQUAL(meshtastic_MeshPacket_encrypted_tag, p.which_payload_variant);
+
+        const meshtastic_MeshPacket encrypted = p;
+        bool ok = false;
+        bench("perhaps_decode", len, 20000, [&](uint32_t) {
+            p = encrypted;
+            ok = perhapsDecode(&p);
+        });
+        TEST_ASSERT_TRUE(ok);
+        TEST_ASSERT_EQUAL(len, p.decoded.payload.size);
+    }
+}
+
+void test_WasSeenRecently(void)
+{
+    PacketHistory history;
+    meshtastic_MeshPacket p = makeTextPacket(0);
+
+    bench("was_seen_recently_miss", 0, 100000, [&](uint32_t i) {
+        p.id = 0x10000 + i;
+        history.wasSeenRecently(&p);
+    });
+    bench("was_seen_recently_hit", 0, 100000, [&](uint32_t i) {
+        p.id = 0x10000 + i % 64;
+        history.wasSeenRecently(&p);
+    });
+    p.id = 0x10000;
+    TEST_ASSERT_TRUE(history.wasSeenRecently(&p));
+}
+
+void test_PacketQueue(void)
+{
+    for (size_t depth : {4, 16, 64}) {
+        MeshPacketQueue q(depth + 1);
+        static meshtastic_MeshPacket packets[65];
+        for (size_t i = 0; i <= depth; i++) {
+            packets[i] = makeTextPacket(0);
+            packets[i].id = i + 1;
+            packets[i].priority = (meshtastic_MeshPacket_Priority)(meshtastic_MeshPacket_Priority_DEFAULT + i % 3);
+        }
+        for (size_t i = 0; i < depth; i++)
+            q.enqueue(&packets[i]);
+
+        // Keep the queue at a steady depth: enqueue one, take the best one out again
+        meshtastic_MeshPacket *spare = &packets[depth];
+        bench("txqueue_enqueue_dequeue", depth, 100000, [&](uint32_t) {
+            q.enqueue(spare);
+            spare = q.dequeue();
+        });
+        TEST_ASSERT_NOT_NULL(spare);
+    }
+}
+
+void test_UpdateFrom(void)
+{
+    for (size_t size : {10, MAX_NUM_NODES / 2, MAX_NUM_NODES}) {
+        nodeDB->resetNodes();
+        for (size_t i = 1; i < size; i++)
+            hearTestNode(REMOTE_NODE + i, 1000 + i);
+        TEST_ASSERT_EQUAL(size, nodeDB->getNumMeshNodes());
+
+        // What every decoded packet costs NodeDB: find the sender and move it to the recent end of the eviction order
+        meshtastic_MeshPacket p = makeTextPacket(16);
+        p.rx_time = 2000;
+        bench("node_db_update_from", size, 100000, [&](uint32_t i) {
+            p.from = REMOTE_NODE + 1 + (i * 7) % (size - 1);
+            nodeDB->updateFrom(p);
+        });
+        TEST_ASSERT_EQUAL(size, nodeDB->getNumMeshNodes());
+
+        meshtastic_NodeInfoLite *found = NULL;
+        bench("get_mesh_node", size, 100000,
+              [&](uint32_t i) { found = nodeDB->getMeshNode(REMOTE_NODE + 1 + (i * 7) % (size - 1)); });
+        TEST_ASSERT_NOT_NULL(found);
+    }
+    nodeDB->resetNodes();
+}
+
+void test_CallModules(void)
+{
+    static const size_t numModules = 24;
+    static BenchModule *benchModules[numModules];
+    for (size_t i = 0; i < numModules; i++)
+        benchModules[i] = new BenchModule((meshtastic_PortNum)(meshtastic_PortNum_PRIVATE_APP + i));
+
+    meshtastic_MeshPacket p = makeTextPacket(16);
+    p.decoded.portnum = (meshtastic_PortNum)(meshtastic_PortNum_PRIVATE_APP + numModules - 1);
+    bench("call_modules", numModules, 20000, [&](uint32_t) { MeshModule::callModules(p); });
+    TEST_ASSERT_TRUE(benchModules[numModules - 1]->handled > 0);
+    TEST_ASSERT_EQUAL(0, benchModules[0]->handled);
+
+    for (size_t i = 0; i < numModules; i++)
+        delete benchModules[i];
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB; // channels and our node number for encode/decode and module dispatch
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_PbEncodeData);
+    RUN_TEST(test_PerhapsEncodeDecode);
+    RUN_TEST(test_WasSeenRecently);
+    RUN_TEST(test_PacketQueue);
+    RUN_TEST(test_UpdateFrom);
+    RUN_TEST(test_CallModules);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
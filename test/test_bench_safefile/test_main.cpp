@@ -0,0 +1,181 @@
+#include "FSCommon.h"
+#include "SafeFile.h"
+#include "mesh-pb-constants.h"
+
+#include "TestUtil.h"
+#include <algorithm>
+#include <stdio.h>
+#include <unity.h>
+#include <vector>
+
+#ifdef FSCom
+
+/**
+ * Write throughput of SafeFile for files the size of the ones NodeDB saves. Each case prints one JSON line:
+ *   {"bench":"<name>","param":<file bytes>,"iterations":<n>,"ns_per_op":<mean per file>}
+ * Run on native this measures our own overhead, run on a board it measures the flash.
+ */
+
+static const char *BENCH_FILE = "/bench/safefile.bin";
+
+/// A full node DB, what saveDeviceStateToDisk() writes when it can't just append to the journal
+static const size_t DEVICESTATE_BYTES = 100 * meshtastic_NodeInfoLite_size;
+
+/**
+ * SafeFile as it used to be: every write goes straight to the filesystem, an 8 bit xor hash, and readback one byte per
+ * read() call. Kept here so the benchmark can compare against it.
+ */
+class LegacySafeFile : public Print
+{
+    String filename;
+    File f;
+    uint8_t hash = 0;
+
+    static File openTmp(const String &filename)
+    {
+        FSCom.remove(filename.c_str());
+        return FSCom.open((filename + ".tmp").c_str(), FILE_O_WRITE);
+    }
+
+  public:
+    explicit LegacySafeFile(const char *filepath) : filename(filepath), f(openTmp(filename)) {}
+
+    virtual size_t write(uint8_t ch) override { return write(&ch, 1); }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) override
+    {
+        for (size_t i = 0; i < size; i++)
+            hash ^= buffer[i];
+        return f.write((uint8_t const *)buffer, size);
+    }
+
+    bool close()
+    {
+        f.close();
+        auto f2 = FSCom.open((filename + ".tmp").c_str(), FILE_O_READ);
+        int c;
+        uint8_t test_hash = 0;
+        while ((c = f2.read()) >= 0)
+            test_hash ^= (uint8_t)c;
+        f2.close();
+        return test_hash == hash && renameFile((filename + ".tmp").c_str(), filename.c_str());
+    }
+};
+
+/// Hand data to out in the small pieces nanopb writes, a tag or length prefix and then a field
+static void writeLikeNanopb(Print &out, const std::vector<uint8_t> &data)
+{
+    static const size_t pieces[] = {1, 1, 4, 2, 16, 1, 8, 40};
+    size_t at = 0;
+    for (int i = 0; at < data.size(); i++) {
+        size_t n = std::min(pieces[i % 8], data.size() - at);
+        TEST_ASSERT_EQUAL(n, out.write(data.data() + at, n));
+        at += n;
+    }
+}
+
+static std::vector<uint8_t> makeData(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++)
+        data[i] = (uint8_t)(i * 31 + 7);
+    return data;
+}
+
+static std::vector<uint8_t> readAll(const char *filename)
+{
+    std::vector<uint8_t> data;
+    auto f = FSCom.open(filename, FILE_O_READ);
+    int c;
+    while ((c = f.read()) >= 0)
+        data.push_back(c);
+    f.close();
+    return data;
+}
+
+void setUp(void)
+{
+    FSCom.mkdir("/bench");
+}
+
+void tearDown(void)
+{
+    FSCom.remove(BENCH_FILE);
+}
+
+void test_WritesWholeFile(void)
+{
+    // Around the block size, where the last partial block has to be flushed by close()
+    const size_t sizes[] = {0, 1, SAFEFILE_BLOCK_SIZE - 1, SAFEFILE_BLOCK_SIZE, SAFEFILE_BLOCK_SIZE + 1, 5000};
+    for (size_t len : sizes) {
+        std::vector<uint8_t> data = makeData(len);
+        SafeFile f(BENCH_FILE, true);
+        writeLikeNanopb(f, data);
+        TEST_ASSERT_TRUE(f.close());
+        TEST_ASSERT_TRUE(readAll(BENCH_FILE) == data);
+    }
+}
+
+void test_SingleByteWrites(void)
+{
+    std::vector<uint8_t> data = makeData(3 * SAFEFILE_BLOCK_SIZE / 2);
+    SafeFile f(BENCH_FILE, false);
+    for (uint8_t c : data)
+        TEST_ASSERT_EQUAL(1, f.write(c));
+    TEST_ASSERT_TRUE(f.close());
+    TEST_ASSERT_TRUE(readAll(BENCH_FILE) == data);
+}
+
+void test_Benchmark(void)
+{
+    struct {
+        const char *name;
+        size_t bytes;
+    } files[] = {
+        {"config", meshtastic_LocalConfig_size},
+        {"channels", meshtastic_ChannelFile_size},
+        {"devicestate", DEVICESTATE_BYTES},
+    };
+    for (auto &file : files) {
+        std::vector<uint8_t> data = makeData(file.bytes);
+        uint32_t iterations = file.bytes > 4096 ? 10 : 50;
+        char name[40];
+
+        snprintf(name, sizeof(name), "safefile_%s", file.name);
+        bench(name, file.bytes, iterations, [&](uint32_t) {
+            SafeFile f(BENCH_FILE, true);
+            writeLikeNanopb(f, data);
+            TEST_ASSERT_TRUE(f.close());
+        });
+
+        snprintf(name, sizeof(name), "safefile_legacy_%s", file.name);
+        bench(name, file.bytes, iterations, [&](uint32_t) {
+            LegacySafeFile f(BENCH_FILE);
+            writeLikeNanopb(f, data);
+            TEST_ASSERT_TRUE(f.close());
+        });
+    }
+}
+
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#ifdef FSCom
+    RUN_TEST(test_WritesWholeFile);
+    RUN_TEST(test_SingleByteWrites);
+    RUN_TEST(test_Benchmark);
+#endif
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
@@ -138,6 +138,37 @@ void test_PKC_Decrypt(void)
     TEST_ASSERT_EQUAL_MEMORY(expected_decrypted, decrypted, 10);
 }
 
+void test_PKC_SharedKeyCache(void)
+{
+    uint8_t private_key[32];
+    meshtastic_UserLite_public_key_t public_key;
+    uint8_t expected_decrypted[32];
+    uint8_t radioBytes[128] __attribute__((__aligned__));
+    uint8_t decrypted[128] __attribute__((__aligned__));
+
+    HexToBytes(public_key.bytes, "db18fc50eea47f00251cb784819a3cf5fc361882597f589f0d7ff820e8064457");
+    public_key.size = 32;
+    HexToBytes(private_key, "a00330633e63522f8a4d81ec6d9d1e6617f6c8ffd3a4c698229537d44e522277");
+    HexToBytes(expected_decrypted, "08011204746573744800");
+    HexToBytes(radioBytes, "8c646d7a2909000062d6b2136b00000040df24abfcc30a17a3d9046726099e796a1c036a792b");
+
+    crypto->setDHPrivateKey(private_key); // Also empties the cache
+    uint32_t hits = crypto->getSharedKeyCacheHits(), misses = crypto->getSharedKeyCacheMisses();
+
+    TEST_ASSERT(crypto->decryptCurve25519(0x0929, public_key, 0x13b2d662, 22, radioBytes + 16, decrypted));
+    TEST_ASSERT_EQUAL(misses + 1, crypto->getSharedKeyCacheMisses());
+
+    memset(decrypted, 0, sizeof(decrypted));
+    TEST_ASSERT(crypto->decryptCurve25519(0x0929, public_key, 0x13b2d662, 22, radioBytes + 16, decrypted));
+    TEST_ASSERT_EQUAL(hits + 1, crypto->getSharedKeyCacheHits());
+    TEST_ASSERT_EQUAL_MEMORY(expected_decrypted, decrypted, 10);
+
+    // A new private key must never reuse a key derived from the old one
+    crypto->setDHPrivateKey(private_key);
+    crypto->decryptCurve25519(0x0929, public_key, 0x13b2d662, 22, radioBytes + 16, decrypted);
+    TEST_ASSERT_EQUAL(misses + 2, crypto->getSharedKeyCacheMisses());
+}
+
 void test_AES_CTR(void)
 {
     uint8_t expected[32];
@@ -178,6 +209,7 @@ void setup()
     RUN_TEST(test_DH25519);
     RUN_TEST(test_AES_CTR);
     RUN_TEST(test_PKC_Decrypt);
+    RUN_TEST(test_PKC_SharedKeyCache);
     exit(UNITY_END()); // stop unit testing
 }
 
@@ -0,0 +1,150 @@
+#include "concurrency/OSThread.h"
+
+#include "TestUtil.h"
+#include <thread>
+#include <unity.h>
+#include <vector>
+
+static concurrency::DeadlineController *testController;
+static std::vector<char> ran;
+
+/// Records its name in ran each time it runs
+class NamedThread : public concurrency::OSThread
+{
+  public:
+    char name;
+    int32_t next = RUN_SAME;
+    bool disableSelf = false;
+    NamedThread *victim = NULL; // deleted the first time we run
+
+    NamedThread(char name, uint32_t period) : OSThread("named", period, testController), name(name) {}
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        ran.push_back(name);
+        if (victim) {
+            delete victim;
+            victim = NULL;
+        }
+        return disableSelf ? disable() : next;
+    }
+};
+
+void setUp(void)
+{
+    testController = new concurrency::DeadlineController();
+    ran.clear();
+}
+
+void tearDown(void)
+{
+    delete testController;
+}
+
+void test_RunsDueThreadsSoonestFirst(void)
+{
+    NamedThread c('c', 30), a('a', 10), b('b', 20);
+    TEST_ASSERT_EQUAL(3, testController->size());
+
+    long wait = testController->runOrDelay();
+    TEST_ASSERT_EQUAL(0, ran.size());
+    TEST_ASSERT_INT_WITHIN(2, 10, wait);
+
+    delay(35);
+    testController->runOrDelay();
+    TEST_ASSERT_EQUAL(3, ran.size());
+    TEST_ASSERT_EQUAL('a', ran[0]);
+    TEST_ASSERT_EQUAL('b', ran[1]);
+    TEST_ASSERT_EQUAL('c', ran[2]);
+}
+
+void test_RunsEachThreadOncePerPass(void)
+{
+    NamedThread a('a', 0);
+    a.next = 0; // always wants to run again right away
+
+    TEST_ASSERT_EQUAL(0, testController->runOrDelay());
+    TEST_ASSERT_EQUAL(1, ran.size());
+    testController->runOrDelay();
+    TEST_ASSERT_EQUAL(2, ran.size());
+}
+
+void test_SetIntervalMovesThreadUp(void)
+{
+    NamedThread slow('s', 10000);
+    slow.next = 10000;
+    TEST_ASSERT_GREATER_THAN(5000, testController->runOrDelay());
+
+    slow.setInterval(0); // what notify() and TypedQueue readers do
+    TEST_ASSERT_GREATER_THAN(5000, testController->runOrDelay());
+    TEST_ASSERT_EQUAL(1, ran.size());
+}
+
+void test_DisabledThreadIsParkedUntilEnabled(void)
+{
+    NamedThread a('a', 0), b('b', 10000);
+    a.disableSelf = true;
+    testController->runOrDelay(); // a runs once and disables itself
+    TEST_ASSERT_EQUAL(1, ran.size());
+
+    // Only b is waiting, a doesn't cost us any wakeups
+    TEST_ASSERT_GREATER_THAN(5000, testController->runOrDelay());
+
+    a.disableSelf = false;
+    a.enabled = true;
+    a.setInterval(0);
+    testController->runOrDelay();
+    TEST_ASSERT_EQUAL(2, ran.size());
+    TEST_ASSERT_EQUAL('a', ran[1]);
+}
+
+void test_ThreadDeletedMidPassDoesNotRun(void)
+{
+    NamedThread a('a', 0);
+    NamedThread *b = new NamedThread('b', 5);
+    a.victim = b;
+    delay(10);
+
+    testController->runOrDelay();
+    TEST_ASSERT_EQUAL(1, ran.size());
+    TEST_ASSERT_EQUAL('a', ran[0]);
+    TEST_ASSERT_EQUAL(1, testController->size());
+}
+
+void test_InterruptEndsDelayEarly(void)
+{
+    concurrency::InterruptableDelay sleeper;
+    uint32_t start = millis();
+    std::thread waker([&] {
+        delay(20);
+        sleeper.interrupt();
+    });
+    TEST_ASSERT_FALSE(sleeper.delay(5000)); // false means we were interrupted
+    waker.join();
+    TEST_ASSERT_LESS_THAN(1000, millis() - start);
+
+    TEST_ASSERT_TRUE(sleeper.delay(5));
+    TEST_ASSERT_GREATER_THAN(0, sleeper.getWakeupsPerHour());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_RunsDueThreadsSoonestFirst);
+    RUN_TEST(test_RunsEachThreadOncePerPass);
+    RUN_TEST(test_SetIntervalMovesThreadUp);
+    RUN_TEST(test_DisabledThreadIsParkedUntilEnabled);
+    RUN_TEST(test_ThreadDeletedMidPassDoesNotRun);
+    RUN_TEST(test_InterruptEndsDelayEarly);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
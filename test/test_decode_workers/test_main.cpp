@@ -0,0 +1,210 @@
+#include "DecodeWorkerPool.h"
+#include "FSCommon.h"
+#include "NodeDB.h"
+#include "Router.h"
+#include "concurrency/SPSCQueue.h"
+
+#include "TestUtil.h"
+#include <thread>
+#include <unity.h>
+
+static const NodeNum REMOTE_NODE = 0x12345678;
+static const size_t NUM_PACKETS = 64;
+
+static meshtastic_MeshPacket plain[NUM_PACKETS], encrypted[NUM_PACKETS];
+
+/// A mix of channel packets of different sizes, the odd ones sent with a key we don't have
+static void makePackets()
+{
+    for (size_t i = 0; i < NUM_PACKETS; i++) {
+        meshtastic_MeshPacket &p = plain[i];
+        p = meshtastic_MeshPacket_init_zero;
+        p.from = REMOTE_NODE;
+        p.to = NODENUM_BROADCAST;
+        p.id = 0x1000 + i;
+        p.hop_limit = 3;
+        p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+        p.decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+        p.decoded.payload.size = 1 + (i * 37) % 200;
+        for (size_t j = 0; j < p.decoded.payload.size; j++)
+            p.decoded.payload.bytes[j] = 'a' + (i + j) % 26;
+
+        encrypted[i] = p;
+        perhapsEncode(&encrypted[i]);
+        if (i % 2)
+            encrypted[i].encrypted.bytes[0] ^= 0xff; // now it won't decode with any of our keys
+    }
+}
+
+/// Push everything through the pool, checking it comes back in order and decodes to what perhapsDecode() gets
+static void runPool(DecodeWorkerPool &pool, meshtastic_MeshPacket *packets, size_t numPackets)
+{
+    size_t submitted = 0, handled = 0;
+    while (handled < numPackets) {
+        while (!pool.isFull() && submitted < numPackets)
+            pool.submit(&packets[submitted++]);
+
+        const DecodeJob *job;
+        while ((job = pool.front()) != NULL) {
+            TEST_ASSERT_EQUAL_PTR(&packets[handled], job->p);
+
+            meshtastic_MeshPacket inline_ = *job->p, adopted = *job->p;
+            bool inlineOk = perhapsDecode(&inline_);
+            bool adoptedOk = perhapsDecode(&adopted, job->offloaded ? &job->result : NULL);
+            TEST_ASSERT_EQUAL(inlineOk, adoptedOk);
+            if (inlineOk) {
+                TEST_ASSERT_EQUAL(inline_.channel, adopted.channel);
+                TEST_ASSERT_EQUAL(inline_.decoded.portnum, adopted.decoded.portnum);
+                TEST_ASSERT_EQUAL(inline_.decoded.payload.size, adopted.decoded.payload.size);
+                TEST_ASSERT_EQUAL_MEMORY(inline_.decoded.payload.bytes, adopted.decoded.payload.bytes,
+                                         inline_.decoded.payload.size);
+            }
+
+            pool.pop();
+            handled++;
+        }
+    }
+    TEST_ASSERT_TRUE(pool.isIdle());
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_EncryptPackets(void)
+{
+    makePackets();
+    for (size_t i = 0; i < NUM_PACKETS; i++)
+        TEST_ASSERT_EQUAL(meshtastic_MeshPacket_encrypted_tag, encrypted[i].which_payload_variant);
+}
+
+void test_SPSCQueueOrderAndCapacity(void)
+{
+    concurrency::SPSCQueue<int, 8> q;
+    int v;
+    TEST_ASSERT_TRUE(q.isEmpty());
+    TEST_ASSERT_FALSE(q.pop(v));
+
+    for (int i = 0; i < 7; i++)
+        TEST_ASSERT_TRUE(q.push(i));
+    TEST_ASSERT_FALSE(q.push(7)); // one slot always stays free
+
+    for (int i = 0; i < 7; i++) {
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL(i, v);
+    }
+    TEST_ASSERT_TRUE(q.isEmpty());
+}
+
+void test_SPSCQueueAcrossThreads(void)
+{
+    static concurrency::SPSCQueue<uint32_t, 16> q;
+    const uint32_t count = 1000000;
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < count; i++)
+            while (!q.push(i))
+                std::this_thread::yield();
+    });
+
+    uint32_t expected = 0, v;
+    while (expected < count) {
+        if (q.pop(v))
+            TEST_ASSERT_EQUAL_UINT32(expected++, v);
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+    TEST_ASSERT_TRUE(q.isEmpty());
+}
+
+void test_WorkersMatchInlineDecode(void)
+{
+    for (uint8_t numWorkers : {1, 3}) {
+        meshtastic_MeshPacket packets[NUM_PACKETS];
+        memcpy(packets, encrypted, sizeof(packets));
+        DecodeWorkerPool pool(numWorkers);
+        runPool(pool, packets, NUM_PACKETS);
+        TEST_ASSERT_EQUAL(NUM_PACKETS, pool.getNumOffloaded());
+        TEST_ASSERT_EQUAL(0, pool.getNumInline());
+    }
+}
+
+void test_MainThreadKeepsWhatWorkersCantDo(void)
+{
+    meshtastic_MeshPacket packets[3] = {plain[0], encrypted[0], encrypted[2]};
+    packets[1].channel ^= 0x55; // a hash none of our channels have
+    packets[2].to = nodeDB->getNodeNum();
+    packets[2].channel = 0; // might be PKI
+
+    DecodeWorkerPool pool(2);
+    runPool(pool, packets, 3);
+    TEST_ASSERT_EQUAL(0, pool.getNumOffloaded());
+    TEST_ASSERT_EQUAL(3, pool.getNumInline());
+}
+
+/// Prints {"bench":"decode_workers","param":<workers, 0 for perhapsDecode() on this thread>,...} per packet
+void test_BenchDecodeWorkers(void)
+{
+    const uint32_t rounds = 500;
+    static meshtastic_MeshPacket packets[NUM_PACKETS];
+
+    for (uint8_t numWorkers : {0, 1, 2, 4}) {
+        DecodeWorkerPool *pool = numWorkers ? new DecodeWorkerPool(numWorkers) : NULL;
+        uint32_t decoded = 0;
+
+        long ns = timeBench(rounds, [&](uint32_t) {
+            memcpy(packets, encrypted, sizeof(packets));
+            if (!pool) {
+                for (size_t i = 0; i < NUM_PACKETS; i++)
+                    decoded += perhapsDecode(&packets[i]);
+                return;
+            }
+            size_t submitted = 0, handled = 0;
+            while (handled < NUM_PACKETS) {
+                while (!pool->isFull() && submitted < NUM_PACKETS)
+                    pool->submit(&packets[submitted++]);
+                const DecodeJob *job;
+                while ((job = pool->front()) != NULL) {
+                    decoded += perhapsDecode(job->p, job->offloaded ? &job->result : NULL);
+                    pool->pop();
+                    handled++;
+                }
+            }
+        });
+
+        uint32_t iterations = rounds * NUM_PACKETS;
+        printBenchResult("decode_workers", NULL, numWorkers, iterations, ns / NUM_PACKETS);
+        TEST_ASSERT_EQUAL(iterations / 2, decoded);
+        delete pool;
+    }
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB; // channels and our node number for encode/decode
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_EncryptPackets);
+    RUN_TEST(test_SPSCQueueOrderAndCapacity);
+    RUN_TEST(test_SPSCQueueAcrossThreads);
+    RUN_TEST(test_WorkersMatchInlineDecode);
+    RUN_TEST(test_MainThreadKeepsWhatWorkersCantDo);
+    RUN_TEST(test_BenchDecodeWorkers);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
@@ -0,0 +1,354 @@
+#include "FSCommon.h"
+#include "NodeDB.h"
+#include "mesh-pb-constants.h"
+#include "mesh/generated/meshtastic/remote_hardware.pb.h"
+#include "mesh/generated/meshtastic/telemetry.pb.h"
+#include "serialization/MeshPacketSerializer.h"
+
+#include "TestUtil.h"
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+/**
+ * Checks that the JSON we publish to MQTT keeps its exact format, and benchmarks it per portnum (-1 for an encrypted
+ * packet). Each benchmark case prints
+ *   {"bench":"json_serialize","impl":"buffer|string","param":<portnum>,"iterations":<n>,"ns_per_op":<mean>,"allocs_per_op":<n>}
+ * which bin/bench-diff.py understands.
+ */
+
+// Count every heap allocation in this test binary, the serializer is supposed to make none
+static std::atomic<uint32_t> numAllocs(0);
+
+void *operator new(size_t size)
+{
+    numAllocs++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        abort();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static char json[MESHPACKET_JSON_MAX_LEN];
+
+static meshtastic_MeshPacket makePacket(meshtastic_PortNum portnum)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = 0x12345678;
+    p.to = NODENUM_BROADCAST;
+    p.id = 77;
+    p.rx_snr = 6.25;
+    p.rx_rssi = -90;
+    p.hop_start = 3;
+    p.hop_limit = 2;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.decoded.portnum = portnum;
+    return p;
+}
+
+static meshtastic_MeshPacket makeText(const char *text, meshtastic_PortNum portnum = meshtastic_PortNum_TEXT_MESSAGE_APP)
+{
+    meshtastic_MeshPacket p = makePacket(portnum);
+    p.decoded.payload.size = strlen(text);
+    memcpy(p.decoded.payload.bytes, text, p.decoded.payload.size);
+    return p;
+}
+
+template <typename T> static meshtastic_MeshPacket makeProto(meshtastic_PortNum portnum, const pb_msgdesc_t *fields, const T &msg)
+{
+    meshtastic_MeshPacket p = makePacket(portnum);
+    p.decoded.payload.size = pb_encode_to_bytes(p.decoded.payload.bytes, sizeof(p.decoded.payload.bytes), fields, &msg);
+    return p;
+}
+
+static meshtastic_MeshPacket makePosition()
+{
+    meshtastic_Position pos = meshtastic_Position_init_zero;
+    pos.has_latitude_i = pos.has_longitude_i = pos.has_altitude = true;
+    pos.latitude_i = 523456789;
+    pos.longitude_i = -45678901;
+    pos.altitude = 12;
+    pos.time = 1700000000;
+    pos.sats_in_view = 7;
+    pos.precision_bits = 32;
+    pos.PDOP = 150;
+    return makeProto(meshtastic_PortNum_POSITION_APP, &meshtastic_Position_msg, pos);
+}
+
+static meshtastic_MeshPacket makeEnvironment()
+{
+    meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
+    t.which_variant = meshtastic_Telemetry_environment_metrics_tag;
+    t.variant.environment_metrics.has_temperature = true;
+    t.variant.environment_metrics.temperature = 21.5;
+    t.variant.environment_metrics.has_relative_humidity = true;
+    t.variant.environment_metrics.relative_humidity = 48.25;
+    t.variant.environment_metrics.has_barometric_pressure = true;
+    t.variant.environment_metrics.barometric_pressure = 1013.2f;
+    return makeProto(meshtastic_PortNum_TELEMETRY_APP, &meshtastic_Telemetry_msg, t);
+}
+
+static meshtastic_MeshPacket makeNodeInfo()
+{
+    meshtastic_User u = meshtastic_User_init_zero;
+    strcpy(u.id, "!12345678");
+    strcpy(u.long_name, "Bench \"node\"");
+    strcpy(u.short_name, "BN");
+    u.hw_model = meshtastic_HardwareModel_HELTEC_V3;
+    u.role = meshtastic_Config_DeviceConfig_Role_ROUTER;
+    return makeProto(meshtastic_PortNum_NODEINFO_APP, &meshtastic_User_msg, u);
+}
+
+static meshtastic_MeshPacket makeWaypoint()
+{
+    meshtastic_Waypoint w = meshtastic_Waypoint_init_zero;
+    w.id = 42;
+    w.has_latitude_i = w.has_longitude_i = true;
+    w.latitude_i = 523456789;
+    w.longitude_i = 45678901;
+    w.expire = 1700003600;
+    strcpy(w.name, "Camp");
+    strcpy(w.description, "Meet here at 10/11");
+    return makeProto(meshtastic_PortNum_WAYPOINT_APP, &meshtastic_Waypoint_msg, w);
+}
+
+static meshtastic_MeshPacket makeNeighborInfo()
+{
+    meshtastic_NeighborInfo n = meshtastic_NeighborInfo_init_zero;
+    n.node_id = 0x12345678;
+    n.last_sent_by_id = 0x12345678;
+    n.node_broadcast_interval_secs = 900;
+    n.neighbors_count = 10;
+    for (uint8_t i = 0; i < n.neighbors_count; i++) {
+        n.neighbors[i].node_id = 0x1000 + i;
+        n.neighbors[i].snr = 2.5 * i - 10;
+    }
+    return makeProto(meshtastic_PortNum_NEIGHBORINFO_APP, &meshtastic_NeighborInfo_msg, n);
+}
+
+static meshtastic_MeshPacket makeTraceroute()
+{
+    meshtastic_RouteDiscovery r = meshtastic_RouteDiscovery_init_zero;
+    r.route_count = 2;
+    r.route[0] = 5;
+    r.route[1] = 6;
+    meshtastic_MeshPacket p = makeProto(meshtastic_PortNum_TRACEROUTE_APP, &meshtastic_RouteDiscovery_msg, r);
+    p.decoded.request_id = 9;
+    p.to = 0x11;
+    return p;
+}
+
+static meshtastic_MeshPacket makeRemoteHardware()
+{
+    meshtastic_HardwareMessage h = meshtastic_HardwareMessage_init_zero;
+    h.type = meshtastic_HardwareMessage_Type_READ_GPIOS_REPLY;
+    h.gpio_mask = 0xff;
+    h.gpio_value = 0x0f;
+    return makeProto(meshtastic_PortNum_REMOTE_HARDWARE_APP, &meshtastic_HardwareMessage_msg, h);
+}
+
+static meshtastic_MeshPacket makeEncrypted()
+{
+    meshtastic_MeshPacket p = makePacket(meshtastic_PortNum_UNKNOWN_APP);
+    p.which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p.encrypted.size = 64;
+    for (size_t i = 0; i < p.encrypted.size; i++)
+        p.encrypted.bytes[i] = i * 37;
+    p.encrypted.bytes[0] = 0x01;
+    p.encrypted.bytes[1] = 0xff;
+    return p;
+}
+
+static void assertJson(const char *expected, const meshtastic_MeshPacket &p)
+{
+    size_t len = MeshPacketSerializer::JsonSerialize(&p, json, sizeof(json), false);
+    TEST_ASSERT_EQUAL_STRING(expected, json);
+    TEST_ASSERT_EQUAL(strlen(expected), len);
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+// The expected strings are what the JSONValue tree based serializer produced, which MQTT consumers rely on
+
+void test_Text(void)
+{
+    assertJson("{\"channel\":0,\"from\":305419896,\"hop_start\":3,\"hops_away\":1,\"id\":77,\"payload\":{\"text\":\"Hi "
+               "\\\"there\\\", a\\/b\\n\\t\\u0000\"},\"rssi\":-90,\"sender\":\"!abcd1234\",\"snr\":6.25,\"timestamp\":0,"
+               "\"to\":4294967295,\"type\":\"text\"}",
+               makeText("Hi \"there\", a/b\n\t\x01"));
+}
+
+void test_TextThatIsJson(void)
+{
+    assertJson("{\"channel\":0,\"from\":305419896,\"hop_start\":3,\"hops_away\":1,\"id\":77,\"payload\":{\"a\":[true,null],"
+               "\"b\":1.5},\"rssi\":-90,\"sender\":\"!abcd1234\",\"snr\":6.25,\"timestamp\":0,\"to\":4294967295,"
+               "\"type\":\"text\"}",
+               makeText(" {\"b\": 1.50, \"a\": [true, null]} "));
+}
+
+void test_Position(void)
+{
+    assertJson("{\"channel\":0,\"from\":305419896,\"hop_start\":3,\"hops_away\":1,\"id\":77,\"payload\":{\"PDOP\":150,"
+               "\"altitude\":12,\"latitude_i\":523456789,\"longitude_i\":-45678901,\"precision_bits\":32,\"sats_in_view\":7,"
+               "\"time\":1700000000},\"rssi\":-90,\"sender\":\"!abcd1234\",\"snr\":6.25,\"timestamp\":0,\"to\":4294967295,"
+               "\"type\":\"position\"}",
+               makePosition());
+}
+
+void test_Telemetry(void)
+{
+    assertJson("{\"channel\":0,\"from\":305419896,\"hop_start\":3,\"hops_away\":1,\"id\":77,\"payload\":{"
+               "\"barometric_pressure\":1013.20001220703,\"current\":0,\"gas_resistance\":0,\"iaq\":0,\"lux\":0,"
+               "\"radiation\":0,\"relative_humidity\":48.25,\"temperature\":21.5,\"voltage\":0,\"white_lux\":0,"
+               "\"wind_direction\":0,\"wind_gust\":0,\"wind_lull\":0,\"wind_speed\":0},\"rssi\":-90,\"sender\":\"!abcd1234\","
+               "\"snr\":6.25,\"timestamp\":0,\"to\":4294967295,\"type\":\"telemetry\"}",
+               makeEnvironment());
+}
+
+void test_Traceroute(void)
+{
+    meshtastic_MeshPacket p = makeTraceroute();
+    p.hop_start = 0;
+    p.rx_snr = 0;
+    p.rx_rssi = 0;
+    p.rx_time = 1700000000;
+    assertJson("{\"channel\":0,\"from\":305419896,\"id\":77,\"payload\":{\"route\":[\"Unknown\",\"Unknown\",\"Unknown\","
+               "\"Unknown\"]},\"sender\":\"!abcd1234\",\"timestamp\":1700000000,\"to\":17,\"type\":\"traceroute\"}",
+               p);
+}
+
+void test_UndecodableHasNoPayload(void)
+{
+    meshtastic_MeshPacket p = makeText("\xff\xff\xff", meshtastic_PortNum_POSITION_APP);
+    assertJson("{\"channel\":0,\"from\":305419896,\"hop_start\":3,\"hops_away\":1,\"id\":77,\"rssi\":-90,"
+               "\"sender\":\"!abcd1234\",\"snr\":6.25,\"timestamp\":0,\"to\":4294967295,\"type\":\"position\"}",
+               p);
+}
+
+void test_Encrypted(void)
+{
+    meshtastic_MeshPacket p = makeEncrypted();
+    p.encrypted.size = 2;
+    p.want_ack = true;
+    size_t len = MeshPacketSerializer::JsonSerializeEncrypted(&p, json, sizeof(json));
+    TEST_ASSERT_EQUAL(strlen(json), len);
+
+    // time_ms is millis(), so only check around it
+    const char *head = "{\"bytes\":\"01FF\",\"channel\":0,\"from\":305419896,\"hop_start\":3,\"hops_away\":1,\"id\":77,"
+                       "\"rssi\":-90,\"size\":2,\"snr\":6.25,\"time_ms\":";
+    const char *tail = ",\"timestamp\":0,\"to\":4294967295,\"want_ack\":true}";
+    TEST_ASSERT_EQUAL_INT(0, strncmp(json, head, strlen(head)));
+    TEST_ASSERT_EQUAL_STRING(tail, json + len - strlen(tail));
+}
+
+void test_TooSmallBuffer(void)
+{
+    char small[64];
+    meshtastic_MeshPacket p = makePosition();
+    TEST_ASSERT_EQUAL(0, MeshPacketSerializer::JsonSerialize(&p, small, sizeof(small), false));
+    TEST_ASSERT_EQUAL_STRING("", small);
+
+    // The std::string variants are still there for the odd caller that wants one
+    TEST_ASSERT_TRUE(MeshPacketSerializer::JsonSerialize(&p, json, sizeof(json), false) > sizeof(small));
+    TEST_ASSERT_EQUAL_STRING(json, MeshPacketSerializer::JsonSerialize(&p, false).c_str());
+}
+
+struct BenchCase {
+    const char *name;
+    meshtastic_MeshPacket packet;
+};
+
+/// Serialize p over and over, print the mean time and allocations and return the allocations per call
+static uint32_t bench(bool toString, const meshtastic_MeshPacket &p, uint32_t iterations)
+{
+    bool encrypted = p.which_payload_variant == meshtastic_MeshPacket_encrypted_tag;
+    size_t len = 0;
+
+    uint32_t allocsBefore = numAllocs;
+    long ns = timeBench(iterations, [&](uint32_t) {
+        if (toString)
+            len = encrypted ? MeshPacketSerializer::JsonSerializeEncrypted(&p).length()
+                            : MeshPacketSerializer::JsonSerialize(&p, false).length();
+        else
+            len = encrypted ? MeshPacketSerializer::JsonSerializeEncrypted(&p, json, sizeof(json))
+                            : MeshPacketSerializer::JsonSerialize(&p, json, sizeof(json), false);
+    });
+    uint32_t allocs = (numAllocs - allocsBefore) / iterations;
+    TEST_ASSERT_TRUE(len > 0);
+
+    char extra[32];
+    snprintf(extra, sizeof(extra), "\"allocs_per_op\":%u", allocs);
+    printBenchResult("json_serialize", toString ? "string" : "buffer", encrypted ? -1 : (int)p.decoded.portnum, iterations, ns,
+                     extra);
+    return allocs;
+}
+
+void test_BenchPerPortnum(void)
+{
+    static BenchCase cases[] = {
+        {"text", makeText("Hello mesh, this is a fairly ordinary text message of moderate length")},
+        {"telemetry", makeEnvironment()},
+        {"nodeinfo", makeNodeInfo()},
+        {"position", makePosition()},
+        {"waypoint", makeWaypoint()},
+        {"neighborinfo", makeNeighborInfo()},
+        {"traceroute", makeTraceroute()},
+        {"detection", makeText("Motion detected", meshtastic_PortNum_DETECTION_SENSOR_APP)},
+        {"remote_hardware", makeRemoteHardware()},
+        {"encrypted", makeEncrypted()},
+    };
+
+    for (const BenchCase &c : cases) {
+        uint32_t allocs = bench(false, c.packet, 20000);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocs, c.name);
+        bench(true, c.packet, 20000);
+    }
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB; // for the long names in traceroutes
+    nodeDB->resetNodes();
+    strcpy(owner.id, "!abcd1234");
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_Text);
+    RUN_TEST(test_TextThatIsJson);
+    RUN_TEST(test_Position);
+    RUN_TEST(test_Telemetry);
+    RUN_TEST(test_Traceroute);
+    RUN_TEST(test_UndecodableHasNoPayload);
+    RUN_TEST(test_Encrypted);
+    RUN_TEST(test_TooSmallBuffer);
+    RUN_TEST(test_BenchPerPortnum);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
@@ -0,0 +1,405 @@
+#include "MeshSimulator.h"
+#include "CryptoEngine.h"
+#include "NodeDB.h"
+#include "configuration.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+ErrorCode MeshSimRadio::send(meshtastic_MeshPacket *p)
+{
+    MeshSimFrame f;
+    f.from = p->from;
+    f.to = p->to;
+    f.id = p->id;
+    f.hopLimit = p->hop_limit;
+    f.hopStart = p->hop_start;
+    f.len = p->encrypted.size + sizeof(PacketHeader);
+
+    // Our own packets only wait out the contention window, relays are delayed by SNR and role
+    const MeshSimulator::Node &n = sim.nodes[node];
+    uint32_t roll = sim.nextRandom();
+    uint32_t delay = f.from == n.num ? originDelayMsec(roll) : floodDelayMsec(p->rx_snr, n.isRouter, roll);
+    packetPool.release(p);
+
+    sim.enqueueTx(node, f, delay);
+    return ERRNO_OK;
+}
+
+bool MeshSimRadio::cancelSending(NodeNum from, PacketId id)
+{
+    return sim.cancelTx(node, from, id);
+}
+
+void MeshSimRadio::setModem(uint8_t _sf, float _bw, uint8_t _cr)
+{
+    sf = _sf;
+    bw = _bw;
+    cr = _cr;
+    slotTimeMsec = computeSlotTimeMsec(bw, sf);
+}
+
+uint32_t MeshSimRadio::floodDelayMsec(float snr, bool isRouter, uint32_t roll)
+{
+    uint8_t CWsize = std::min(getCWsize(snr), CWmax);
+    if (isRouter)
+        return (roll % (2 * CWsize)) * slotTimeMsec;
+    // offset the maximum delay for routers: (2 * CWmax * slotTimeMsec)
+    return (2 * CWmax * slotTimeMsec) + (roll % (1 << CWsize)) * slotTimeMsec;
+}
+
+MeshSimRouter::MeshSimRouter()
+{
+    // MeshSimulator calls us directly, and the scheduler only has room for MAX_THREADS threads anyway
+    concurrency::mainController.remove(this);
+}
+
+bool MeshSimRouter::receive(meshtastic_MeshPacket *p)
+{
+    bool accepted = !ignoredSenderReason(p->from, p->via_mqtt) && !shouldFilterReceived(p);
+    if (accepted)
+        sniffReceived(p, NULL);
+    packetPool.release(p);
+    return accepted;
+}
+
+void MeshSimReport::printJson(const char *scenario) const
+{
+    printf("{\"scenario\":\"%s\",\"packets\":%u,\"delivery_ratio\":%.4f,\"deliveries\":%u,\"expected\":%u,"
+           "\"duplicates\":%u,\"collisions\":%u,\"half_duplex_losses\":%u,\"transmissions\":%u,\"relays_canceled\":%u,"
+           "\"airtime_ms\":%llu,\"latency_mean_ms\":%u,\"latency_max_ms\":%u,\"simulated_ms\":%u}\n",
+           scenario, packetsSent, deliveryRatio(), deliveries, expectedDeliveries, duplicates, collisions, halfDuplexLosses,
+           transmissions, relaysCanceled, (unsigned long long)airtimeMsec, latencyMeanMsec(), latencyMaxMsec, simulatedMsec);
+}
+
+MeshSimulator::MeshSimulator(uint64_t seed) : rngState(seed)
+{
+    savedNodeNum = myNodeInfo.my_node_num;
+    savedRole = config.device.role;
+    savedOverrideDutyCycle = config.lora.override_duty_cycle;
+    // The duty cycle check would count this process' real airtime against the region limit, not the simulated one
+    config.lora.override_duty_cycle = true;
+}
+
+MeshSimulator::~MeshSimulator()
+{
+    myNodeInfo.my_node_num = savedNodeNum;
+    config.device.role = savedRole;
+    config.lora.override_duty_cycle = savedOverrideDutyCycle;
+}
+
+/// Point the globals the router code reads, our node number and role, at node before calling into its router
+void MeshSimulator::enter(uint16_t node)
+{
+    myNodeInfo.my_node_num = nodes[node].num;
+    config.device.role =
+        nodes[node].isRouter ? meshtastic_Config_DeviceConfig_Role_ROUTER : meshtastic_Config_DeviceConfig_Role_CLIENT;
+}
+
+uint32_t MeshSimulator::nextRandom()
+{
+    // splitmix64, so runs do not depend on the platform random() implementation or on anybody else seeding it
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+uint16_t MeshSimulator::addNode(const char *name, bool isRouter)
+{
+    uint16_t index = nodes.size();
+    nodes.emplace_back();
+    Node &n = nodes.back();
+    n.name = name;
+    n.num = 0x10000 + index;
+    n.isRouter = isRouter;
+    n.radio.reset(new MeshSimRadio(*this, index));
+    n.radio->setModem(modemSf, modemBw, modemCr);
+
+    // Router's constructor creates the global crypto lock and insists there is only one Router, give this one its own
+    concurrency::Lock *sharedCryptLock = cryptLock;
+    cryptLock = NULL;
+    n.router.reset(new MeshSimRouter());
+    delete cryptLock;
+    cryptLock = sharedCryptLock;
+    n.router->addInterface(n.radio.get());
+    return index;
+}
+
+void MeshSimulator::addLink(uint16_t a, uint16_t b, float snrAB, float snrBA)
+{
+    if (snrBA < -100)
+        snrBA = snrAB;
+    nodes[a].links.push_back({b, snrAB});
+    nodes[b].links.push_back({a, snrBA});
+}
+
+void MeshSimulator::makeGrid(uint16_t w, uint16_t h, float snr)
+{
+    uint16_t base = nodes.size();
+    char name[16];
+    for (uint16_t y = 0; y < h; y++)
+        for (uint16_t x = 0; x < w; x++) {
+            snprintf(name, sizeof(name), "n%u_%u", x, y);
+            addNode(name);
+        }
+    for (uint16_t y = 0; y < h; y++)
+        for (uint16_t x = 0; x < w; x++) {
+            uint16_t i = base + y * w + x;
+            if (x + 1 < w)
+                addLink(i, i + 1, snr);
+            if (y + 1 < h)
+                addLink(i, i + w, snr);
+        }
+}
+
+void MeshSimulator::setModem(uint8_t sf, float bw, uint8_t cr)
+{
+    modemSf = sf;
+    modemBw = bw;
+    modemCr = cr;
+    for (auto &n : nodes)
+        n.radio->setModem(sf, bw, cr);
+}
+
+int MeshSimulator::findNode(const char *name) const
+{
+    for (size_t i = 0; i < nodes.size(); i++)
+        if (nodes[i].name == name)
+            return i;
+    return -1;
+}
+
+bool MeshSimulator::loadScenario(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        LOG_ERROR("Can't open sim scenario %s", path);
+        return false;
+    }
+
+    char line[256], a[32], b[32];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        unsigned sf, cr, at, len, hopLimit = 3;
+        float bw, snrAB, snrBA = -1000;
+        char kind[16] = "client";
+        if (sscanf(line, " modem %u %f %u", &sf, &bw, &cr) == 3) {
+            setModem(sf, bw, cr);
+        } else if (sscanf(line, " node %31s %15s", a, kind) >= 1) {
+            if (findNode(a) >= 0 || (strcmp(kind, "client") && strcmp(kind, "router")))
+                ok = false;
+            else
+                addNode(a, strcmp(kind, "router") == 0);
+        } else if (sscanf(line, " link %31s %31s %f %f", a, b, &snrAB, &snrBA) >= 3) {
+            int ia = findNode(a), ib = findNode(b);
+            if (ia < 0 || ib < 0 || ia == ib)
+                ok = false;
+            else
+                addLink(ia, ib, snrAB, snrBA);
+        } else if (sscanf(line, " send %u %31s %31s %u %u", &at, a, b, &len, &hopLimit) >= 4) {
+            int ia = findNode(a), ib = strcmp(b, "*") ? findNode(b) : -1;
+            if (ia < 0 || (ib < 0 && strcmp(b, "*")))
+                ok = false;
+            else
+                send(at, ia, ib < 0 ? NODENUM_BROADCAST : nodes[ib].num, len, hopLimit);
+        } else if (strspn(line, " \t\r\n") != strlen(line)) {
+            ok = false;
+        }
+    }
+    fclose(f);
+
+    if (!ok)
+        LOG_ERROR("Bad sim scenario line %s:%d", path, lineNo);
+    return ok;
+}
+
+void MeshSimulator::send(uint32_t atMsec, uint16_t from, NodeNum to, uint16_t len, uint8_t hopLimit)
+{
+    MeshSimFrame f = {nodes[from].num, to, nextPacketId++, hopLimit, hopLimit, len};
+    originated.push_back(f);
+    schedule(atMsec, EV_ORIGINATE, from, originated.size() - 1);
+}
+
+void MeshSimulator::schedule(uint32_t atMsec, EventType type, uint16_t node, uint32_t ref)
+{
+    events.push({atMsec, nextSeq++, type, node, ref});
+}
+
+const MeshSimReport &MeshSimulator::run(uint32_t untilMsec)
+{
+    while (!events.empty() && events.top().atMsec <= untilMsec) {
+        Event e = events.top();
+        events.pop();
+        nowMsec = e.atMsec;
+        switch (e.type) {
+        case EV_ORIGINATE:
+            originate(e.node, originated[e.ref]);
+            break;
+        case EV_TX_START:
+            onTxStart(e.node, e.ref);
+            break;
+        case EV_TX_END:
+            onTxEnd(e.node);
+            break;
+        case EV_RX_END:
+            onRxEnd(e.node, e.ref);
+            break;
+        }
+    }
+    report.simulatedMsec = nowMsec;
+    return report;
+}
+
+void MeshSimulator::enqueueTx(uint16_t node, const MeshSimFrame &f, uint32_t delayMsec)
+{
+    uint32_t seq = nextSeq++;
+    nodes[node].txQueue.push_back({seq, f});
+    schedule(nowMsec + delayMsec, EV_TX_START, node, seq);
+}
+
+bool MeshSimulator::cancelTx(uint16_t node, NodeNum from, PacketId id)
+{
+    auto &q = nodes[node].txQueue;
+    auto it = std::find_if(q.begin(), q.end(), [=](const PendingTx &t) { return t.frame.from == from && t.frame.id == id; });
+    if (it == q.end())
+        return false;
+    q.erase(it);
+    report.relaysCanceled++;
+    return true;
+}
+
+void MeshSimulator::originate(uint16_t node, const MeshSimFrame &f)
+{
+    sentAt[packetKey(f.from, f.id)] = nowMsec;
+    report.packetsSent++;
+    report.expectedDeliveries += f.to == NODENUM_BROADCAST ? nodes.size() - 1 : 1;
+
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    p->from = f.from;
+    p->to = f.to;
+    p->id = f.id;
+    p->hop_limit = f.hopLimit;
+    p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p->encrypted.size = f.len - sizeof(PacketHeader);
+
+    // FloodingRouter::send() remembers it, so we ignore our own packet when it comes back, then hands it to our radio
+    enter(node);
+    nodes[node].router->send(p);
+}
+
+void MeshSimulator::onTxStart(uint16_t node, uint32_t seq)
+{
+    Node &n = nodes[node];
+    auto it = std::find_if(n.txQueue.begin(), n.txQueue.end(), [seq](const PendingTx &t) { return t.seq == seq; });
+    if (it == n.txQueue.end())
+        return; // cancelled while waiting
+
+    if (n.transmitting) {
+        schedule(n.txEndMsec, EV_TX_START, node, seq);
+        return;
+    }
+    if (!n.receiving.empty()) {
+        // Channel activity detected, back off like SimRadio/RadioLibInterface do when isChannelActive()
+        schedule(nowMsec + std::max(n.radio->originDelayMsec(nextRandom()), (uint32_t)1), EV_TX_START, node, seq);
+        return;
+    }
+
+    MeshSimFrame f = it->frame;
+    n.txQueue.erase(it);
+
+    uint32_t airtime = n.radio->getPacketTime(f.len);
+    n.transmitting = true;
+    n.txEndMsec = nowMsec + airtime;
+    report.transmissions++;
+    report.airtimeMsec += airtime;
+    schedule(n.txEndMsec, EV_TX_END, node, 0);
+
+    for (auto &l : n.links) {
+        Node &r = nodes[l.to];
+        if (l.snr < r.radio->getSensitivitySnr())
+            continue;
+        if (r.transmitting) {
+            report.halfDuplexLosses++;
+            continue;
+        }
+
+        Reception rc = {nextSeq++, f, l.snr, false};
+        for (auto &other : r.receiving) {
+            if (rc.snr >= other.snr + CAPTURE_THRESHOLD_DB) {
+                other.corrupted = true;
+            } else if (other.snr >= rc.snr + CAPTURE_THRESHOLD_DB) {
+                rc.corrupted = true;
+            } else {
+                other.corrupted = true;
+                rc.corrupted = true;
+            }
+        }
+        r.receiving.push_back(rc);
+        schedule(n.txEndMsec, EV_RX_END, l.to, rc.seq);
+    }
+}
+
+void MeshSimulator::onTxEnd(uint16_t node)
+{
+    nodes[node].transmitting = false;
+}
+
+void MeshSimulator::onRxEnd(uint16_t node, uint32_t seq)
+{
+    Node &n = nodes[node];
+    auto it = std::find_if(n.receiving.begin(), n.receiving.end(), [seq](const Reception &r) { return r.seq == seq; });
+    if (it == n.receiving.end())
+        return;
+
+    Reception rc = *it;
+    n.receiving.erase(it);
+    if (rc.corrupted)
+        report.collisions++;
+    else
+        deliver(node, rc.frame, rc.snr);
+}
+
+void MeshSimulator::deliver(uint16_t node, const MeshSimFrame &f, float snr)
+{
+    Node &n = nodes[node];
+    enter(node);
+
+    // What RadioLibInterface does with a frame: offer the router the header first, decode the rest only if that didn't drop it
+    PacketHeader h = {};
+    h.to = f.to;
+    h.from = f.from;
+    h.id = f.id;
+    h.flags = (f.hopLimit & PACKET_FLAGS_HOP_LIMIT_MASK) | (f.hopStart << PACKET_FLAGS_HOP_START_SHIFT);
+    bool isNew = !n.router->filterDuplicateHeader(h, n.radio->getPacketTime(f.len));
+    if (isNew) {
+        meshtastic_MeshPacket *p = packetPool.allocZeroed();
+        p->from = f.from;
+        p->to = f.to;
+        p->id = f.id;
+        p->hop_limit = f.hopLimit;
+        p->hop_start = f.hopStart;
+        p->rx_snr = snr;
+        p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+        p->encrypted.size = f.len - sizeof(PacketHeader);
+        isNew = n.router->receive(p);
+    }
+    if (!isNew) {
+        report.duplicates++;
+        return;
+    }
+
+    if (f.to == NODENUM_BROADCAST || f.to == n.num) {
+        uint32_t latency = nowMsec - sentAt[packetKey(f.from, f.id)];
+        report.deliveries++;
+        report.latencySumMsec += latency;
+        report.latencyMaxMsec = std::max(report.latencyMaxMsec, latency);
+    }
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "FloodingRouter.h"
+#include "MeshTypes.h"
+#include "RadioInterface.h"
+
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MeshSimulator;
+
+/**
+ * The RadioInterface each simulated node's router sends through. It never touches hardware, it puts frames on the simulated
+ * air, with airtime and contention delays from the very same code (getPacketTime(), getCWsize(), slotTimeMsec) the real
+ * radios use.
+ */
+class MeshSimRadio : public RadioInterface
+{
+    MeshSimulator &sim;
+    uint16_t node;
+
+  public:
+    MeshSimRadio(MeshSimulator &_sim, uint16_t _node) : sim(_sim), node(_node) {}
+
+    /// Queue an already encrypted packet for transmission from this node, at the current virtual time
+    virtual ErrorCode send(meshtastic_MeshPacket *p) override;
+
+    /// Drop a relay that is still waiting for its turn, like RadioLibInterface does when the router cancels it
+    virtual bool cancelSending(NodeNum from, PacketId id) override;
+
+    void setModem(uint8_t _sf, float _bw, uint8_t _cr);
+
+    /// Lowest SNR the current spreading factor can still demodulate
+    float getSensitivitySnr() const { return -2.5f * (sf - 4); }
+
+    /// Same formula as getTxDelayMsec() at an idle channel, with the random draw supplied by the simulator
+    uint32_t originDelayMsec(uint32_t roll) { return (roll % (1 << CWmin)) * slotTimeMsec; }
+
+    /// Same formula as getTxDelayMsecWeighted(), with the role and random draw supplied by the simulator
+    uint32_t floodDelayMsec(float snr, bool isRouter, uint32_t roll);
+};
+
+/**
+ * A simulated node's real FloodingRouter, and so its own PacketHistory. MeshSimulator feeds it straight from the simulated
+ * air instead of through the fromRadio queue, and never lets the scheduler run it.
+ */
+class MeshSimRouter : public FloodingRouter
+{
+  public:
+    MeshSimRouter();
+
+    /**
+     * What perhapsHandleReceived() and the RoutingModule do with a packet we have no key for: drop ignored senders and
+     * duplicates, then sniff it, which is where FloodingRouter decides to relay. Frees p.
+     * @return false if it was dropped
+     */
+    bool receive(meshtastic_MeshPacket *p);
+};
+
+/** One over-the-air frame, only the header fields flooding looks at are modelled */
+struct MeshSimFrame {
+    NodeNum from;
+    NodeNum to;
+    PacketId id;
+    uint8_t hopLimit;
+    uint8_t hopStart;
+    uint16_t len; // PacketHeader + encrypted payload
+};
+
+/** Aggregated results of one scenario run */
+struct MeshSimReport {
+    uint32_t packetsSent = 0;        // packets originated by the scenario
+    uint32_t expectedDeliveries = 0; // node/packet pairs that should have received something
+    uint32_t deliveries = 0;         // node/packet pairs that did receive it
+    uint32_t duplicates = 0;         // receptions of a packet the node had already seen
+    uint32_t collisions = 0;         // receptions lost to overlapping transmissions
+    uint32_t halfDuplexLosses = 0;   // receptions lost because the receiver was transmitting
+    uint32_t transmissions = 0;      // frames put on air, originals and relays
+    uint32_t relaysCanceled = 0;     // pending relays dropped because somebody else relayed first
+    uint64_t airtimeMsec = 0;        // summed over all transmitters
+    uint64_t latencySumMsec = 0;
+    uint32_t latencyMaxMsec = 0;
+    uint32_t simulatedMsec = 0;
+
+    float deliveryRatio() const { return expectedDeliveries ? (float)deliveries / expectedDeliveries : 1.0f; }
+    uint32_t latencyMeanMsec() const { return deliveries ? latencySumMsec / deliveries : 0; }
+
+    /// Print a single JSON line, so scenario results can be collected by scripts
+    void printJson(const char *scenario) const;
+};
+
+/**
+ * Deterministic discrete-event model of a flooding mesh, running on a virtual clock so hundreds of nodes simulate much
+ * faster than real time in a single process.
+ *
+ * Each node is a real FloodingRouter (MeshSimRouter) sending through a MeshSimRadio, so duplicate filtering, relay
+ * cancelling and rebroadcasting are the firmware's own. Packets stay encrypted, as they do on a relay without the channel
+ * key. The router code reads our node number from nodeDB and the role from config, so those globals are pointed at a node
+ * before every call into its router; nodeDB must exist. They are restored when the simulator is destroyed.
+ *
+ * On air we model airtime, half duplex radios, channel activity detection, SNR sensitivity and collisions with a simple
+ * capture effect. All randomness comes from a seeded generator, the same seed gives the same run.
+ */
+class MeshSimulator
+{
+  public:
+    /// A reception survives an overlapping one if it is this much stronger
+    static constexpr float CAPTURE_THRESHOLD_DB = 6.0f;
+
+    explicit MeshSimulator(uint64_t seed = 1);
+    ~MeshSimulator();
+
+    /// Returns the new node index, role router means relays are never cancelled and use the short contention window
+    uint16_t addNode(const char *name, bool isRouter = false);
+
+    /// Add a link between two nodes, snrBA < -100 means symmetric
+    void addLink(uint16_t a, uint16_t b, float snrAB, float snrBA = -1000);
+
+    /// Build a w x h grid where horizontal and vertical neighbours hear each other at the given SNR
+    void makeGrid(uint16_t w, uint16_t h, float snr);
+
+    /// Apply a modem preset to every radio, nodes added later pick it up too
+    void setModem(uint8_t sf, float bw, uint8_t cr);
+
+    /**
+     * Load a topology/scenario file. Blank lines and # comments are ignored, otherwise one directive per line:
+     *   modem <sf> <bw_khz> <cr>
+     *   node <name> [client|router]
+     *   link <a> <b> <snr> [<snr b to a>]
+     *   send <at_msec> <from> <to|*> <len> [hop_limit]
+     * Returns false and logs the offending line on a parse error.
+     */
+    bool loadScenario(const char *path);
+
+    /// Originate a packet of len bytes (header included) at the given virtual time, to == NODENUM_BROADCAST floods
+    void send(uint32_t atMsec, uint16_t from, NodeNum to, uint16_t len, uint8_t hopLimit = 3);
+
+    /// Run until the event queue is empty or the virtual clock passes untilMsec
+    const MeshSimReport &run(uint32_t untilMsec = UINT32_MAX);
+
+    uint32_t now() const { return nowMsec; }
+    size_t numNodes() const { return nodes.size(); }
+    int findNode(const char *name) const;
+    const MeshSimReport &getReport() const { return report; }
+
+  private:
+    friend class MeshSimRadio;
+
+    struct Link {
+        uint16_t to;
+        float snr;
+    };
+
+    struct PendingTx {
+        uint32_t seq;
+        MeshSimFrame frame;
+    };
+
+    struct Reception {
+        uint32_t seq;
+        MeshSimFrame frame;
+        float snr;
+        bool corrupted;
+    };
+
+    struct Node {
+        std::string name;
+        NodeNum num;
+        bool isRouter;
+        std::unique_ptr<MeshSimRadio> radio;
+        std::unique_ptr<MeshSimRouter> router;
+        std::vector<Link> links;
+        std::vector<PendingTx> txQueue;
+        std::vector<Reception> receiving;
+        uint32_t txEndMsec = 0;
+        bool transmitting = false;
+    };
+
+    enum EventType { EV_ORIGINATE, EV_TX_START, EV_TX_END, EV_RX_END };
+
+    struct Event {
+        uint32_t atMsec;
+        uint32_t seq; // tie breaker so equal times always pop in insertion order
+        EventType type;
+        uint16_t node;
+        uint32_t ref; // PendingTx/Reception seq, or index into originated for EV_ORIGINATE
+    };
+
+    struct EventLater {
+        bool operator()(const Event &a, const Event &b) const
+        {
+            return a.atMsec != b.atMsec ? a.atMsec > b.atMsec : a.seq > b.seq;
+        }
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, uint32_t> sentAt; // packet key -> origination time
+    std::vector<MeshSimFrame> originated; // referenced by EV_ORIGINATE events
+    std::priority_queue<Event, std::vector<Event>, EventLater> events;
+    MeshSimReport report;
+    uint64_t rngState;
+    uint8_t modemSf = 11, modemCr = 5; // LongFast
+    float modemBw = 250;
+    uint32_t nowMsec = 0;
+    uint32_t nextSeq = 1;
+    PacketId nextPacketId = 1;
+
+    // The globals enter() changes, as they were before we started
+    NodeNum savedNodeNum;
+    meshtastic_Config_DeviceConfig_Role savedRole;
+    bool savedOverrideDutyCycle;
+
+    static uint64_t packetKey(NodeNum from, PacketId id) { return ((uint64_t)from << 32) | id; }
+
+    uint32_t nextRandom();
+    void schedule(uint32_t atMsec, EventType type, uint16_t node, uint32_t ref);
+    void enter(uint16_t node);
+    void enqueueTx(uint16_t node, const MeshSimFrame &f, uint32_t delayMsec);
+    bool cancelTx(uint16_t node, NodeNum from, PacketId id);
+    void originate(uint16_t node, const MeshSimFrame &f);
+
+    void onTxStart(uint16_t node, uint32_t seq);
+    void onTxEnd(uint16_t node);
+    void onRxEnd(uint16_t node, uint32_t seq);
+    void deliver(uint16_t node, const MeshSimFrame &f, float snr);
+};
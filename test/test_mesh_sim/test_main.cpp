@@ -0,0 +1,182 @@
+#include "FSCommon.h"
+#include "MeshSimulator.h"
+#include "NodeDB.h"
+
+#include "TestUtil.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+static void makeLine(MeshSimulator &sim, uint16_t n, float snr)
+{
+    char name[8];
+    for (uint16_t i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "l%u", i);
+        sim.addNode(name);
+    }
+    for (uint16_t i = 0; i + 1 < n; i++)
+        sim.addLink(i, i + 1, snr);
+}
+
+void test_LineFloodReachesHopLimit(void)
+{
+    MeshSimulator sim;
+    makeLine(sim, 6, 5);
+    sim.send(0, 0, NODENUM_BROADCAST, 40, 3);
+    const MeshSimReport &r = sim.run();
+    r.printJson("line6_hop3");
+
+    // The original plus three relays, so the sixth node (four hops out) never hears it
+    TEST_ASSERT_EQUAL_UINT32(4, r.transmissions);
+    TEST_ASSERT_EQUAL_UINT32(5, r.expectedDeliveries);
+    TEST_ASSERT_EQUAL_UINT32(4, r.deliveries);
+    TEST_ASSERT_EQUAL_UINT32(0, r.collisions);
+    // Every relay is heard again by the node it came from
+    TEST_ASSERT_EQUAL_UINT32(3, r.duplicates);
+}
+
+void test_BelowSensitivityNotHeard(void)
+{
+    MeshSimulator sim;
+    makeLine(sim, 2, -25); // below the SF11 floor of -17.5dB
+    sim.send(0, 0, NODENUM_BROADCAST, 40);
+    const MeshSimReport &r = sim.run();
+
+    TEST_ASSERT_EQUAL_UINT32(1, r.transmissions);
+    TEST_ASSERT_EQUAL_UINT32(0, r.deliveries);
+}
+
+void test_HiddenNodesCollide(void)
+{
+    MeshSimulator sim;
+    uint16_t a = sim.addNode("a"), c = sim.addNode("c"), b = sim.addNode("b");
+    sim.addLink(a, c, 0);
+    sim.addLink(b, c, 1);
+    sim.send(0, a, NODENUM_BROADCAST, 40, 0);
+    sim.send(0, b, NODENUM_BROADCAST, 40, 0);
+    const MeshSimReport &r = sim.run();
+
+    TEST_ASSERT_EQUAL_UINT32(2, r.collisions);
+    TEST_ASSERT_EQUAL_UINT32(0, r.deliveries);
+}
+
+void test_StrongerSignalCaptures(void)
+{
+    MeshSimulator sim;
+    uint16_t a = sim.addNode("a"), c = sim.addNode("c"), b = sim.addNode("b");
+    sim.addLink(a, c, 10);
+    sim.addLink(b, c, 0);
+    sim.send(0, a, NODENUM_BROADCAST, 40, 0);
+    sim.send(0, b, NODENUM_BROADCAST, 40, 0);
+    const MeshSimReport &r = sim.run();
+
+    TEST_ASSERT_EQUAL_UINT32(1, r.collisions);
+    TEST_ASSERT_EQUAL_UINT32(1, r.deliveries);
+}
+
+void test_UnicastStopsAtDestination(void)
+{
+    MeshSimulator sim;
+    makeLine(sim, 3, 5);
+    sim.send(0, 0, 0x10001, 40, 3);
+    const MeshSimReport &r = sim.run();
+
+    TEST_ASSERT_EQUAL_UINT32(1, r.deliveries);
+    TEST_ASSERT_EQUAL_UINT32(1, r.transmissions);
+}
+
+static MeshSimReport runGrid(uint64_t seed)
+{
+    MeshSimulator sim(seed);
+    sim.makeGrid(10, 10, 3);
+    for (uint32_t i = 0; i < 10; i++)
+        sim.send(i * 20000, (i * 37) % sim.numNodes(), NODENUM_BROADCAST, 60, 7);
+    return sim.run();
+}
+
+void test_SameSeedSameRun(void)
+{
+    MeshSimReport a = runGrid(42), b = runGrid(42);
+    TEST_ASSERT_EQUAL_UINT32(a.transmissions, b.transmissions);
+    TEST_ASSERT_EQUAL_UINT32(a.deliveries, b.deliveries);
+    TEST_ASSERT_EQUAL_UINT32(a.duplicates, b.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(a.collisions, b.collisions);
+    TEST_ASSERT_EQUAL_UINT64(a.airtimeMsec, b.airtimeMsec);
+    TEST_ASSERT_EQUAL_UINT64(a.latencySumMsec, b.latencySumMsec);
+}
+
+void test_Grid100FasterThanRealTime(void)
+{
+    auto start = std::chrono::steady_clock::now();
+    MeshSimReport r = runGrid(1);
+    auto wallMsec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    r.printJson("grid10x10_hop7");
+
+    TEST_ASSERT_EQUAL_UINT32(10, r.packetsSent);
+    TEST_ASSERT_EQUAL_UINT32(990, r.expectedDeliveries);
+    TEST_ASSERT_TRUE(r.deliveryRatio() > 0.5f);
+    TEST_ASSERT_TRUE(r.duplicates > 0);
+    TEST_ASSERT_TRUE(wallMsec < r.simulatedMsec);
+}
+
+void test_LoadScenario(void)
+{
+    const char *path = "/tmp/meshsim_test_scenario.txt";
+    FILE *f = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs("# triangle with a weak back link\n"
+          "modem 9 125 5\n"
+          "node a\n"
+          "node b router\n"
+          "node c\n"
+          "link a b 5\n"
+          "link b c 2 -3\n"
+          "send 0 a *\t40\n"
+          "send 5000 c a 40 2 # unicast\n",
+          f);
+    fclose(f);
+
+    MeshSimulator sim;
+    TEST_ASSERT_TRUE(sim.loadScenario(path));
+    TEST_ASSERT_EQUAL(3, sim.numNodes());
+    TEST_ASSERT_EQUAL(1, sim.findNode("b"));
+    const MeshSimReport &r = sim.run();
+    r.printJson("file_triangle");
+
+    TEST_ASSERT_EQUAL_UINT32(2, r.packetsSent);
+    TEST_ASSERT_EQUAL_UINT32(3, r.expectedDeliveries);
+    TEST_ASSERT_EQUAL_UINT32(3, r.deliveries);
+
+    f = fopen(path, "w");
+    fputs("node a\nlink a nowhere 5\n", f);
+    fclose(f);
+    MeshSimulator bad;
+    TEST_ASSERT_FALSE(bad.loadScenario(path));
+    remove(path);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB; // the routers look up our node number and ignored nodes there
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_LineFloodReachesHopLimit);
+    RUN_TEST(test_BelowSensitivityNotHeard);
+    RUN_TEST(test_HiddenNodesCollide);
+    RUN_TEST(test_StrongerSignalCaptures);
+    RUN_TEST(test_UnicastStopsAtDestination);
+    RUN_TEST(test_SameSeedSameRun);
+    RUN_TEST(test_Grid100FasterThanRealTime);
+    RUN_TEST(test_LoadScenario);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
@@ -0,0 +1,97 @@
+#include "FSCommon.h"
+#include "NodeDB.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+static const NodeNum REMOTE_NODE = 0x12345678;
+static const NodeNum NEW_NODE = 0x23456789;
+
+/// Fill the DB, node REMOTE_NODE + i heard at time 1000 + i, so REMOTE_NODE + 1 is the oldest
+static void fillNodeDB()
+{
+    nodeDB->resetNodes();
+    for (size_t i = 1; i < MAX_NUM_NODES; i++)
+        hearTestNode(REMOTE_NODE + i, 1000 + i);
+    TEST_ASSERT_EQUAL(MAX_NUM_NODES, nodeDB->getNumMeshNodes());
+}
+
+void setUp(void)
+{
+    fillNodeDB();
+}
+
+void tearDown(void)
+{
+    nodeDB->resetNodes();
+}
+
+void test_EvictsLeastRecentlyHeard(void)
+{
+    hearTestNode(REMOTE_NODE + 1, 5000); // now the newest
+    TEST_ASSERT_NOT_NULL(hearTestNode(NEW_NODE, 5001));
+    TEST_ASSERT_NOT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 1));
+    TEST_ASSERT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 2));
+    TEST_ASSERT_EQUAL(MAX_NUM_NODES, nodeDB->getNumMeshNodes());
+}
+
+void test_FavoriteIsNotEvicted(void)
+{
+    nodeDB->getMeshNode(REMOTE_NODE + 1)->is_favorite = true;
+    nodeDB->updateEvictionClass(REMOTE_NODE + 1);
+
+    TEST_ASSERT_NOT_NULL(hearTestNode(NEW_NODE, 5000));
+    TEST_ASSERT_NOT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 1));
+    TEST_ASSERT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 2));
+}
+
+void test_UnfavoritedIsEvictableAgainByAge(void)
+{
+    nodeDB->getMeshNode(REMOTE_NODE + 1)->is_favorite = true;
+    nodeDB->updateEvictionClass(REMOTE_NODE + 1);
+    TEST_ASSERT_NOT_NULL(hearTestNode(NEW_NODE, 5000)); // takes REMOTE_NODE + 2's slot
+
+    // Unfavorited without being heard again, it is still the oldest node so it goes next
+    nodeDB->getMeshNode(REMOTE_NODE + 1)->is_favorite = false;
+    nodeDB->updateEvictionClass(REMOTE_NODE + 1);
+    TEST_ASSERT_NOT_NULL(hearTestNode(NEW_NODE + 1, 5001));
+    TEST_ASSERT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 1));
+    TEST_ASSERT_NOT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 3));
+}
+
+void test_UnignoredKeepsItsAge(void)
+{
+    // Ignore a node from the middle, it should come back at the same place in the order rather than at either end
+    nodeDB->getMeshNode(REMOTE_NODE + 3)->is_ignored = true;
+    nodeDB->updateEvictionClass(REMOTE_NODE + 3);
+    nodeDB->getMeshNode(REMOTE_NODE + 3)->is_ignored = false;
+    nodeDB->updateEvictionClass(REMOTE_NODE + 3);
+
+    for (NodeNum i = 0; i < 3; i++)
+        TEST_ASSERT_NOT_NULL(hearTestNode(NEW_NODE + i, 5000 + i));
+    TEST_ASSERT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 1));
+    TEST_ASSERT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 2));
+    TEST_ASSERT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 3));
+    TEST_ASSERT_NOT_NULL(nodeDB->getMeshNode(REMOTE_NODE + 4));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB;
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_EvictsLeastRecentlyHeard);
+    RUN_TEST(test_FavoriteIsNotEvicted);
+    RUN_TEST(test_UnfavoritedIsEvictableAgainByAge);
+    RUN_TEST(test_UnignoredKeepsItsAge);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
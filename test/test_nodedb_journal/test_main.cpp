@@ -0,0 +1,152 @@
+#include "FSCommon.h"
+#include "NodeDBJournal.h"
+
+#include "TestUtil.h"
+#include <string.h>
+#include <unity.h>
+
+#if NODEDB_JOURNAL
+
+static meshtastic_DeviceState onDisk, inRam;
+static NodeDBJournal *journal;
+
+static meshtastic_NodeInfoLite makeNode(NodeNum num, const char *name)
+{
+    meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+    node.num = num;
+    node.has_user = true;
+    strncpy(node.user.long_name, name, sizeof(node.user.long_name) - 1);
+    node.last_heard = num * 10;
+    return node;
+}
+
+static const meshtastic_NodeInfoLite *findNode(const meshtastic_DeviceState &state, NodeNum num)
+{
+    for (const meshtastic_NodeInfoLite &node : state.node_db_lite)
+        if (node.num == num)
+            return &node;
+    return NULL;
+}
+
+/// What loadFromDisk() sees on the next boot: the snapshot with the journal replayed over it
+static bool reboot(meshtastic_DeviceState &loaded)
+{
+    loaded = onDisk;
+    NodeDBJournal fresh;
+    return fresh.replay(loaded);
+}
+
+void setUp(void)
+{
+    FSCom.mkdir("/prefs");
+    journal = new NodeDBJournal();
+    journal->clear();
+
+    onDisk = meshtastic_DeviceState();
+    onDisk.version = 24;
+    onDisk.has_owner = true;
+    strcpy(onDisk.owner.long_name, "owner");
+    for (NodeNum num = 1; num <= 20; num++)
+        onDisk.node_db_lite.push_back(makeNode(num, "node"));
+    inRam = onDisk;
+    journal->rebase(inRam, inRam.node_db_lite.size());
+}
+
+void tearDown(void)
+{
+    journal->clear();
+    delete journal;
+}
+
+void test_NothingChangedWritesNothing(void)
+{
+    TEST_ASSERT_TRUE(journal->append(inRam, inRam.node_db_lite.size()));
+    TEST_ASSERT_EQUAL(0, journal->getStats().journalBytes);
+    TEST_ASSERT_EQUAL(0, journal->getStats().appends);
+}
+
+void test_ReplayRestoresChanges(void)
+{
+    inRam.node_db_lite[1] = makeNode(2, "renamed");
+    inRam.node_db_lite.erase(inRam.node_db_lite.begin() + 2); // node 3
+    inRam.node_db_lite.push_back(makeNode(100, "new"));
+    strcpy(inRam.owner.long_name, "new owner");
+    TEST_ASSERT_TRUE(journal->append(inRam, inRam.node_db_lite.size()));
+    TEST_ASSERT_GREATER_THAN(0, journal->getStats().journalBytes);
+    TEST_ASSERT_EQUAL(1, journal->getStats().appends);
+
+    static meshtastic_DeviceState loaded;
+    TEST_ASSERT_TRUE(reboot(loaded));
+    TEST_ASSERT_EQUAL_STRING("new owner", loaded.owner.long_name);
+    TEST_ASSERT_NOT_NULL(findNode(loaded, 1));
+    TEST_ASSERT_EQUAL_STRING("renamed", findNode(loaded, 2)->user.long_name);
+    TEST_ASSERT_NULL(findNode(loaded, 3));
+    TEST_ASSERT_EQUAL_STRING("new", findNode(loaded, 100)->user.long_name);
+}
+
+void test_TornRecordStopsReplay(void)
+{
+    inRam.node_db_lite[0] = makeNode(1, "first");
+    TEST_ASSERT_TRUE(journal->append(inRam, inRam.node_db_lite.size()));
+
+    // A power cut half way through the next record
+    auto f = FSCom.open("/prefs/db.jrnl", "a");
+    const uint8_t partial[] = {0xa6, 1, 40, 0, 1, 2};
+    f.write(partial, sizeof(partial));
+    f.close();
+
+    static meshtastic_DeviceState loaded;
+    TEST_ASSERT_FALSE(reboot(loaded));
+    TEST_ASSERT_EQUAL_STRING("first", findNode(loaded, 1)->user.long_name);
+}
+
+void test_GrowingJournalAsksForSnapshot(void)
+{
+    int appends = 0;
+    while (journal->append(inRam, inRam.node_db_lite.size())) {
+        TEST_ASSERT_LESS_OR_EQUAL(NODEDB_JOURNAL_MAX_BYTES, journal->getStats().journalBytes);
+        inRam.node_db_lite[appends % 20].last_heard++;
+        appends++;
+        TEST_ASSERT_LESS_THAN(10000, appends);
+    }
+    TEST_ASSERT_GREATER_THAN(1, appends);
+
+    // What NodeDB does next
+    journal->clear();
+    onDisk = inRam;
+    journal->rebase(inRam, inRam.node_db_lite.size());
+    TEST_ASSERT_EQUAL(0, journal->getStats().journalBytes);
+    TEST_ASSERT_FALSE(FSCom.exists("/prefs/db.jrnl"));
+    TEST_ASSERT_TRUE(journal->append(inRam, inRam.node_db_lite.size()));
+}
+
+void test_InvalidatedJournalAsksForSnapshot(void)
+{
+    journal->invalidate();
+    TEST_ASSERT_FALSE(journal->append(inRam, inRam.node_db_lite.size()));
+}
+
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#if NODEDB_JOURNAL
+    RUN_TEST(test_NothingChangedWritesNothing);
+    RUN_TEST(test_ReplayRestoresChanges);
+    RUN_TEST(test_TornRecordStopsReplay);
+    RUN_TEST(test_GrowingJournalAsksForSnapshot);
+    RUN_TEST(test_InvalidatedJournalAsksForSnapshot);
+#endif
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
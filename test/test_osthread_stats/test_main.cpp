@@ -0,0 +1,116 @@
+#include "concurrency/OSThread.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+/// Not added to any controller, the tests call run() themselves like the scheduler would
+class BusyThread : public concurrency::OSThread
+{
+  public:
+    uint32_t busyMs = 5;
+
+    explicit BusyThread(const char *name) : OSThread(name, 1000, NULL) {}
+
+    void runFromScheduler() { ((Thread *)this)->run(); }
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        delay(busyMs);
+        return RUN_SAME;
+    }
+};
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_CountsRunsAndTime(void)
+{
+    BusyThread t("busy");
+    TEST_ASSERT_EQUAL(0, t.getStats().runs);
+
+    t.runFromScheduler();
+    t.busyMs = 1;
+    t.runFromScheduler();
+
+    const concurrency::OSThreadStats &stats = t.getStats();
+    TEST_ASSERT_EQUAL(2, stats.runs);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, stats.maxUs);
+    TEST_ASSERT_GREATER_OR_EQUAL(6000, stats.totalUs);
+    TEST_ASSERT_LESS_THAN(1000000, stats.totalUs);
+}
+
+void test_OnTimeRunIsNotLate(void)
+{
+    BusyThread t("ontime");
+    t.busyMs = 0;
+    t.runFromScheduler(); // a second early
+
+    TEST_ASSERT_EQUAL(0, t.getStats().maxLateMs);
+    TEST_ASSERT_EQUAL(0, t.getStats().totalLateMs);
+}
+
+void test_LatenessCountsFromWhenWeWereDue(void)
+{
+    BusyThread t("late");
+    t.busyMs = 0;
+    delay(50);
+    t.setInterval(0); // wanted to run now, after sitting idle for 50ms
+    delay(20);
+    t.runFromScheduler();
+
+    const concurrency::OSThreadStats &stats = t.getStats();
+    TEST_ASSERT_GREATER_OR_EQUAL(20, stats.maxLateMs);
+    TEST_ASSERT_LESS_THAN(50, stats.maxLateMs);
+    TEST_ASSERT_EQUAL(stats.maxLateMs, stats.totalLateMs);
+}
+
+void test_RegistryTracksLiveThreads(void)
+{
+    BusyThread *a = new BusyThread("a");
+    BusyThread *b = new BusyThread("b");
+
+    bool seenA = false, seenB = false;
+    for (concurrency::OSThread *t = concurrency::OSThread::getFirst(); t; t = t->getNext()) {
+        seenA |= t == a;
+        seenB |= t == b;
+    }
+    TEST_ASSERT_TRUE(seenA);
+    TEST_ASSERT_TRUE(seenB);
+
+    delete a;
+    seenA = seenB = false;
+    for (concurrency::OSThread *t = concurrency::OSThread::getFirst(); t; t = t->getNext()) {
+        seenA |= t == a;
+        seenB |= t == b;
+    }
+    TEST_ASSERT_FALSE(seenA);
+    TEST_ASSERT_TRUE(seenB);
+    delete b;
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_CountsRunsAndTime);
+    RUN_TEST(test_OnTimeRunIsNotLate);
+    RUN_TEST(test_LatenessCountsFromWhenWeWereDue);
+    RUN_TEST(test_RegistryTracksLiveThreads);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
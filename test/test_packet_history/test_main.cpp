@@ -0,0 +1,94 @@
+#include "PacketHistory.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+static const NodeNum REMOTE_NODE = 0x12345678;
+
+/// Exposes the bucket hash, so a test can aim packets at one bucket
+class TestPacketHistory : public PacketHistory
+{
+  public:
+    using PacketHistory::bucketOf;
+};
+
+static TestPacketHistory *history;
+
+static meshtastic_MeshPacket makePacket(PacketId id)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = REMOTE_NODE;
+    p.to = NODENUM_BROADCAST;
+    p.id = id;
+    return p;
+}
+
+static bool seen(PacketId id)
+{
+    meshtastic_MeshPacket p = makePacket(id);
+    return history->wasSeenRecently(&p, false);
+}
+
+void setUp(void)
+{
+    history = new TestPacketHistory();
+}
+
+void tearDown(void)
+{
+    delete history;
+}
+
+void test_RemembersPackets(void)
+{
+    meshtastic_MeshPacket p = makePacket(1);
+    TEST_ASSERT_FALSE(history->wasSeenRecently(&p));
+    TEST_ASSERT_TRUE(history->wasSeenRecently(&p));
+    TEST_ASSERT_EQUAL(1, history->getOccupancy());
+    TEST_ASSERT_EQUAL(1, history->getStats().inserts);
+    TEST_ASSERT_EQUAL(1, history->getStats().hits);
+}
+
+void test_FullBucketEvictsOldest(void)
+{
+    // Find one more id than a bucket holds, all landing in the same bucket
+    PacketId ids[PACKET_HISTORY_WAYS + 1];
+    uint32_t bucket = TestPacketHistory::bucketOf(REMOTE_NODE, 1);
+    size_t found = 0;
+    for (PacketId id = 1; found < PACKET_HISTORY_WAYS + 1; id++)
+        if (TestPacketHistory::bucketOf(REMOTE_NODE, id) == bucket)
+            ids[found++] = id;
+
+    for (size_t i = 0; i < PACKET_HISTORY_WAYS; i++) {
+        meshtastic_MeshPacket p = makePacket(ids[i]);
+        TEST_ASSERT_FALSE(history->wasSeenRecently(&p));
+    }
+    TEST_ASSERT_EQUAL(0, history->getStats().evictedLive);
+
+    meshtastic_MeshPacket p = makePacket(ids[PACKET_HISTORY_WAYS]);
+    TEST_ASSERT_FALSE(history->wasSeenRecently(&p));
+    TEST_ASSERT_EQUAL(1, history->getStats().evictedLive);
+    TEST_ASSERT_EQUAL(PACKET_HISTORY_WAYS, history->getOccupancy());
+
+    // The oldest is forgotten while still live: a duplicate of it would now get through
+    TEST_ASSERT_FALSE(seen(ids[0]));
+    for (size_t i = 1; i <= PACKET_HISTORY_WAYS; i++)
+        TEST_ASSERT_TRUE(seen(ids[i]));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_RemembersPackets);
+    RUN_TEST(test_FullBucketEvictsOldest);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
@@ -0,0 +1,206 @@
+#include "FSCommon.h"
+#include "MeshPacketQueue.h"
+#include "NodeDB.h"
+
+#include "TestUtil.h"
+#include <algorithm>
+#include <random>
+#include <unity.h>
+#include <vector>
+
+/**
+ * The sorted std::vector queue MeshPacketQueue used to be, kept here so the benchmark can compare against it.
+ */
+class LegacyVectorQueue
+{
+    size_t maxLen;
+    std::vector<meshtastic_MeshPacket *> queue;
+
+    static bool compare(const meshtastic_MeshPacket *p1, const meshtastic_MeshPacket *p2)
+    {
+        if ((bool)p1->tx_after != (bool)p2->tx_after) {
+            return !p1->tx_after;
+        }
+        return (p1->priority != p2->priority) ? (p1->priority > p2->priority) : (!isFromUs(p1) && isFromUs(p2));
+    }
+
+  public:
+    explicit LegacyVectorQueue(size_t _maxLen) : maxLen(_maxLen) {}
+
+    bool enqueue(meshtastic_MeshPacket *p)
+    {
+        if (queue.size() >= maxLen)
+            return false;
+        queue.insert(std::upper_bound(queue.begin(), queue.end(), p, compare), p);
+        return true;
+    }
+
+    meshtastic_MeshPacket *dequeue()
+    {
+        if (queue.empty())
+            return NULL;
+        auto *p = queue.front();
+        queue.erase(queue.begin());
+        return p;
+    }
+
+    meshtastic_MeshPacket *remove(NodeNum from, PacketId id)
+    {
+        for (auto it = queue.begin(); it != queue.end(); it++) {
+            auto p = (*it);
+            if (getFrom(p) == from && p->id == id) {
+                queue.erase(it);
+                return p;
+            }
+        }
+        return NULL;
+    }
+};
+
+static meshtastic_MeshPacket makePacket(NodeNum from, PacketId id, meshtastic_MeshPacket_Priority priority, uint32_t txAfter = 0)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = from;
+    p.id = id;
+    p.priority = priority;
+    p.tx_after = txAfter;
+    return p;
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_PriorityOrder(void)
+{
+    MeshPacketQueue q(8);
+    auto bg = makePacket(0x100, 1, meshtastic_MeshPacket_Priority_BACKGROUND);
+    auto ack = makePacket(0x100, 2, meshtastic_MeshPacket_Priority_ACK);
+    auto def = makePacket(0x100, 3, meshtastic_MeshPacket_Priority_DEFAULT);
+    auto lateAck = makePacket(0x100, 4, meshtastic_MeshPacket_Priority_ACK, 1000);
+
+    TEST_ASSERT_TRUE(q.enqueue(&lateAck));
+    TEST_ASSERT_TRUE(q.enqueue(&bg));
+    TEST_ASSERT_TRUE(q.enqueue(&def));
+    TEST_ASSERT_TRUE(q.enqueue(&ack));
+
+    TEST_ASSERT_EQUAL_PTR(&ack, q.dequeue());
+    TEST_ASSERT_EQUAL_PTR(&def, q.dequeue());
+    TEST_ASSERT_EQUAL_PTR(&bg, q.dequeue());
+    TEST_ASSERT_EQUAL_PTR(&lateAck, q.dequeue()); // late window always goes last
+    TEST_ASSERT_NULL(q.dequeue());
+}
+
+void test_FifoWithinPriority(void)
+{
+    MeshPacketQueue q(32);
+    meshtastic_MeshPacket packets[32];
+    for (int i = 0; i < 32; i++) {
+        packets[i] = makePacket(0x100 + i, i + 1, meshtastic_MeshPacket_Priority_DEFAULT);
+        TEST_ASSERT_TRUE(q.enqueue(&packets[i]));
+    }
+    TEST_ASSERT_EQUAL(0, q.getFree());
+    for (int i = 0; i < 32; i++)
+        TEST_ASSERT_EQUAL_PTR(&packets[i], q.dequeue());
+}
+
+void test_RemoveByFromAndId(void)
+{
+    MeshPacketQueue q(8);
+    auto a = makePacket(0x100, 1, meshtastic_MeshPacket_Priority_DEFAULT);
+    auto b = makePacket(0x200, 1, meshtastic_MeshPacket_Priority_DEFAULT);
+    auto c = makePacket(0x100, 2, meshtastic_MeshPacket_Priority_DEFAULT, 1000);
+    q.enqueue(&a);
+    q.enqueue(&b);
+    q.enqueue(&c);
+
+    TEST_ASSERT_NULL(q.remove(0x300, 1));
+    TEST_ASSERT_NULL(q.remove(0x100, 2, true, false)); // c is late, so not found when only asking for normal packets
+    TEST_ASSERT_EQUAL_PTR(&a, q.remove(0x100, 1));
+    TEST_ASSERT_EQUAL_PTR(&c, q.remove(0x100, 2, false, true));
+    TEST_ASSERT_EQUAL_PTR(&b, q.getFront());
+    TEST_ASSERT_EQUAL(7, q.getFree());
+}
+
+void test_ReplaceLowerPriorityWhenFull(void)
+{
+    MeshPacketQueue q(2);
+    // The packet being replaced is released to the pool, so it must come from there
+    auto *low = packetPool.allocCopy(makePacket(0x100, 1, meshtastic_MeshPacket_Priority_BACKGROUND));
+    auto late = makePacket(0x100, 2, meshtastic_MeshPacket_Priority_DEFAULT, 1000);
+    auto *high = packetPool.allocCopy(makePacket(0x100, 3, meshtastic_MeshPacket_Priority_HIGH));
+    auto lowest = makePacket(0x100, 4, meshtastic_MeshPacket_Priority_MIN);
+
+    q.enqueue(low);
+    q.enqueue(&late);
+    TEST_ASSERT_FALSE(q.enqueue(&lowest)); // nothing lower than MIN to replace
+    TEST_ASSERT_TRUE(q.enqueue(high));     // replaces low, not the late packet
+    TEST_ASSERT_EQUAL_PTR(high, q.dequeue());
+    TEST_ASSERT_EQUAL_PTR(&late, q.dequeue());
+    packetPool.release(high);
+}
+
+/// Fill a queue to size, then time steady state dequeue+enqueue and cancel+enqueue cycles
+template <class Q> static void benchQueue(const char *name, size_t size)
+{
+    const uint32_t iterations = 20000;
+    std::mt19937 rng(size);
+    std::vector<meshtastic_MeshPacket> packets(size + iterations);
+    for (size_t i = 0; i < packets.size(); i++)
+        packets[i] = makePacket(0x100 + (rng() % 64), i + 1, (meshtastic_MeshPacket_Priority)(rng() % 128),
+                                rng() % 8 == 0 ? 1000 : 0);
+
+    Q q(size);
+    size_t next = 0;
+    while (next < size)
+        q.enqueue(&packets[next++]);
+
+    long ns = timeBench(iterations, [&](uint32_t) {
+        q.dequeue();
+        q.enqueue(&packets[next++]);
+    });
+    printBenchResult("txqueue_dequeue_enqueue", name, size, iterations, ns);
+
+    ns = timeBench(iterations, [&](uint32_t) {
+        auto &victim = packets[next - 1 - (rng() % size)];
+        if (q.remove(getFrom(&victim), victim.id))
+            q.enqueue(&victim);
+    });
+    printBenchResult("txqueue_cancel", name, size, iterations, ns);
+}
+
+void test_Benchmark(void)
+{
+    for (size_t size = 16; size <= 512; size *= 2) {
+        benchQueue<LegacyVectorQueue>("vector", size);
+        benchQueue<MeshPacketQueue>("heap", size);
+    }
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB; // isFromUs() needs our node number
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_PriorityOrder);
+    RUN_TEST(test_FifoWithinPriority);
+    RUN_TEST(test_RemoveByFromAndId);
+    RUN_TEST(test_ReplaceLowerPriorityWhenFull);
+    RUN_TEST(test_Benchmark);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
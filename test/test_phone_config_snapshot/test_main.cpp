@@ -0,0 +1,150 @@
+#include "FSCommon.h"
+#include "NodeDB.h"
+#include "PhoneConfigSnapshot.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+static const NodeNum REMOTE_NODE = 0x12345678;
+static const uint8_t FIRST_CONFIG = _meshtastic_AdminMessage_ConfigType_MIN + 1;
+static const uint8_t LAST_CONFIG = _meshtastic_AdminMessage_ConfigType_MAX + 1;
+static const uint8_t FIRST_MODULE_CONFIG = _meshtastic_AdminMessage_ModuleConfigType_MIN + 1;
+static const uint8_t LAST_MODULE_CONFIG = _meshtastic_AdminMessage_ModuleConfigType_MAX + 1;
+
+static PhoneConfigSnapshot *snapshot;
+static uint8_t buf[meshtastic_FromRadio_size], fresh[meshtastic_FromRadio_size];
+
+typedef void (*FillFn)(meshtastic_FromRadio &f, uint8_t index);
+
+/// Encode a frame from scratch, the way PhoneAPI did before the snapshot
+static size_t encodeFresh(FillFn fill, uint8_t index)
+{
+    meshtastic_FromRadio f = meshtastic_FromRadio_init_zero;
+    fill(f, index);
+    return pb_encode_to_bytes(fresh, sizeof(fresh), &meshtastic_FromRadio_msg, &f);
+}
+
+static void assertSameAsFresh(size_t len, FillFn fill, uint8_t index)
+{
+    TEST_ASSERT_EQUAL(encodeFresh(fill, index), len);
+    TEST_ASSERT_EQUAL_MEMORY(fresh, buf, len);
+}
+
+/// Walk the whole handshake once, the way a (re)connecting client would
+static void readAll()
+{
+    for (uint8_t i = 0; i < MAX_NUM_CHANNELS; i++)
+        snapshot->getChannel(i, buf);
+    for (uint8_t t = FIRST_CONFIG; t <= LAST_CONFIG; t++)
+        snapshot->getConfig(t, buf);
+    for (uint8_t t = FIRST_MODULE_CONFIG; t <= LAST_MODULE_CONFIG; t++)
+        snapshot->getModuleConfig(t, buf);
+    uint32_t readIndex = 0, index = 0;
+    while (const meshtastic_NodeInfoLite *node = nodeDB->readNextMeshNode(readIndex)) {
+        snapshot->getNodeInfo(index, node, buf);
+        index = readIndex;
+    }
+}
+
+void setUp(void)
+{
+    nodeDB->resetNodes();
+    for (NodeNum i = 1; i <= 3; i++)
+        hearTestNode(REMOTE_NODE + i, 1000 + i);
+    snapshot = new PhoneConfigSnapshot();
+}
+
+void tearDown(void)
+{
+    delete snapshot;
+    nodeDB->resetNodes();
+}
+
+void test_ReconnectGetsSameBytes(void)
+{
+    readAll();
+    uint32_t encoded = snapshot->getNumEncoded(), hits = snapshot->getNumHits();
+
+    // The second connection is served from the snapshot, byte for byte what a fresh encode gives
+    for (uint8_t i = 0; i < MAX_NUM_CHANNELS; i++)
+        assertSameAsFresh(snapshot->getChannel(i, buf), PhoneConfigSnapshot::fillChannel, i);
+    for (uint8_t t = FIRST_CONFIG; t <= LAST_CONFIG; t++)
+        assertSameAsFresh(snapshot->getConfig(t, buf), PhoneConfigSnapshot::fillConfig, t);
+    for (uint8_t t = FIRST_MODULE_CONFIG; t <= LAST_MODULE_CONFIG; t++)
+        assertSameAsFresh(snapshot->getModuleConfig(t, buf), PhoneConfigSnapshot::fillModuleConfig, t);
+
+    uint32_t readIndex = 0, index = 0;
+    while (const meshtastic_NodeInfoLite *node = nodeDB->readNextMeshNode(readIndex)) {
+        size_t len = snapshot->getNodeInfo(index, node, buf);
+        meshtastic_FromRadio f = meshtastic_FromRadio_init_zero;
+        PhoneConfigSnapshot::fillNodeInfo(f, node);
+        TEST_ASSERT_EQUAL(pb_encode_to_bytes(fresh, sizeof(fresh), &meshtastic_FromRadio_msg, &f), len);
+        TEST_ASSERT_EQUAL_MEMORY(fresh, buf, len);
+        index = readIndex;
+    }
+
+    TEST_ASSERT_EQUAL(encoded, snapshot->getNumEncoded());
+    TEST_ASSERT_GREATER_THAN(hits, snapshot->getNumHits());
+}
+
+void test_ConfigWriteRebuildsOnlyConfig(void)
+{
+    readAll();
+    uint32_t version = snapshot->getVersion(), encoded = snapshot->getNumEncoded();
+
+    config.lora.hop_limit = config.lora.hop_limit == 3 ? 4 : 3;
+    readAll();
+    TEST_ASSERT_EQUAL(version + 1, snapshot->getVersion());
+    TEST_ASSERT_EQUAL(encoded + LAST_CONFIG - FIRST_CONFIG + 1, snapshot->getNumEncoded());
+    assertSameAsFresh(snapshot->getConfig(meshtastic_Config_lora_tag, buf), PhoneConfigSnapshot::fillConfig,
+                      meshtastic_Config_lora_tag);
+}
+
+void test_ChannelWriteRebuildsOnlyChannels(void)
+{
+    readAll();
+    uint32_t version = snapshot->getVersion(), encoded = snapshot->getNumEncoded();
+
+    channelFile.channels[1].settings.name[0] = channelFile.channels[1].settings.name[0] == 'x' ? 'y' : 'x';
+    readAll();
+    TEST_ASSERT_EQUAL(version + 1, snapshot->getVersion());
+    TEST_ASSERT_EQUAL(encoded + MAX_NUM_CHANNELS, snapshot->getNumEncoded());
+    assertSameAsFresh(snapshot->getChannel(1, buf), PhoneConfigSnapshot::fillChannel, 1);
+}
+
+void test_NodeWriteRebuildsOnlyThatNode(void)
+{
+    readAll();
+    uint32_t version = snapshot->getVersion(), encoded = snapshot->getNumEncoded();
+
+    nodeDB->getMeshNode(REMOTE_NODE + 2)->snr += 1;
+    readAll();
+    TEST_ASSERT_EQUAL(version + 1, snapshot->getVersion());
+    TEST_ASSERT_EQUAL(encoded + 1, snapshot->getNumEncoded());
+
+    // And nothing at all when nothing changed
+    readAll();
+    TEST_ASSERT_EQUAL(version + 1, snapshot->getVersion());
+    TEST_ASSERT_EQUAL(encoded + 1, snapshot->getNumEncoded());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+    nodeDB = new NodeDB; // also loads the config and channels we snapshot
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_ReconnectGetsSameBytes);
+    RUN_TEST(test_ConfigWriteRebuildsOnlyConfig);
+    RUN_TEST(test_ChannelWriteRebuildsOnlyChannels);
+    RUN_TEST(test_NodeWriteRebuildsOnlyThatNode);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
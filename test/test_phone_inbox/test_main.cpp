@@ -0,0 +1,167 @@
+#include "FSCommon.h"
+#include "PhoneInbox.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+static PhoneInbox *inbox;
+static uint8_t buf[meshtastic_FromRadio_size];
+
+static meshtastic_MeshPacket makePacket(PacketId id, size_t payloadLen,
+                                        meshtastic_PortNum portnum = meshtastic_PortNum_TEXT_MESSAGE_APP)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = 0x1234;
+    p.to = 0x5678 + id;
+    p.id = id;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.decoded.portnum = portnum;
+    p.decoded.payload.size = payloadLen;
+    memset(p.decoded.payload.bytes, 'a' + id % 26, payloadLen);
+    return p;
+}
+
+/// Pop the next frame and return the id of the packet in it, 0 if there was none
+static PacketId popId()
+{
+    size_t len = inbox->pop(buf);
+    if (!len)
+        return 0;
+    meshtastic_FromRadio fr = meshtastic_FromRadio_init_zero;
+    TEST_ASSERT_TRUE(pb_decode_from_bytes(buf, len, &meshtastic_FromRadio_msg, &fr));
+    TEST_ASSERT_EQUAL(meshtastic_FromRadio_packet_tag, fr.which_payload_variant);
+    return fr.packet.id;
+}
+
+void setUp(void)
+{
+    inbox = new PhoneInbox();
+}
+
+void tearDown(void)
+{
+    delete inbox;
+}
+
+void test_DeliversInOrder(void)
+{
+    TEST_ASSERT_TRUE(inbox->isEmpty());
+    for (PacketId id = 1; id <= 5; id++)
+        inbox->push(makePacket(id, 10 * id));
+    TEST_ASSERT_EQUAL(5, inbox->numWaiting());
+
+    for (PacketId id = 1; id <= 5; id++)
+        TEST_ASSERT_EQUAL(id, popId());
+    TEST_ASSERT_EQUAL(0, popId());
+    TEST_ASSERT_TRUE(inbox->isEmpty());
+}
+
+void test_SmallPacketsTakeLittleRam(void)
+{
+    // The old queue held MAX_RX_TOPHONE whole MeshPackets
+    uint32_t fits = PHONE_INBOX_BYTES / 48;
+    for (PacketId id = 1; id <= fits; id++)
+        inbox->push(makePacket(id, 10));
+    TEST_ASSERT_GREATER_THAN(MAX_RX_TOPHONE, fits);
+    TEST_ASSERT_EQUAL(0, inbox->getStats().spilled);
+    TEST_ASSERT_EQUAL(0, inbox->getStats().dropped);
+}
+
+void test_FindDest(void)
+{
+    inbox->push(makePacket(7, 10));
+    inbox->push(makePacket(8, 10));
+    TEST_ASSERT_EQUAL(0x5678 + 8, inbox->findDest(8));
+    TEST_ASSERT_EQUAL(0, inbox->findDest(9));
+}
+
+void test_OverflowKeepsOrder(void)
+{
+    // Several times what fits in RAM
+    PacketId last = 4 * PHONE_INBOX_BYTES / 200;
+    for (PacketId id = 1; id <= last; id++)
+        inbox->push(makePacket(id, 150));
+
+    const PhoneInboxStats &stats = inbox->getStats();
+    TEST_ASSERT_EQUAL(last, stats.queued);
+    TEST_ASSERT_EQUAL(last, inbox->numWaiting() + stats.dropped);
+
+#if PHONE_INBOX_SPILL_BYTES
+    // Nothing lost, the oldest come back from flash first
+    uint32_t onFlash;
+    TEST_ASSERT_EQUAL(last, inbox->numWaiting(&onFlash));
+    TEST_ASSERT_EQUAL(stats.spilled, onFlash);
+    TEST_ASSERT_GREATER_THAN(0, onFlash);
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+    for (PacketId id = 1; id <= last; id++)
+        TEST_ASSERT_EQUAL(id, popId());
+#else
+    // The newest are kept
+    TEST_ASSERT_GREATER_THAN(0, stats.dropped);
+    PacketId id = popId();
+    TEST_ASSERT_EQUAL(stats.dropped + 1, id);
+    while (PacketId next = popId())
+        TEST_ASSERT_EQUAL(++id, next);
+    TEST_ASSERT_EQUAL(last, id);
+#endif
+    TEST_ASSERT_TRUE(inbox->isEmpty());
+}
+
+void test_TextsArePreferred(void)
+{
+    const PhoneInboxStats &stats = inbox->getStats();
+    static const PacketId FIRST_TEXT = 1000000;
+
+    // Fill RAM and flash with positions, until one is turned away
+    PacketId lastPosition = 0;
+    while (stats.dropped == 0)
+        inbox->push(makePacket(++lastPosition, 150, meshtastic_PortNum_POSITION_APP));
+    uint32_t onFlash, waiting = inbox->numWaiting(&onFlash);
+    uint32_t inRam = waiting - onFlash;
+    TEST_ASSERT_GREATER_THAN(2, inRam);
+
+    // A text gets in, in place of the oldest position in RAM, and another position still doesn't
+    inbox->push(makePacket(FIRST_TEXT, 150));
+    TEST_ASSERT_EQUAL(2, stats.dropped);
+    inbox->push(makePacket(++lastPosition, 150, meshtastic_PortNum_POSITION_APP));
+    TEST_ASSERT_EQUAL(3, stats.dropped);
+    TEST_ASSERT_EQUAL(waiting, inbox->numWaiting());
+
+    // Once RAM holds only texts, a new text pushes out the oldest text
+    for (PacketId id = FIRST_TEXT + 1; id <= FIRST_TEXT + inRam; id++)
+        inbox->push(makePacket(id, 150, meshtastic_PortNum_RANGE_TEST_APP));
+    TEST_ASSERT_EQUAL(3 + inRam, stats.dropped);
+    inbox->push(makePacket(lastPosition + 1, 150, meshtastic_PortNum_POSITION_APP));
+    TEST_ASSERT_EQUAL(4 + inRam, stats.dropped);
+
+    // The positions that were spilled, then every text but the first
+    PacketId id;
+    for (uint32_t i = 0; i < onFlash; i++) {
+        id = popId();
+        TEST_ASSERT_LESS_THAN(FIRST_TEXT, id);
+    }
+    for (id = FIRST_TEXT + 1; id <= FIRST_TEXT + inRam; id++)
+        TEST_ASSERT_EQUAL(id, popId());
+    TEST_ASSERT_TRUE(inbox->isEmpty());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+    fsInit();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_DeliversInOrder);
+    RUN_TEST(test_SmallPacketsTakeLittleRam);
+    RUN_TEST(test_FindDest);
+    RUN_TEST(test_OverflowKeepsOrder);
+    RUN_TEST(test_TextsArePreferred);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
@@ -0,0 +1,132 @@
+#include "modules/Telemetry/TelemetrySensorRegistry.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+
+// Sensor/ isn't built for native, so the base class's only out of line virtual has to come from here
+void TelemetrySensor::setup() {}
+
+static int numCreated;
+
+/// Sets a temperature, takes readMs and fails if told to
+class FakeSensor : public TelemetrySensor
+{
+  public:
+    uint32_t readMs = 0;
+    bool fail = false;
+
+    explicit FakeSensor(meshtastic_TelemetrySensorType type) : TelemetrySensor(type, "Fake") { numCreated++; }
+
+    virtual int32_t runOnce() override { return DEFAULT_SENSOR_MINIMUM_WAIT_TIME_BETWEEN_READS; }
+
+    virtual bool getMetrics(meshtastic_Telemetry *measurement) override
+    {
+        delay(readMs);
+        measurement->variant.environment_metrics.has_temperature = true;
+        measurement->variant.environment_metrics.temperature = sensorType;
+        return !fail;
+    }
+
+  protected:
+    virtual void setup() override {}
+};
+
+static const TelemetrySensorFactory table[] = {
+    {meshtastic_TelemetrySensorType_SHT4X,
+     []() -> TelemetrySensor * { return new FakeSensor(meshtastic_TelemetrySensorType_SHT4X); }},
+    {meshtastic_TelemetrySensorType_BME680,
+     []() -> TelemetrySensor * { return new FakeSensor(meshtastic_TelemetrySensorType_BME680); }},
+    {meshtastic_TelemetrySensorType_BMP280,
+     []() -> TelemetrySensor * { return new FakeSensor(meshtastic_TelemetrySensorType_BMP280); }},
+};
+static const size_t tableSize = sizeof(table) / sizeof(table[0]);
+
+static void detect(meshtastic_TelemetrySensorType type)
+{
+    nodeTelemetrySensorsMap[type].first = 0x44;
+}
+
+void setUp(void)
+{
+    for (auto &entry : nodeTelemetrySensorsMap)
+        entry = {0, NULL};
+    numCreated = 0;
+}
+
+void tearDown(void) {}
+
+void test_OnlyDetectedSensorsAreCreated(void)
+{
+    TelemetrySensorRegistry sensors;
+    sensors.probe(table, tableSize);
+    TEST_ASSERT_EQUAL(0, sensors.size());
+    TEST_ASSERT_EQUAL(0, numCreated);
+
+    detect(meshtastic_TelemetrySensorType_BMP280);
+    detect(meshtastic_TelemetrySensorType_SHT4X);
+    detect(meshtastic_TelemetrySensorType_SHTC3); // not in our table
+    sensors.probe(table, tableSize);
+    TEST_ASSERT_EQUAL(2, sensors.size());
+    TEST_ASSERT_EQUAL(2, numCreated);
+
+    // In table order, not detection order
+    TEST_ASSERT_EQUAL(meshtastic_TelemetrySensorType_SHT4X, sensors.at(0)->getType());
+    TEST_ASSERT_EQUAL(meshtastic_TelemetrySensorType_BMP280, sensors.at(1)->getType());
+    TEST_ASSERT_NOT_NULL(sensors.find(meshtastic_TelemetrySensorType_BMP280));
+    TEST_ASSERT_NULL(sensors.find(meshtastic_TelemetrySensorType_BME680));
+}
+
+void test_ProbeTwiceDoesNotDuplicate(void)
+{
+    TelemetrySensorRegistry sensors;
+    detect(meshtastic_TelemetrySensorType_BME680);
+    sensors.probe(table, tableSize);
+    sensors.probe(table, tableSize);
+    TEST_ASSERT_EQUAL(1, sensors.size());
+    TEST_ASSERT_EQUAL(1, numCreated);
+}
+
+void test_ReadsAreTimed(void)
+{
+    TelemetrySensorRegistry sensors;
+    detect(meshtastic_TelemetrySensorType_SHT4X);
+    detect(meshtastic_TelemetrySensorType_BME680);
+    sensors.probe(table, tableSize);
+
+    FakeSensor *slow = static_cast<FakeSensor *>(sensors.at(1));
+    slow->readMs = 5;
+
+    meshtastic_Telemetry m = meshtastic_Telemetry_init_zero;
+    TEST_ASSERT_TRUE(sensors.read(0, &m));
+    TEST_ASSERT_TRUE(sensors.read(1, &m));
+    TEST_ASSERT_EQUAL(meshtastic_TelemetrySensorType_BME680, (int)m.variant.environment_metrics.temperature);
+
+    slow->fail = true;
+    TEST_ASSERT_FALSE(sensors.read(1, &m));
+
+    const TelemetrySensorStats &stats = sensors.getStats(1);
+    TEST_ASSERT_EQUAL(2, stats.reads);
+    TEST_ASSERT_EQUAL(1, stats.failures);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, stats.maxUs);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, stats.lastUs);
+    TEST_ASSERT_EQUAL(1, sensors.getStats(0).reads);
+    TEST_ASSERT_LESS_THAN(5000, sensors.getStats(0).maxUs);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_OnlyDetectedSensorsAreCreated);
+    RUN_TEST(test_ProbeTwiceDoesNotDuplicate);
+    RUN_TEST(test_ReadsAreTimed);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}
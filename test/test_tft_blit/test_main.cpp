@@ -0,0 +1,107 @@
+#include "graphics/TFTBlit.h"
+
+#include "TestUtil.h"
+#include <unity.h>
+#include <vector>
+
+static const uint16_t WIDTH = 30; // deliberately not a multiple of the word size
+static const uint16_t GAP = 4;
+
+static uint8_t cur[WIDTH], back[WIDTH];
+
+struct Span {
+    uint16_t x0, x1;
+};
+
+static std::vector<Span> spans()
+{
+    std::vector<Span> found;
+    forEachChangedSpan(cur, back, WIDTH, GAP, [&](uint16_t x0, uint16_t x1) { found.push_back({x0, x1}); });
+    return found;
+}
+
+static void assertSpan(const Span &s, uint16_t x0, uint16_t x1)
+{
+    TEST_ASSERT_EQUAL(x0, s.x0);
+    TEST_ASSERT_EQUAL(x1, s.x1);
+}
+
+void setUp(void)
+{
+    for (uint16_t x = 0; x < WIDTH; x++)
+        cur[x] = back[x] = x * 7;
+}
+
+void tearDown(void) {}
+
+void test_UnchangedPageHasNoSpans(void)
+{
+    TEST_ASSERT_EQUAL(0, spans().size());
+}
+
+void test_SingleColumn(void)
+{
+    cur[5] ^= 0x10; // one pixel, in the middle of a word
+    std::vector<Span> s = spans();
+    TEST_ASSERT_EQUAL(1, s.size());
+    assertSpan(s[0], 5, 6);
+}
+
+void test_NearbyRunsAreMerged(void)
+{
+    cur[2] ^= 1;
+    cur[2 + GAP + 1] ^= 1; // exactly GAP unchanged columns in between
+    std::vector<Span> s = spans();
+    TEST_ASSERT_EQUAL(1, s.size());
+    assertSpan(s[0], 2, 2 + GAP + 2);
+}
+
+void test_DistantRunsAreSeparate(void)
+{
+    cur[2] ^= 1;
+    cur[3] ^= 1;
+    cur[3 + GAP + 2] ^= 1; // one unchanged column too many
+    std::vector<Span> s = spans();
+    TEST_ASSERT_EQUAL(2, s.size());
+    assertSpan(s[0], 2, 4);
+    assertSpan(s[1], 3 + GAP + 2, 3 + GAP + 3);
+}
+
+void test_ChangesInTheTail(void)
+{
+    // The last WIDTH % 4 columns are past the final whole word
+    cur[WIDTH - 1] ^= 0x80;
+    std::vector<Span> s = spans();
+    TEST_ASSERT_EQUAL(1, s.size());
+    assertSpan(s[0], WIDTH - 1, WIDTH);
+}
+
+void test_WholePage(void)
+{
+    for (uint16_t x = 0; x < WIDTH; x++)
+        cur[x] = ~back[x];
+    std::vector<Span> s = spans();
+    TEST_ASSERT_EQUAL(1, s.size());
+    assertSpan(s[0], 0, WIDTH);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    initializeTestEnvironment();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_UnchangedPageHasNoSpans);
+    RUN_TEST(test_SingleColumn);
+    RUN_TEST(test_NearbyRunsAreMerged);
+    RUN_TEST(test_DistantRunsAreSeparate);
+    RUN_TEST(test_ChangesInTheTail);
+    RUN_TEST(test_WholePage);
+    exit(UNITY_END()); // stop unit testing
+}
+
+void loop() {}